@@ -0,0 +1,15 @@
+#ifndef APP_H
+#define APP_H
+
+#include <stdbool.h>
+#include "debounce.h"
+
+// Application entry points shared by the bare-metal event loop (main.c) and
+// the FreeRTOS build (rtos_main.c)
+
+void app_init(button_handler_t handler); // Button, LoRa modules and uplink queue
+void start_probes(); // Start the identity probe on every idle module
+bool poll_modems(void *ctx); // Advance the module probes, true while a probe is in progress
+void on_idle(void *ctx); // Background work while no module is being talked to
+
+#endif
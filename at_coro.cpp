@@ -0,0 +1,172 @@
+#include "at_coro.hpp"
+#include "at_coro.h"
+#include <cstdio>
+#include <cstring>
+
+extern "C" void convert_and_print(const char *line); // main.c
+
+namespace at {
+
+// Static frame pool, coroutines never touch the heap
+alignas(8) static unsigned char frames[frame_count][frame_size];
+static bool frame_used[frame_count];
+static frame_stats frame_info;
+
+const frame_stats &stats() {
+    return frame_info;
+}
+
+void *task::promise_type::operator new(const std::size_t size) noexcept {
+    if (size > frame_info.largest)
+        frame_info.largest = size;
+    if (size <= frame_size) {
+        for (int i = 0; i < frame_count; i++) {
+            if (!frame_used[i]) {
+                frame_used[i] = true;
+                if (++frame_info.in_use > frame_info.high_water)
+                    frame_info.high_water = frame_info.in_use;
+                return frames[i];
+            }
+        }
+    }
+    frame_info.failures++;
+    return nullptr; // Coroutine is not started, task::valid() is false
+}
+
+void task::promise_type::operator delete(void *frame) noexcept {
+    const int i = static_cast<int>((static_cast<unsigned char *>(frame) - &frames[0][0]) / frame_size);
+    frame_used[i] = false;
+    frame_info.in_use--;
+}
+
+task &task::operator=(task &&other) noexcept {
+    if (this != &other) {
+        if (h_)
+            h_.destroy();
+        h_ = other.h_;
+        other.h_ = nullptr;
+    }
+    return *this;
+}
+
+task::~task() {
+    if (h_)
+        h_.destroy();
+}
+
+void channel::begin(const std::coroutine_handle<> h, const char *cmd, const uint32_t timeout_ms) {
+    waiter_ = h;
+    line_ = nullptr;
+    deadline_ms_ = to_ms_since_boot(get_absolute_time()) + timeout_ms;
+    modem_write_str(m_, cmd);
+}
+
+void channel::drain() {
+    while (modem_poll_line(m_)) {
+        if (unsolicited_ != nullptr)
+            unsolicited_(m_);
+    }
+}
+
+bool channel::poll(const uint32_t now_ms) {
+    if (!waiter_) {
+        drain();
+        return false;
+    }
+    if (modem_poll_line(m_))
+        line_ = m_->line;
+    else if (static_cast<int32_t>(now_ms - deadline_ms_) < 0)
+        return true; // Keep waiting
+    // Clear the waiter first, the coroutine may send its next command right away
+    const std::coroutine_handle<> h = waiter_;
+    waiter_ = nullptr;
+    h.resume();
+    return static_cast<bool>(waiter_);
+}
+
+task identity(channel &at) {
+    // 1. Check AT connectivity, up to PROBE_AT_ATTEMPTS tries
+    const char *line = nullptr;
+    for (int i = 0; i < PROBE_AT_ATTEMPTS; i++) {
+        line = co_await at.send("AT\r\n");
+        if (line != nullptr && std::strstr(line, "OK") != nullptr)
+            break;
+        line = nullptr;
+    }
+    if (line == nullptr) {
+        std::printf("Module not responding\r\n");
+        co_return false;
+    }
+    std::printf("Connected to LoRa module\r\n");
+
+    // 2. Read firmware version
+    line = co_await at.send("AT+VER\r\n");
+    if (line == nullptr || std::strstr(line, "VER") == nullptr) {
+        std::printf("Module not responding\r\n");
+        co_return false;
+    }
+    std::printf("%s\r\n", line);
+
+    // 3. Read and process DevEui
+    line = co_await at.send("AT+ID=DevEui\r\n");
+    if (line == nullptr || std::strstr(line, "DevEui") == nullptr) {
+        std::printf("Module not responding\r\n");
+        co_return false;
+    }
+    std::printf("%s\r\n", line);
+    convert_and_print(line);
+    co_return true;
+}
+
+} // namespace at
+
+// C interface used by main.c
+static modem_t *coro_modem = nullptr;
+static at::channel *coro_channel = nullptr;
+static at::task coro_task;
+
+extern "C" void at_coro_init(modem_t *m, const at_coro_line_handler_t unsolicited) {
+    static at::channel channel(m, unsolicited);
+    coro_modem = m;
+    coro_channel = &channel;
+}
+
+// The flow ended (or never started): the module goes back to the event loop
+static void release() {
+    coro_task = at::task(); // Release the frame
+    coro_modem->claimed = false;
+}
+
+extern "C" bool at_coro_start(void) {
+    // A probe, an uplink or the recovery has the module, or the flow already runs
+    if (coro_modem->claimed || modem_busy(coro_modem))
+        return false;
+    // Unsolicited lines are not dispatched while the layer owns the module
+    coro_modem->claimed = true;
+    // Lines the module sent before the flow are not answers to it
+    coro_channel->drain();
+    coro_task = at::identity(*coro_channel);
+    if (!coro_task.valid()) {
+        release(); // No frame slot
+        return false;
+    }
+    return true;
+}
+
+extern "C" bool at_coro_poll(void *ctx) {
+    (void)ctx;
+    if (!coro_task.valid())
+        return false; // Idle, the module is not ours
+    const bool busy = coro_channel->poll(to_ms_since_boot(get_absolute_time()));
+    if (coro_task.done()) {
+        release();
+        at_coro_report();
+    }
+    return busy;
+}
+
+extern "C" void at_coro_report(void) {
+    const at::frame_stats &s = at::stats();
+    std::printf("Coroutine frames: largest %u of %u bytes, %d/%d slots used at most, %u failed\r\n",
+        (unsigned)s.largest, (unsigned)at::frame_size, s.high_water, at::frame_count, s.failures);
+}
@@ -0,0 +1,28 @@
+#ifndef AT_CORO_H
+#define AT_CORO_H
+
+#include <stdbool.h>
+#include "modem.h"
+
+// C interface of the optional C++20 coroutine AT layer (LORA_COROUTINES).
+// The identity query runs as one coroutine that suspends at every command
+// until the response line or a timeout arrives. The module's lines belong to
+// the layer only while the flow runs; the rest of the time the event loop
+// dispatches them as usual.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*at_coro_line_handler_t)(modem_t *m); // Gets m->line
+
+void at_coro_init(modem_t *m, at_coro_line_handler_t unsolicited); // Module of the flow, where lines no command waits for go
+bool at_coro_start(void); // Claim the module and start the identity flow, false if running or the module is busy
+bool at_coro_poll(void *ctx); // Reactor poller: resumes the flow when its response is in
+void at_coro_report(void); // Print coroutine frame size statistics
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef AT_CORO_HPP
+#define AT_CORO_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include "modem.h"
+
+// C++20 coroutines for AT transactions: `co_await at.send("AT+VER\r\n")`
+// suspends until the module answers or the timeout expires. Frames come
+// from a static pool instead of the heap and the coroutines are resumed
+// from the event loop, so multi-step flows read linearly without blocking.
+
+namespace at {
+
+constexpr std::size_t frame_size = 256; // Bytes per coroutine frame slot
+constexpr int frame_count = 2; // Coroutines alive at the same time
+
+struct frame_stats {
+    std::size_t largest; // Largest frame requested by the compiler
+    int in_use;
+    int high_water;
+    unsigned failures; // Requests that did not fit in a slot or found none free
+};
+
+const frame_stats &stats();
+
+// Coroutine returning a success flag. The frame stays alive after completion
+// until the task object is destroyed, so the result can be read.
+class task {
+public:
+    struct promise_type {
+        static void *operator new(std::size_t size) noexcept;
+        static void operator delete(void *frame) noexcept;
+        static task get_return_object_on_allocation_failure() noexcept { return task(); }
+
+        task get_return_object() noexcept { return task(handle::from_promise(*this)); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(bool ok) noexcept { result = ok; }
+        void unhandled_exception() noexcept {} // Built without exceptions
+
+        bool result = false;
+    };
+    using handle = std::coroutine_handle<promise_type>;
+
+    task() = default;
+    explicit task(handle h) : h_(h) {}
+    task(task &&other) noexcept : h_(other.h_) { other.h_ = nullptr; }
+    task &operator=(task &&other) noexcept;
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+    ~task();
+
+    bool valid() const { return static_cast<bool>(h_); } // False if no frame was available
+    bool done() const { return h_ && h_.done(); }
+    bool result() const { return h_ && h_.promise().result; }
+
+private:
+    handle h_;
+};
+
+// Command/response channel on one module, at most one outstanding command.
+// Lines that arrive while no command waits are handed to unsolicited.
+class channel {
+public:
+    using line_handler = void (*)(modem_t *m);
+
+    channel(modem_t *m, line_handler unsolicited) : m_(m), unsolicited_(unsolicited) {}
+
+    struct response {
+        channel &ch;
+        const char *cmd;
+        uint32_t timeout_ms;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { ch.begin(h, cmd, timeout_ms); }
+        const char *await_resume() const noexcept { return ch.line_; } // nullptr on timeout
+    };
+
+    // Send cmd and suspend until a response line arrives; the line is valid until the next co_await
+    response send(const char *cmd, uint32_t timeout_ms = PROBE_TIMEOUT_MS) { return { *this, cmd, timeout_ms }; }
+
+    bool poll(uint32_t now_ms); // Resume the waiting coroutine if its line or timeout is in, true while waiting
+    void drain(); // Pass every complete line received so far to the unsolicited handler
+
+private:
+    void begin(std::coroutine_handle<> h, const char *cmd, uint32_t timeout_ms);
+
+    modem_t *m_;
+    line_handler unsolicited_;
+    std::coroutine_handle<> waiter_;
+    uint32_t deadline_ms_ = 0;
+    const char *line_ = nullptr;
+};
+
+task identity(channel &at); // AT -> AT+VER -> AT+ID=DevEui, printing like the probe engine
+
+} // namespace at
+
+#endif
@@ -0,0 +1,88 @@
+#include "bench.h"
+#include <stdio.h>
+
+void bench_run(const bench_config_t *config, const bench_case_t *c, bench_result_t *result) {
+    result->name = c->name;
+    result->bytes = c->bytes;
+    c->kernel(c->ctx, 1); // Warm up caches and lazily initialised state
+
+    // Double the iteration count until the run is long enough to measure
+    uint32_t iterations = 1;
+    while (true) {
+        const uint64_t start = config->clock();
+        c->kernel(c->ctx, iterations);
+        const uint64_t ticks = config->clock() - start;
+        if (ticks >= config->min_ticks || iterations >= BENCH_MAX_ITERATIONS) {
+            result->iterations = iterations;
+            result->ticks = ticks;
+            break;
+        }
+        iterations *= 2;
+    }
+    // Further runs of the same length, the fastest one counts
+    for (uint8_t i = 1; i < config->repeats; i++) {
+        const uint64_t start = config->clock();
+        c->kernel(c->ctx, iterations);
+        const uint64_t ticks = config->clock() - start;
+        if (ticks < result->ticks)
+            result->ticks = ticks;
+    }
+}
+
+void bench_run_all(const bench_config_t *config, const bench_case_t *cases, const size_t count,
+    bench_result_t *results) {
+    for (size_t i = 0; i < count; i++)
+        bench_run(config, &cases[i], &results[i]);
+}
+
+uint64_t bench_ticks_per_iter_x10(const bench_result_t *r) {
+    return r->ticks * 10 / r->iterations;
+}
+
+uint64_t bench_ns_per_iter_x10(const bench_config_t *config, const bench_result_t *r) {
+    // ticks * 1e9 / (ticks_per_second * iterations), split so a second of cycles cannot overflow
+    return r->ticks * 10000 / r->iterations * 1000000 / config->ticks_per_second;
+}
+
+uint64_t bench_mb_per_s_x10(const bench_config_t *config, const bench_result_t *r) {
+    // MB/s = bytes / ns * 1000
+    const uint64_t ns_x10 = bench_ns_per_iter_x10(config, r);
+    return r->bytes && ns_x10 ? (uint64_t)r->bytes * 100000 / ns_x10 : 0;
+}
+
+// Value with one decimal from tenths
+static void print_tenths(const uint64_t tenths) {
+    printf("%llu.%u", (unsigned long long)(tenths / 10), (unsigned)(tenths % 10));
+}
+
+void bench_print_table(const bench_config_t *config, const bench_result_t *results, const size_t count) {
+    printf("%-16s %10s %14s %12s %10s\r\n", "case", "iterations", config->cycles ? "cycles/iter" : "ticks/iter",
+        "ns/iter", "MB/s");
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        const uint64_t ticks = bench_ticks_per_iter_x10(r);
+        const uint64_t ns = bench_ns_per_iter_x10(config, r);
+        const uint64_t mb = bench_mb_per_s_x10(config, r);
+        printf("%-16s %10u %12llu.%u %10llu.%u", r->name, (unsigned)r->iterations,
+            (unsigned long long)(ticks / 10), (unsigned)(ticks % 10), (unsigned long long)(ns / 10), (unsigned)(ns % 10));
+        if (mb)
+            printf(" %8llu.%u", (unsigned long long)(mb / 10), (unsigned)(mb % 10));
+        printf("\r\n");
+    }
+}
+
+void bench_print_json(const bench_config_t *config, const bench_result_t *results, const size_t count) {
+    printf("{\"clock_hz\":%llu,\"results\":[", (unsigned long long)config->ticks_per_second);
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        printf("%s{\"name\":\"%s\",\"iterations\":%u,\"ns_per_iter\":", i ? "," : "", r->name, (unsigned)r->iterations);
+        print_tenths(bench_ns_per_iter_x10(config, r));
+        const uint64_t mb = bench_mb_per_s_x10(config, r);
+        if (mb) {
+            printf(",\"mb_per_s\":");
+            print_tenths(mb);
+        }
+        printf("}");
+    }
+    printf("]}\r\n");
+}
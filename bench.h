@@ -0,0 +1,63 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Micro-benchmark harness for the UART/AT hot paths. Each case is a kernel
+// that runs a given number of iterations; the harness doubles the iteration
+// count until a run lasts at least BENCH_MIN_TICKS, then reports the cost per
+// iteration. Measurement and reporting are separate: results are printed as a
+// table for people and as one JSON document so tools/bench_compare.py can check
+// them against a stored baseline. The harness itself only needs a tick counter,
+// so it does not depend on the Pico SDK.
+
+#define BENCH_MAX_ITERATIONS (1u << 24)
+#define BENCH_MAX_CASES 16
+
+typedef void (*bench_kernel_t)(void *ctx, uint32_t iterations);
+typedef uint64_t (*bench_clock_t)(void); // Monotonic tick counter
+
+typedef struct {
+    const char *name; // Stable key used by the baseline
+    bench_kernel_t kernel;
+    void *ctx;
+    uint32_t bytes; // Bytes processed per iteration, 0 when throughput is meaningless
+} bench_case_t;
+
+typedef struct {
+    const char *name;
+    uint32_t iterations;
+    uint64_t ticks; // Total for all iterations
+    uint32_t bytes;
+} bench_result_t;
+
+typedef struct {
+    bench_clock_t clock;
+    uint64_t ticks_per_second; // 1000000 for time_us_64(), the CPU clock for a cycle counter
+    bool cycles; // Ticks are CPU cycles, the table shows cycles per iteration
+    uint64_t min_ticks; // Shortest measured run
+    uint8_t repeats; // Runs per case, the fastest is reported; interrupts and other processes only add time
+} bench_config_t;
+
+// Time one case, calibrating the iteration count first
+void bench_run(const bench_config_t *config, const bench_case_t *c, bench_result_t *result);
+void bench_run_all(const bench_config_t *config, const bench_case_t *cases, size_t count, bench_result_t *results);
+
+// Derived figures in tenths, so reporting needs no floating point
+uint64_t bench_ticks_per_iter_x10(const bench_result_t *r);
+uint64_t bench_ns_per_iter_x10(const bench_config_t *config, const bench_result_t *r);
+uint64_t bench_mb_per_s_x10(const bench_config_t *config, const bench_result_t *r); // 0 without a byte count
+
+// Reports
+void bench_print_table(const bench_config_t *config, const bench_result_t *results, size_t count);
+// One line, e.g.
+// {"clock_hz":125000000,"results":[{"name":"hex_encode","iterations":65536,"ns_per_iter":812.4,"mb_per_s":39.4}]}
+void bench_print_json(const bench_config_t *config, const bench_result_t *results, size_t count);
+
+// Kernels for this firmware, defined in bench_cases.c
+extern const bench_case_t bench_cases[];
+extern const size_t bench_case_count;
+
+#endif
@@ -0,0 +1,215 @@
+#include "bench.h"
+#include <string.h>
+#include "downlink.h"
+#include "event_queue.h"
+#include "hex.h"
+#include "modem.h"
+#include "module_info.h"
+#include "capture.h"
+#include "replay.h"
+#ifdef LORA_BENCH_CAPTURE
+#include LORA_BENCH_CAPTURE // bench_capture[], written by tools/capture_replay.py c-header
+#endif
+
+// Kernels for the UART/AT hot paths, fed with canned module output
+
+#define BENCH_PAYLOAD_LEN 52 // Largest queued uplink (FQ_PAYLOAD_MAX)
+
+// Not const, so the compiler cannot fold the string searches at build time
+static char at_line[] = "+AT: OK";
+static char version_line[] = "+VER: 4.0.11\r\n";
+static char dev_eui_line[] = "+ID: DevEui, 2C:F7:F1:20:32:30:A5:70";
+static const char downlink_report[] =
+    "+MSGHEX: Start\r\n"
+    "+MSGHEX: FPENDING\r\n"
+    "+MSGHEX: PORT: 1; RX: \"0102030405060708090A0B0C0D0E0F10\"\r\n"
+    "+MSGHEX: RXWIN1, RSSI -106, SNR 4.5\r\n"
+    "+MSGHEX: Done\r\n";
+
+static volatile uint32_t sink; // Keeps results alive so kernels are not optimised away
+// The matcher reads the lines through volatile pointers: with the arrays alone
+// an optimising build still sees they never change and folds the searches
+static const char *volatile matched_lines[] = { at_line, version_line, dev_eui_line };
+
+// Line framing: the port's poll hook refills the ring with one response line,
+// which modem_poll_line() assembles as it would from the UART interrupt
+static void bench_port_write(void *hw, const char *data, size_t len) {
+    (void)hw;
+    (void)data;
+    (void)len;
+}
+
+static void bench_port_poll(void *hw, ring_t *rx, uint32_t *framing_errors) {
+    (void)hw;
+    (void)framing_errors;
+    for (const char *p = version_line; *p != '\0'; p++)
+        ring_put(rx, (uint8_t)*p);
+}
+
+static const modem_port_t bench_port = { .write = bench_port_write, .poll = bench_port_poll };
+static modem_t bench_modem;
+
+static void line_framing(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    if (bench_modem.port == NULL)
+        modem_init(&bench_modem, "bench", &bench_port, NULL);
+    uint32_t lines = 0;
+    while (iterations--)
+        lines += modem_poll_line(&bench_modem);
+    sink = lines;
+}
+
+// Response matching as done by the probe engine
+static void prefix_match(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    uint32_t hits = 0;
+    while (iterations--) {
+        hits += strstr(matched_lines[0], "OK") != NULL;
+        hits += strstr(matched_lines[1], "VER") != NULL;
+        hits += strstr(matched_lines[2], "DevEui") != NULL;
+    }
+    sink = hits;
+}
+
+// Parse the response into the binary DevEui and format it for output
+static void dev_eui_format(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    char out[MODULE_DEV_EUI_TEXT_LEN];
+    uint64_t dev_eui = 0;
+    uint32_t total = 0;
+    while (iterations--) {
+        total += module_parse_dev_eui(dev_eui_line, &dev_eui);
+        module_format_dev_eui(out, dev_eui);
+    }
+    sink = total + (uint8_t)out[0];
+}
+
+static void hex_encode_kernel(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    uint8_t payload[BENCH_PAYLOAD_LEN];
+    char text[BENCH_PAYLOAD_LEN * 2];
+    for (size_t i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 37);
+    while (iterations--) {
+        hex_encode(text, payload, sizeof(payload));
+        payload[0] ^= (uint8_t)text[1]; // Chain iterations together
+    }
+    sink = payload[0];
+}
+
+static void hex_decode_kernel(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    uint8_t payload[BENCH_PAYLOAD_LEN];
+    char text[BENCH_PAYLOAD_LEN * 2];
+    for (size_t i = 0; i < sizeof(text); i++)
+        text[i] = "0123456789abcdefABCDEF"[i % 22];
+    int total = 0;
+    while (iterations--)
+        total += hex_decode(payload, sizeof(payload), text, sizeof(text));
+    sink = (uint32_t)total + payload[0];
+}
+
+// Complete uplink answer with a downlink, byte by byte
+static void downlink_parse(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    uint8_t payload[BENCH_PAYLOAD_LEN];
+    downlink_t dl;
+    uint32_t total = 0;
+    while (iterations--) {
+        downlink_begin(&dl, payload, sizeof(payload));
+        for (const char *p = downlink_report; *p != '\0'; p++)
+            downlink_feed(&dl, *p);
+        total += (uint32_t)dl.len;
+    }
+    sink = total;
+}
+
+// Identity probe against a recorded conversation: the replay port releases each
+// response once the engine has sent the command it answers. A field capture
+// can replace the built-in one (LORA_BENCH_CAPTURE in CMakeLists.txt)
+static void replay_port_write(void *hw, const char *data, size_t len) {
+    (void)data;
+    replay_write(hw, len);
+}
+
+static void replay_port_poll(void *hw, ring_t *rx, uint32_t *framing_errors) {
+    (void)framing_errors;
+    replay_poll(hw, rx, 0);
+}
+
+static const modem_port_t replay_port = { .write = replay_port_write, .poll = replay_port_poll };
+
+#ifndef LORA_BENCH_CAPTURE
+static const char *const probe_conversation[] = { // Alternating TX and RX records
+    "AT\r\n", "+AT: OK\r\n",
+    "AT+VER\r\n", "+VER: 4.0.11\r\n",
+    "AT+ID=DevEui\r\n", "+ID: DevEui, 2C:F7:F1:20:32:30:A5:70\r\n",
+};
+static uint8_t bench_capture[128];
+#endif
+
+static void replay_probe(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    size_t capture_len = sizeof(bench_capture);
+#ifndef LORA_BENCH_CAPTURE
+    static capture_t built;
+    if (built.buf == NULL) {
+        capture_init(&built, bench_capture, sizeof(bench_capture));
+        capture_start(&built, 0);
+        for (size_t i = 0; i < sizeof(probe_conversation) / sizeof(probe_conversation[0]); i++)
+            capture_add(&built, i % 2 ? CAPTURE_RX : CAPTURE_TX, 1000 * i, (const uint8_t *)probe_conversation[i],
+                strlen(probe_conversation[i]));
+    }
+    capture_len = built.len;
+#endif
+    static replay_t replay;
+    static modem_t modem;
+    uint32_t done = 0;
+    while (iterations--) {
+        replay_init(&replay, bench_capture, capture_len, REPLAY_NO_DELAY);
+        modem_init(&modem, "replay", &replay_port, &replay);
+        modem_probe_start(&modem, 0);
+        // Time stands still, so no step times out; stop when the capture has nothing more for the engine
+        uint32_t released;
+        do {
+            released = replay.rx_released;
+            modem_probe_poll(&modem, 0);
+        } while (modem_busy(&modem) && replay.rx_released != released);
+        done += modem.state == PROBE_DONE;
+    }
+    sink = done;
+}
+
+// One post and one dispatch-side removal through the priority queue
+static void event_queue_round_trip(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    static event_queue_t queue;
+    static bool initialised = false;
+    if (!initialised) {
+        event_queue_init(&queue);
+        initialised = true;
+    }
+    event_t event = { .type = EVENT_USER, .data = 0 };
+    event_t out;
+    uint32_t total = 0;
+    while (iterations--) {
+        event.data++;
+        event_queue_add(&queue, &event);
+        event_queue_remove(&queue, &out);
+        total += (uint32_t)out.data;
+    }
+    sink = total;
+}
+
+const bench_case_t bench_cases[] = {
+    { "line_framing", line_framing, NULL, sizeof(version_line) - 1 },
+    { "prefix_match", prefix_match, NULL, 0 },
+    { "dev_eui_format", dev_eui_format, NULL, sizeof(dev_eui_line) - 1 },
+    { "hex_encode", hex_encode_kernel, NULL, BENCH_PAYLOAD_LEN },
+    { "hex_decode", hex_decode_kernel, NULL, BENCH_PAYLOAD_LEN * 2 },
+    { "downlink_parse", downlink_parse, NULL, sizeof(downlink_report) - 1 },
+    { "event_queue", event_queue_round_trip, NULL, 0 },
+    { "replay_probe", replay_probe, NULL, 0 },
+};
+
+const size_t bench_case_count = sizeof(bench_cases) / sizeof(bench_cases[0]);
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/clocks.h"
+#include "hardware/exception.h"
+#include "hardware/structs/systick.h"
+#include "bench.h"
+
+// Benchmark firmware (LORA_BENCH): runs the hot-path kernels from
+// bench_cases.c on the target, timed in CPU cycles with SysTick, so XIP cache
+// misses and the cost of Cortex-M0+ shifts and divides show up in the figures.
+// Results are printed as a table followed by the JSON line for
+// tools/bench_compare.py. Press SW_0 to run the suite again.
+
+#define SW_0 9 // Same button as the application
+#define BENCH_START_DELAY_MS 2000 // Time to attach a terminal
+#define BENCH_MIN_MS 100 // Shortest measured run per case
+#define BENCH_REPEATS 3 // USB and timer interrupts only add cycles, keep the fastest run
+
+#define SYSTICK_BITS 24
+#define SYSTICK_MAX ((1u << SYSTICK_BITS) - 1)
+#define SYSTICK_ENABLE 0x1
+#define SYSTICK_TICKINT 0x2
+#define SYSTICK_CLKSOURCE_CPU 0x4
+
+static volatile uint32_t systick_wraps; // Upper bits of the cycle counter
+
+// SysTick counts down from SYSTICK_MAX once every 2^24 cycles (134 ms at 125 MHz)
+static void systick_handler(void) {
+    systick_wraps++;
+}
+
+static void systick_start(void) {
+    exception_set_exclusive_handler(SYSTICK_EXCEPTION, systick_handler);
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MAX;
+    systick_hw->cvr = 0; // Any write clears the counter
+    systick_hw->csr = SYSTICK_ENABLE | SYSTICK_TICKINT | SYSTICK_CLKSOURCE_CPU;
+}
+
+// 64-bit cycle count: retry when the counter wrapped between the two reads
+static uint64_t bench_clock_cycles(void) {
+    uint32_t wraps, count;
+    do {
+        wraps = systick_wraps;
+        count = systick_hw->cvr;
+    } while (wraps != systick_wraps);
+    return ((uint64_t)wraps << SYSTICK_BITS) + (SYSTICK_MAX - count);
+}
+
+int main() {
+    // Initialize chosen serial port
+    stdio_init_all();
+    gpio_init(SW_0);
+    gpio_set_dir(SW_0, GPIO_IN);
+    gpio_pull_up(SW_0);
+    systick_start();
+    sleep_ms(BENCH_START_DELAY_MS);
+
+    const uint32_t hz = clock_get_hz(clk_sys);
+    const bench_config_t config = {
+        .clock = bench_clock_cycles,
+        .ticks_per_second = hz,
+        .cycles = true,
+        .min_ticks = (uint64_t)hz / 1000 * BENCH_MIN_MS,
+        .repeats = BENCH_REPEATS
+    };
+    static bench_result_t results[BENCH_MAX_CASES];
+    if (bench_case_count > BENCH_MAX_CASES)
+        panic("BENCH_MAX_CASES is too small for %u cases", (unsigned)bench_case_count);
+
+    while (true) {
+        printf("Benchmark, clk_sys %u Hz\r\n", (unsigned)hz);
+        bench_run_all(&config, bench_cases, bench_case_count, results);
+        bench_print_table(&config, results, bench_case_count);
+        bench_print_json(&config, results, bench_case_count);
+        // Wait for a press and release of SW_0 (active low)
+        while (gpio_get(SW_0))
+            sleep_ms(10);
+        while (!gpio_get(SW_0))
+            sleep_ms(10);
+    }
+}
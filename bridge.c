@@ -0,0 +1,66 @@
+#include "bridge.h"
+
+static void init_dir(bridge_dir_t *d, const bridge_port_t *from, const bridge_port_t *to) {
+    d->from = from;
+    d->to = to;
+    ring_init(&d->pending);
+    d->bytes = 0;
+}
+
+void bridge_init(bridge_t *b, const bridge_port_t *a, const bridge_port_t *port_b) {
+    init_dir(&b->dir[BRIDGE_A_TO_B], a, port_b);
+    init_dir(&b->dir[BRIDGE_B_TO_A], port_b, a);
+}
+
+// Endpoints read and write straight into the ring, one contiguous run per call.
+// The loops end when the ring is full (empty) or the endpoint has nothing more
+static bool refill(bridge_dir_t *d) {
+    ring_t *r = &d->pending;
+    bool moved = false;
+    while (true) {
+        const uint16_t head = r->head;
+        const uint16_t room = (uint16_t)(RING_SIZE - 1 - ring_count(r));
+        const uint16_t run = room < RING_SIZE - head ? room : (uint16_t)(RING_SIZE - head);
+        if (run == 0)
+            return moved;
+        const size_t n = d->from->read(d->from->ctx, &r->buf[head], run);
+        if (n == 0)
+            return moved;
+        r->head = (uint16_t)((head + n) & (RING_SIZE - 1));
+        moved = true;
+    }
+}
+
+static bool drain(bridge_dir_t *d) {
+    ring_t *r = &d->pending;
+    bool moved = false;
+    while (true) {
+        const uint16_t tail = r->tail;
+        const uint16_t count = ring_count(r);
+        const uint16_t run = count < RING_SIZE - tail ? count : (uint16_t)(RING_SIZE - tail);
+        if (run == 0)
+            return moved;
+        const size_t n = d->to->write(d->to->ctx, &r->buf[tail], run);
+        if (n == 0)
+            return moved;
+        r->tail = (uint16_t)((tail + n) & (RING_SIZE - 1));
+        d->bytes += (uint32_t)n;
+        moved = true;
+    }
+}
+
+bool bridge_pump(bridge_t *b) {
+    bool moved = false;
+    for (int i = 0; i < 2; i++) {
+        bridge_dir_t *d = &b->dir[i];
+        // Drain first so the refill finds the most room, then pass the new bytes on
+        moved |= drain(d);
+        moved |= refill(d);
+        moved |= drain(d);
+    }
+    return moved;
+}
+
+uint32_t bridge_dropped(const bridge_dir_t *d) {
+    return d->from->dropped ? d->from->dropped(d->from->ctx) : 0;
+}
@@ -0,0 +1,44 @@
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ring.h"
+
+// Transparent byte pump between two serial endpoints (USB CDC and the module
+// UART in the firmware). Each direction keeps the bytes its sink has not
+// accepted yet in a ring and only reads from its source while there is room,
+// so a slow sink pushes back on the source instead of losing data in here.
+// Bytes can still be lost by a source that cannot be paused (a UART without
+// flow control); the endpoint counts those itself. The endpoints are behind
+// bridge_port_t, like power_ops_t, so the pump has no SDK dependency and can
+// run on a host between two file descriptors.
+
+typedef struct {
+    size_t (*read)(void *ctx, uint8_t *buf, size_t max); // Received bytes, up to max, never blocks
+    size_t (*write)(void *ctx, const uint8_t *data, size_t len); // Bytes taken for transmission, never blocks
+    uint32_t (*dropped)(void *ctx); // Received bytes lost before they were read, NULL when nothing can be lost
+    void *ctx;
+} bridge_port_t;
+
+typedef struct {
+    const bridge_port_t *from;
+    const bridge_port_t *to;
+    ring_t pending; // Read from the source, not yet taken by the sink
+    uint32_t bytes; // Delivered to the sink
+} bridge_dir_t;
+
+// dir[BRIDGE_A_TO_B] carries bytes from the first port to the second
+#define BRIDGE_A_TO_B 0
+#define BRIDGE_B_TO_A 1
+
+typedef struct {
+    bridge_dir_t dir[2];
+} bridge_t;
+
+void bridge_init(bridge_t *b, const bridge_port_t *a, const bridge_port_t *port_b);
+bool bridge_pump(bridge_t *b); // Move what both directions can take now, true when any byte moved
+uint32_t bridge_dropped(const bridge_dir_t *d); // Bytes its source lost, 0 when the source cannot lose any
+
+#endif
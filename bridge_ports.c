@@ -0,0 +1,182 @@
+#include "bridge_ports.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/dma.h"
+#include "tusb.h"
+
+typedef struct {
+    // DMA writes here with address wrapping, so the ring must be aligned to its size
+    uint8_t rx_buf[BRIDGE_UART_RX_LEN] __attribute__((aligned(BRIDGE_UART_RX_LEN)));
+    uint8_t tx_buf[BRIDGE_UART_TX_LEN];
+    uart_inst_t *uart;
+    uint dma_rx;
+    uint dma_tx;
+    uint16_t rx_tail; // Next byte of rx_buf to hand to the bridge
+    uint32_t rx_taken; // Bytes taken since the RX transfer was started
+    bridge_uart_stats_t stats;
+} bridge_uart_t;
+
+static bridge_uart_t bridge_uart; // One bridge per firmware
+static volatile uint32_t host_baud; // Rate of the host's last SET_LINE_CODING
+static volatile bool host_baud_set; // Not taken by bridge_usb_line_coding() yet
+
+// ---- USB CDC ----
+
+static size_t usb_read(void *ctx, uint8_t *buf, const size_t max) {
+    (void)ctx;
+    const int n = stdio_usb.in_chars((char *)buf, (int)max);
+    return n > 0 ? (size_t)n : 0;
+}
+
+// Only as much as fits in the CDC FIFO, so the call never waits for the host.
+// Without a terminal on the host nothing is taken and the UART ring backs up
+static size_t usb_write(void *ctx, const uint8_t *data, size_t len) {
+    (void)ctx;
+    if (!stdio_usb_connected())
+        return 0;
+    const uint32_t room = tud_cdc_write_available();
+    if (len > room)
+        len = room;
+    if (len > 0)
+        stdio_usb.out_chars((const char *)data, (int)len);
+    return len;
+}
+
+static const bridge_port_t usb_port = { .read = usb_read, .write = usb_write, .dropped = NULL, .ctx = NULL };
+
+const bridge_port_t *bridge_usb_port(void) {
+    // USB keeps running from the stdio_usb background interrupt, printf goes to the UART console only
+    stdio_set_driver_enabled(&stdio_usb, false);
+    return &usb_port;
+}
+
+// Called from the USB task for every SET_LINE_CODING, also one that repeats the
+// current rate: TinyUSB starts out at 115200, so watching the rate for changes
+// would miss a host that opens the port at 115200 while the module runs at another.
+// Needs PICO_STDIO_USB_ENABLE_RESET_VIA_BAUD_RATE=0, the SDK's own callback is then left out
+void tud_cdc_line_coding_cb(const uint8_t itf, cdc_line_coding_t const *coding) {
+    (void)itf;
+    host_baud = coding->bit_rate;
+    host_baud_set = true;
+}
+
+bool bridge_usb_line_coding(uint32_t *baud) {
+    if (!host_baud_set)
+        return false;
+    host_baud_set = false; // Cleared first, a request arriving now is seen next time
+    *baud = host_baud;
+    return *baud != 0;
+}
+
+// ---- UART with DMA ----
+
+// Endless RX transfer into rx_buf, wrapping at its end, started where the bridge will read next
+static void start_rx_dma(bridge_uart_t *u) {
+    dma_channel_config c = dma_channel_get_default_config(u->dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, BRIDGE_UART_RX_RING_BITS);
+    channel_config_set_dreq(&c, uart_get_dreq(u->uart, false));
+    u->rx_taken = 0;
+    dma_channel_configure(u->dma_rx, &c, &u->rx_buf[u->rx_tail], &uart_get_hw(u->uart)->dr, UINT32_MAX, true);
+}
+
+static size_t uart_read(void *ctx, uint8_t *buf, size_t max) {
+    bridge_uart_t *u = ctx;
+    if (uart_get_hw(u->uart)->rsr & UART_UARTRSR_OE_BITS) {
+        uart_get_hw(u->uart)->rsr = 0; // Any write clears the error flags
+        u->stats.fifo_overruns++;
+    }
+
+    // The transfer count runs out after 2^32 bytes, re-arm where it stopped
+    if (!dma_channel_is_busy(u->dma_rx))
+        start_rx_dma(u);
+
+    const uint32_t received = UINT32_MAX - dma_channel_hw_addr(u->dma_rx)->transfer_count;
+    uint32_t pending = received - u->rx_taken;
+    if (pending >= BRIDGE_UART_RX_LEN) {
+        // The DMA has overwritten bytes that were never read; none of the ring can be trusted
+        u->stats.ring_lost += pending;
+        u->rx_tail = (uint16_t)((u->rx_tail + pending) & (BRIDGE_UART_RX_LEN - 1));
+        u->rx_taken = received;
+        return 0;
+    }
+
+    if (pending > max)
+        pending = (uint32_t)max;
+    for (uint32_t i = 0; i < pending; i++) {
+        buf[i] = u->rx_buf[u->rx_tail];
+        u->rx_tail = (u->rx_tail + 1) & (BRIDGE_UART_RX_LEN - 1);
+    }
+    u->rx_taken += pending;
+    return pending;
+}
+
+// Starts a DMA transfer when the previous one is done, otherwise takes nothing
+static size_t uart_write(void *ctx, const uint8_t *data, size_t len) {
+    bridge_uart_t *u = ctx;
+    if (dma_channel_is_busy(u->dma_tx))
+        return 0;
+    if (len > BRIDGE_UART_TX_LEN)
+        len = BRIDGE_UART_TX_LEN;
+    memcpy(u->tx_buf, data, len);
+    dma_channel_transfer_from_buffer_now(u->dma_tx, u->tx_buf, (uint32_t)len);
+    return len;
+}
+
+static uint32_t uart_dropped(void *ctx) {
+    const bridge_uart_t *u = ctx;
+    return u->stats.ring_lost + u->stats.fifo_overruns;
+}
+
+static const bridge_port_t uart_port = {
+    .read = uart_read, .write = uart_write, .dropped = uart_dropped, .ctx = &bridge_uart
+};
+
+const bridge_port_t *bridge_uart_port(uart_inst_t *uart, const uint tx_pin, const uint rx_pin, const uint baud) {
+    bridge_uart_t *u = &bridge_uart;
+    const int dma_rx = dma_claim_unused_channel(false);
+    const int dma_tx = dma_claim_unused_channel(false);
+    if (dma_rx < 0 || dma_tx < 0) {
+        if (dma_rx >= 0)
+            dma_channel_unclaim((uint)dma_rx);
+        if (dma_tx >= 0)
+            dma_channel_unclaim((uint)dma_tx);
+        return NULL;
+    }
+    u->uart = uart;
+    u->dma_rx = (uint)dma_rx;
+    u->dma_tx = (uint)dma_tx;
+    u->rx_tail = 0;
+    memset(&u->stats, 0, sizeof(u->stats));
+
+    // uart_init also enables the DMA requests. No RX interrupt: it would race the DMA for the FIFO
+    uart_init(uart, baud);
+    gpio_set_function(tx_pin, GPIO_FUNC_UART);
+    gpio_set_function(rx_pin, GPIO_FUNC_UART);
+    uart_set_format(uart, 8, 1, UART_PARITY_NONE);
+    uart_set_fifo_enabled(uart, true);
+    start_rx_dma(u);
+
+    dma_channel_config c = dma_channel_get_default_config(u->dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(uart, true));
+    dma_channel_configure(u->dma_tx, &c, &uart_get_hw(uart)->dr, u->tx_buf, 0, false);
+    return &uart_port;
+}
+
+// Waits for the byte in flight so it is not cut by the divider change
+void bridge_uart_set_baud(const uint baud) {
+    bridge_uart_t *u = &bridge_uart;
+    dma_channel_wait_for_finish_blocking(u->dma_tx);
+    uart_tx_wait_blocking(u->uart);
+    uart_set_baudrate(u->uart, baud);
+}
+
+bridge_uart_stats_t bridge_uart_stats(void) {
+    return bridge_uart.stats;
+}
@@ -0,0 +1,29 @@
+#ifndef BRIDGE_PORTS_H
+#define BRIDGE_PORTS_H
+
+#include "bridge.h"
+#include "hardware/uart.h"
+
+// RP2040 endpoints for the bridge. The USB side is the CDC interface of
+// pico_stdio_usb, taken over from stdio so console output no longer mixes
+// into the stream. The UART side receives into a DMA ring and transmits from
+// a DMA buffer, so no byte depends on the CPU reaching an interrupt in time.
+
+#define BRIDGE_UART_RX_LEN 1024 // DMA ring, a power of two aligned to its own size (~90 ms at 115200 baud)
+#define BRIDGE_UART_RX_RING_BITS 10 // log2(BRIDGE_UART_RX_LEN)
+#define BRIDGE_UART_TX_LEN 64 // Largest single write handed to the TX DMA
+
+// Bytes lost on the UART side, the two causes are counted separately
+typedef struct {
+    uint32_t ring_lost; // DMA lapped the ring before the bridge read it
+    uint32_t fifo_overruns; // Hardware FIFO overran (DMA could not keep up), count of events
+} bridge_uart_stats_t;
+
+const bridge_port_t *bridge_usb_port(void); // Detaches the CDC interface from stdio
+bool bridge_usb_line_coding(uint32_t *baud); // True once for each SET_LINE_CODING from the host, with its baud rate
+
+const bridge_port_t *bridge_uart_port(uart_inst_t *uart, uint tx_pin, uint rx_pin, uint baud); // 8N1, NULL when no DMA channels are free
+void bridge_uart_set_baud(uint baud); // Follow the host's line coding
+bridge_uart_stats_t bridge_uart_stats(void);
+
+#endif
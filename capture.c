@@ -0,0 +1,93 @@
+#include "capture.h"
+#include <string.h>
+#include "hot.h"
+
+#define VARINT_MAX 5 // Bytes for a 32-bit value
+
+static size_t HOT_FUNC(varint_put)(uint8_t *dst, uint32_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        dst[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    dst[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool varint_get(capture_reader_t *r, uint32_t *value) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 7 * VARINT_MAX; shift += 7) {
+        if (r->pos >= r->len)
+            return false;
+        const uint8_t b = r->buf[r->pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *value = v;
+            return true;
+        }
+    }
+    return false; // Longer than any value written by varint_put
+}
+
+void capture_init(capture_t *c, uint8_t *buf, const size_t size) {
+    c->buf = buf;
+    c->size = size;
+    c->len = 0;
+    c->last_us = 0;
+    c->active = false;
+    c->records = 0;
+    c->dropped = 0;
+}
+
+void capture_start(capture_t *c, const uint64_t now_us) {
+    c->len = 0;
+    c->last_us = now_us;
+    c->records = 0;
+    c->dropped = 0;
+    c->active = true;
+}
+
+void capture_stop(capture_t *c) {
+    c->active = false;
+}
+
+bool HOT_FUNC(capture_add)(capture_t *c, const uint8_t direction, const uint64_t now_us, const uint8_t *data, const size_t len) {
+    if (!c->active || len == 0)
+        return false;
+    if (c->size - c->len < 2 * VARINT_MAX || c->size - c->len - 2 * VARINT_MAX < len) {
+        c->dropped += (uint32_t)len;
+        return false;
+    }
+    const uint64_t delta = now_us - c->last_us;
+    const uint32_t delta_us = delta > CAPTURE_MAX_DELTA_US ? CAPTURE_MAX_DELTA_US : (uint32_t)delta;
+    size_t pos = c->len;
+    pos += varint_put(&c->buf[pos], delta_us << 1 | (direction & 1));
+    pos += varint_put(&c->buf[pos], (uint32_t)len);
+    memcpy(&c->buf[pos], data, len);
+    c->len = pos + len;
+    c->last_us = now_us;
+    c->records++;
+    return true;
+}
+
+void capture_reader_init(capture_reader_t *r, const uint8_t *log, const size_t len) {
+    r->buf = log;
+    r->len = len;
+    r->pos = 0;
+}
+
+bool capture_next(capture_reader_t *r, capture_record_t *record) {
+    uint32_t header;
+    uint32_t len;
+    const size_t start = r->pos;
+    if (!varint_get(r, &header) || !varint_get(r, &len) || len > r->len - r->pos) {
+        r->pos = start;
+        return false;
+    }
+    record->direction = (uint8_t)(header & 1);
+    record->delta_us = header >> 1;
+    record->data = &r->buf[r->pos];
+    record->len = len;
+    r->pos += len;
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Compact binary transcript of a module's UART traffic. Each record holds the
+// bytes moved in one go (one RX interrupt or one write) in one direction:
+//
+//   varint((delta_us << 1) | direction)  varint(length)  bytes
+//
+// where delta_us is the time since the previous record (since the start for
+// the first one). A typical 9600 baud exchange costs two or three bytes of
+// overhead per record. When the buffer is full further records are counted
+// as dropped, so the log is always a valid prefix of the session. Nothing
+// here depends on the SDK; the caller supplies timestamps and, when records
+// are added from an interrupt and the main loop, the locking.
+
+#define CAPTURE_RX 0 // Received from the module
+#define CAPTURE_TX 1 // Sent to the module
+#define CAPTURE_MAX_DELTA_US 0x7FFFFFFFu // Longer gaps are recorded as this
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len; // Bytes of log in buf
+    uint64_t last_us; // Time of the previous record
+    bool active;
+    uint32_t records;
+    uint32_t dropped; // Payload bytes not recorded because buf was full
+} capture_t;
+
+typedef struct {
+    uint8_t direction;
+    uint32_t delta_us;
+    const uint8_t *data; // Points into the log
+    size_t len;
+} capture_record_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+} capture_reader_t;
+
+void capture_init(capture_t *c, uint8_t *buf, size_t size); // Inactive and empty
+void capture_start(capture_t *c, uint64_t now_us); // Discard the log and start recording
+void capture_stop(capture_t *c);
+bool capture_add(capture_t *c, uint8_t direction, uint64_t now_us, const uint8_t *data, size_t len); // False when not recorded
+
+void capture_reader_init(capture_reader_t *r, const uint8_t *log, size_t len);
+bool capture_next(capture_reader_t *r, capture_record_t *record); // False at the end or at a truncated record
+
+#endif
@@ -0,0 +1,141 @@
+#include "console.h"
+#include <stdio.h>
+
+static char lower(const char ch) {
+    return ch >= 'A' && ch <= 'Z' ? (char)(ch + ('a' - 'A')) : ch;
+}
+
+// Command names are matched without regard to case
+static bool same_name(const char *a, const char *b) {
+    while (*a && lower(*a) == lower(*b)) {
+        a++;
+        b++;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+static bool is_at(const char *line) {
+    return lower(line[0]) == 'a' && lower(line[1]) == 't';
+}
+
+static bool is_space(const char ch) {
+    return ch == ' ' || ch == '\t';
+}
+
+void console_init(console_t *c, const console_command_t *commands, const size_t count,
+    void (*at)(const char *line, void *ctx), void *ctx) {
+    c->commands = commands;
+    c->count = count;
+    c->at = at;
+    c->ctx = ctx;
+    c->echo = true;
+    c->len = 0;
+    c->overflow = false;
+    c->last = '\0';
+}
+
+const console_command_t *console_find(const console_t *c, const char *name) {
+    for (size_t i = 0; i < c->count; i++) {
+        if (same_name(c->commands[i].name, name))
+            return &c->commands[i];
+    }
+    return NULL;
+}
+
+void console_help(const console_t *c) {
+    printf("%-24s %s\r\n", "AT...", "Send a command to the module");
+    for (size_t i = 0; i < c->count; i++) {
+        const console_command_t *cmd = &c->commands[i];
+        char syntax[48];
+        snprintf(syntax, sizeof(syntax), "%s %s", cmd->name, cmd->usage);
+        printf("%-24s %s\r\n", syntax, cmd->help);
+    }
+}
+
+// Split on spaces in place, at most CONSOLE_MAX_ARGS words; -1 when there are more
+static int split(char *line, char *argv[]) {
+    int argc = 0;
+    while (true) {
+        while (is_space(*line))
+            *line++ = '\0';
+        if (*line == '\0')
+            return argc;
+        if (argc == CONSOLE_MAX_ARGS)
+            return -1;
+        argv[argc++] = line;
+        while (*line && !is_space(*line))
+            line++;
+    }
+}
+
+void console_execute(console_t *c, char *line) {
+    while (is_space(*line))
+        line++;
+    if (*line == '\0')
+        return;
+    if (is_at(line)) {
+        if (c->at)
+            c->at(line, c->ctx);
+        return;
+    }
+
+    char *argv[CONSOLE_MAX_ARGS];
+    const int argc = split(line, argv);
+    if (argc < 0) {
+        printf("Too many arguments\r\n");
+        return;
+    }
+    if (same_name(argv[0], "help")) {
+        console_help(c);
+        return;
+    }
+    const console_command_t *cmd = console_find(c, argv[0]);
+    if (cmd == NULL) {
+        printf("Unknown command %s, try help\r\n", argv[0]);
+        return;
+    }
+    if (argc - 1 < cmd->min_args || argc - 1 > cmd->max_args) {
+        printf("Usage: %s %s\r\n", cmd->name, cmd->usage);
+        return;
+    }
+    cmd->run(argc, argv, c->ctx);
+}
+
+bool console_feed(console_t *c, const char ch) {
+    const char last = c->last;
+    c->last = ch;
+    if (ch == '\n' && last == '\r')
+        return false; // Second half of a CRLF
+    if (ch == '\r' || ch == '\n') {
+        if (c->echo)
+            printf("\r\n");
+        c->line[c->len] = '\0';
+        const bool overflow = c->overflow;
+        c->len = 0;
+        c->overflow = false;
+        if (overflow) {
+            printf("Line too long\r\n");
+            return false;
+        }
+        console_execute(c, c->line);
+        return true;
+    }
+    if (ch == '\b' || ch == 0x7F) { // Backspace or DEL, depending on the terminal
+        if (c->len > 0) {
+            c->len--;
+            if (c->echo)
+                printf("\b \b");
+        }
+        return false;
+    }
+    if ((unsigned char)ch < ' ')
+        return false; // Other control characters
+    if (c->len < CONSOLE_LINE_LEN - 1) {
+        c->line[c->len++] = ch;
+        if (c->echo)
+            putchar(ch);
+    }
+    else
+        c->overflow = true;
+    return false;
+}
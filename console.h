@@ -0,0 +1,48 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Line-based command interpreter for the stdio console. Characters are fed
+// one at a time (echoed, with backspace editing); a completed line is either
+// a raw AT command, handed on unchanged, or a built-in command looked up in a
+// caller-provided table and run with its arguments split on spaces. Nothing
+// here depends on the SDK, output goes through printf.
+
+#define CONSOLE_LINE_LEN 128 // Longest accepted line, the rest is dropped
+#define CONSOLE_MAX_ARGS 6 // Command name included
+
+typedef void (*console_fn_t)(int argc, char *argv[], void *ctx); // argv[0] is the command name
+
+typedef struct {
+    const char *name;
+    const char *usage; // Arguments shown by help, "" for none
+    const char *help;
+    console_fn_t run;
+    uint8_t min_args; // Not counting the command name
+    uint8_t max_args;
+} console_command_t;
+
+typedef struct {
+    const console_command_t *commands;
+    size_t count;
+    void (*at)(const char *line, void *ctx); // Lines starting with "AT" (either case)
+    void *ctx; // Passed to the command functions and to at
+    bool echo; // Echo input back to the terminal
+
+    char line[CONSOLE_LINE_LEN];
+    uint16_t len;
+    bool overflow; // Line was longer than CONSOLE_LINE_LEN - 1
+    char last; // Previous character, a '\n' right after '\r' ends no second line
+} console_t;
+
+void console_init(console_t *c, const console_command_t *commands, size_t count,
+    void (*at)(const char *line, void *ctx), void *ctx);
+bool console_feed(console_t *c, char ch); // Consume one input character, true when a line was executed
+void console_execute(console_t *c, char *line); // Run one complete line (modified in place)
+const console_command_t *console_find(const console_t *c, const char *name); // NULL when unknown
+void console_help(const console_t *c); // List the command table
+
+#endif
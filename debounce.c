@@ -0,0 +1,129 @@
+#include "debounce.h"
+#include "hardware/gpio.h"
+#include "hot.h"
+#include "latency.h"
+
+#define EDGES (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)
+
+typedef struct {
+    uint gpio;
+    bool pressed; // Debounced state
+    alarm_id_t long_alarm; // Pending long-press alarm, 0 if none
+    alarm_id_t click_alarm; // Short press waiting for the double-press window to pass, 0 if none
+} input_t;
+
+static input_t inputs[DEBOUNCE_MAX_INPUTS];
+static int input_count = 0;
+static button_handler_t button_handler = NULL;
+
+static input_t *HOT_FUNC(find_input)(const uint gpio) {
+    for (int i = 0; i < input_count; i++) {
+        if (inputs[i].gpio == gpio)
+            return &inputs[i];
+    }
+    return NULL;
+}
+
+static int64_t HOT_FUNC(long_press_alarm)(alarm_id_t id, void *user_data) {
+    (void)id;
+    input_t *in = user_data;
+    in->long_alarm = 0;
+    if (in->pressed)
+        button_handler(in->gpio, BUTTON_LONG_PRESS);
+    return 0; // One-shot
+}
+
+// No second press followed the short one: it was a single press
+static int64_t HOT_FUNC(click_alarm)(alarm_id_t id, void *user_data) {
+    (void)id;
+    input_t *in = user_data;
+    in->click_alarm = 0;
+    button_handler(in->gpio, BUTTON_PRESS);
+    return 0; // One-shot
+}
+
+// Act on a change of the debounced state
+static void HOT_FUNC(update_state)(input_t *in, const bool pressed) {
+    if (pressed == in->pressed)
+        return; // Bounce that settled back to the old level
+    in->pressed = pressed;
+
+    if (pressed) {
+        if (in->click_alarm > 0) {
+            // Second press inside the window: it replaces the pending single press
+            cancel_alarm(in->click_alarm);
+            in->click_alarm = 0;
+            button_handler(in->gpio, BUTTON_DOUBLE_PRESS);
+            return;
+        }
+        in->long_alarm = add_alarm_in_ms(LONG_PRESS_MS, long_press_alarm, in, true);
+        if (in->long_alarm < 0)
+            in->long_alarm = 0; // No alarm slot free, long press is simply not reported
+    }
+    else {
+        if (in->long_alarm > 0) {
+            // Short press, may be the first half of a double
+            cancel_alarm(in->long_alarm);
+            in->long_alarm = 0;
+            in->click_alarm = add_alarm_in_ms(DOUBLE_PRESS_MS, click_alarm, in, true);
+            if (in->click_alarm < 0) {
+                in->click_alarm = 0; // No alarm slot free, report the press without waiting
+                button_handler(in->gpio, BUTTON_PRESS);
+            }
+        }
+        button_handler(in->gpio, BUTTON_RELEASE);
+    }
+}
+
+static void gpio_irq(uint gpio, uint32_t event_mask);
+
+// Runs DEBOUNCE_MS after the first edge: the level has settled by now
+static int64_t HOT_FUNC(settle_alarm)(alarm_id_t id, void *user_data) {
+    (void)id;
+    input_t *in = user_data;
+    const bool level = gpio_get(in->gpio);
+    update_state(in, !level); // Active low
+
+    // Edges seen during the debounce window are stale, listen again
+    gpio_acknowledge_irq(in->gpio, EDGES);
+    gpio_set_irq_enabled(in->gpio, EDGES, true);
+    // An edge between sampling and unmasking would be lost, so check once more
+    if (gpio_get(in->gpio) != level)
+        gpio_irq(in->gpio, EDGES);
+    return 0; // One-shot
+}
+
+// First edge of a bounce burst: mask the pin and let the alarm do the rest
+static void HOT_FUNC(gpio_irq)(const uint gpio, const uint32_t event_mask) {
+    (void)event_mask;
+    LATENCY_ENTER();
+    input_t *in = find_input(gpio);
+    if (in != NULL) {
+        gpio_set_irq_enabled(gpio, EDGES, false);
+        if (add_alarm_in_ms(DEBOUNCE_MS, settle_alarm, in, true) < 0)
+            gpio_set_irq_enabled(gpio, EDGES, true); // No alarm slot, retry on the next edge
+    }
+    LATENCY_EXIT();
+}
+
+void debounce_init(const button_handler_t handler) {
+    button_handler = handler;
+}
+
+bool debounce_add(const uint gpio) {
+    if (input_count >= DEBOUNCE_MAX_INPUTS)
+        return false;
+    input_t *in = &inputs[input_count++];
+    in->gpio = gpio;
+    in->long_alarm = 0;
+    in->click_alarm = 0;
+
+    gpio_init(gpio); // Initialize GPIO pin
+    gpio_set_dir(gpio, GPIO_IN); // Set as input
+    gpio_pull_up(gpio); // Enable internal pull-up resistor (button reads high = true when not pressed)
+    in->pressed = !gpio_get(gpio);
+
+    // The callback is shared by all GPIOs of this core
+    gpio_set_irq_enabled_with_callback(gpio, EDGES, true, &gpio_irq);
+    return true;
+}
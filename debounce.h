@@ -0,0 +1,33 @@
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+// Timer based debouncing for active-low buttons. The GPIO interrupt only masks
+// the pin and arms an alarm; the alarm callback samples the settled level and
+// reports press, release, long-press and double-press actions. Each press
+// gives exactly one of BUTTON_PRESS, BUTTON_LONG_PRESS or BUTTON_DOUBLE_PRESS
+// (for the second half of a double), so a short press is only reported once
+// DOUBLE_PRESS_MS passed without a second one.
+
+#define DEBOUNCE_MS 20 // Time the level must settle after an edge
+#define LONG_PRESS_MS 1000 // Held this long -> BUTTON_LONG_PRESS
+#define DOUBLE_PRESS_MS 300 // Pressed again within this time after a short press -> BUTTON_DOUBLE_PRESS
+#define DEBOUNCE_MAX_INPUTS 4
+
+typedef enum {
+    BUTTON_RELEASE = 0, // Sent right away, for every press
+    BUTTON_PRESS = 1, // Single short press, sent DOUBLE_PRESS_MS after its release
+    BUTTON_LONG_PRESS = 2, // Sent while still held, instead of the press
+    BUTTON_DOUBLE_PRESS = 3 // Sent right after the second press, the first one is not reported
+} button_action_t;
+
+// Called from the alarm interrupt, must be interrupt safe (e.g. event_queue_add)
+typedef void (*button_handler_t)(uint gpio, button_action_t action);
+
+void debounce_init(button_handler_t handler); // Set the handler for all inputs
+bool debounce_add(uint gpio); // Configure gpio as pulled-up input and start watching it
+
+#endif
@@ -0,0 +1,80 @@
+#include "dormant.h"
+#include "sysclk.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/pll.h"
+#include "hardware/uart.h"
+#include "hardware/xosc.h"
+#include "hardware/structs/rosc.h"
+
+// Dormant mode stops the crystal oscillator, so everything has to run from it
+// (not from a PLL) when it is entered. On wake-up the PLLs are started again,
+// clk_sys is returned to the saved frequency and the UART dividers, which
+// depend on clk_peri, are reprogrammed. The byte whose start bit woke the chip
+// from a module's RX line is lost; the module's next line arrives intact.
+
+#define XOSC_HZ (XOSC_KHZ * 1000)
+
+static uint64_t dormant_now_us(void *ctx) {
+    (void)ctx;
+    return time_us_64();
+}
+
+static void dormant_save(void *ctx, power_state_t *state) {
+    (void)ctx;
+    state->sys_hz = clock_get_hz(clk_sys);
+    for (uint i = 0; i < POWER_UARTS; i++) {
+        uart_inst_t *uart = uart_get_instance(i);
+        state->uart_baud[i] = uart_is_enabled(uart) ? sysclk_uart_baud(uart) : 0;
+        // Let queued console output leave before the clocks change
+        if (state->uart_baud[i])
+            uart_tx_wait_blocking(uart);
+    }
+}
+
+static void dormant_enter(void *ctx, const uint32_t *wake_pins, const size_t count) {
+    (void)ctx;
+    // Everything from the crystal, PLLs and ring oscillator off
+    clock_configure(clk_ref, CLOCKS_CLK_REF_CTRL_SRC_VALUE_XOSC_CLKSRC, 0, XOSC_HZ, XOSC_HZ);
+    clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF, 0, XOSC_HZ, XOSC_HZ);
+    clock_stop(clk_usb);
+    clock_stop(clk_adc);
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS, XOSC_HZ, XOSC_HZ);
+    pll_deinit(pll_sys);
+    pll_deinit(pll_usb);
+    rosc_hw->ctrl = (rosc_hw->ctrl & ~ROSC_CTRL_ENABLE_BITS) | (ROSC_CTRL_ENABLE_VALUE_DISABLE << ROSC_CTRL_ENABLE_LSB);
+
+    for (size_t i = 0; i < count; i++)
+        gpio_set_dormant_irq_enabled(wake_pins[i], GPIO_IRQ_EDGE_FALL, true);
+    xosc_dormant(); // Returns once a wake edge restarted the crystal
+    for (size_t i = 0; i < count; i++) {
+        gpio_acknowledge_irq(wake_pins[i], GPIO_IRQ_EDGE_FALL);
+        gpio_set_dormant_irq_enabled(wake_pins[i], GPIO_IRQ_EDGE_FALL, false);
+    }
+}
+
+static void dormant_restore(void *ctx, const power_state_t *state) {
+    (void)ctx;
+    rosc_hw->ctrl = (rosc_hw->ctrl & ~ROSC_CTRL_ENABLE_BITS) | (ROSC_CTRL_ENABLE_VALUE_ENABLE << ROSC_CTRL_ENABLE_LSB);
+    clocks_init(); // PLLs and the boot clock tree
+    if (clock_get_hz(clk_sys) != state->sys_hz)
+        set_sys_clock_khz(state->sys_hz / 1000, true);
+    // clk_peri may have changed, so recompute every divider
+    for (uint i = 0; i < POWER_UARTS; i++) {
+        if (state->uart_baud[i])
+            uart_set_baudrate(uart_get_instance(i), state->uart_baud[i]);
+    }
+}
+
+static const power_ops_t ops = {
+    .save = dormant_save,
+    .dormant = dormant_enter,
+    .restore = dormant_restore,
+    .now_us = dormant_now_us,
+    .ctx = NULL
+};
+
+const power_ops_t *dormant_get(void) {
+    return &ops;
+}
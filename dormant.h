@@ -0,0 +1,8 @@
+#ifndef DORMANT_H
+#define DORMANT_H
+
+#include "power.h"
+
+const power_ops_t *dormant_get(void); // RP2040 dormant mode backend for power_t
+
+#endif
@@ -0,0 +1,220 @@
+#include "downlink.h"
+#include "hex.h"
+#include "hot.h"
+
+#define DOWNLINK_PREFIX "+MSG" // Also matches "+MSGHEX"
+#define DOWNLINK_PREFIX_LEN 4
+
+enum {
+    STATE_START, // Matching the prefix at the start of a line
+    STATE_HEADER, // Between the prefix and the first ':'
+    STATE_FIELDS, // Between tokens
+    STATE_WORD, // Inside a word such as PORT or RSSI
+    STATE_NUMBER, // Inside an integer value
+    STATE_FRACTION, // Decimals after the integer part, skipped
+    STATE_HEX, // Inside the quoted RX payload
+    STATE_SKIP // Not a report line, wait for the next one
+};
+
+enum { FIELD_NONE, FIELD_PORT, FIELD_RX, FIELD_RSSI, FIELD_SNR };
+
+// Words are compared as packed integers instead of strings
+#define WORD2(a, b) ((uint64_t)(a) << 8 | (uint64_t)(b))
+#define WORD3(a, b, c) (WORD2(a, b) << 8 | (uint64_t)(c))
+#define WORD4(a, b, c, d) (WORD3(a, b, c) << 8 | (uint64_t)(d))
+#define WORD5(a, b, c, d, e) (WORD4(a, b, c, d) << 8 | (uint64_t)(e))
+#define WORD6(a, b, c, d, e, f) (WORD5(a, b, c, d, e) << 8 | (uint64_t)(f))
+
+#define WORD_PORT WORD4('P', 'O', 'R', 'T')
+#define WORD_RX WORD2('R', 'X')
+#define WORD_RSSI WORD4('R', 'S', 'S', 'I')
+#define WORD_SNR WORD3('S', 'N', 'R')
+#define WORD_DONE WORD4('D', 'O', 'N', 'E')
+#define WORD_ERROR WORD5('E', 'R', 'R', 'O', 'R')
+#define WORD_PLEASE WORD6('P', 'L', 'E', 'A', 'S', 'E') // "Please join network first"
+#define WORD_BUSY WORD4('B', 'U', 'S', 'Y') // "LoRaWAN modem is busy"
+
+static bool HOT_FUNC(is_letter)(const char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+static bool HOT_FUNC(is_digit)(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int16_t HOT_FUNC(clamp16)(const int32_t v) {
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+void downlink_begin(downlink_t *dl, uint8_t *payload, const size_t capacity) {
+    dl->payload = payload;
+    dl->capacity = capacity;
+    dl->len = 0;
+    dl->port = -1;
+    dl->rssi = 0;
+    dl->snr = 0;
+    dl->flags = 0;
+    dl->state = STATE_START;
+    dl->pos = 0;
+    dl->event = DOWNLINK_NONE;
+}
+
+static void HOT_FUNC(end_word)(downlink_t *dl) {
+    dl->field = FIELD_NONE;
+    if (dl->word_len > 8)
+        return; // Longer than any keyword
+    switch (dl->word) {
+        case WORD_PORT: dl->field = FIELD_PORT; break;
+        case WORD_RX: dl->field = FIELD_RX; break;
+        case WORD_RSSI: dl->field = FIELD_RSSI; break;
+        case WORD_SNR: dl->field = FIELD_SNR; break;
+        case WORD_DONE: dl->event = DOWNLINK_DONE; break;
+        case WORD_ERROR:
+        case WORD_PLEASE:
+        case WORD_BUSY: dl->flags |= DOWNLINK_FAILED; break;
+        default: break;
+    }
+}
+
+static void HOT_FUNC(end_number)(downlink_t *dl) {
+    const int16_t value = clamp16(dl->negative ? -dl->number : dl->number);
+    switch (dl->field) {
+        case FIELD_PORT: dl->port = value; break;
+        case FIELD_RSSI: dl->rssi = value; dl->flags |= DOWNLINK_HAS_RSSI; break;
+        case FIELD_SNR: dl->snr = value; dl->flags |= DOWNLINK_HAS_SNR; break;
+        default: break;
+    }
+    dl->field = FIELD_NONE;
+}
+
+// Finish whatever token the line ended in and report what the line contained
+static downlink_event_t HOT_FUNC(end_line)(downlink_t *dl) {
+    downlink_event_t event = DOWNLINK_NONE;
+    switch (dl->state) {
+        case STATE_WORD: end_word(dl); break;
+        case STATE_NUMBER:
+        case STATE_FRACTION: end_number(dl); break;
+        case STATE_HEX: dl->flags |= DOWNLINK_BAD_HEX; break; // Missing closing quote
+        default: break;
+    }
+    if (dl->state != STATE_START && dl->state != STATE_SKIP)
+        event = dl->event != DOWNLINK_NONE ? (downlink_event_t)dl->event : DOWNLINK_LINE;
+    dl->state = STATE_START;
+    dl->pos = 0;
+    dl->event = DOWNLINK_NONE;
+    return event;
+}
+
+static void HOT_FUNC(start_token)(downlink_t *dl, const char c) {
+    if (is_letter(c)) {
+        dl->word = (uint64_t)(c >= 'a' ? c - ('a' - 'A') : c);
+        dl->word_len = 1;
+        dl->state = STATE_WORD;
+    }
+    else if ((is_digit(c) || c == '-') && dl->field != FIELD_NONE && dl->field != FIELD_RX) {
+        dl->negative = c == '-';
+        dl->number = dl->negative ? 0 : c - '0';
+        dl->state = STATE_NUMBER;
+    }
+    else if (c == '"' && dl->field == FIELD_RX) {
+        dl->len = 0;
+        dl->high_nibble = -1;
+        dl->flags &= (uint8_t)~(DOWNLINK_HAS_PAYLOAD | DOWNLINK_OVERFLOW | DOWNLINK_BAD_HEX);
+        // A second RX field on the line replaces the payload an earlier one reported
+        if (dl->event == DOWNLINK_PAYLOAD)
+            dl->event = DOWNLINK_NONE;
+        dl->state = STATE_HEX;
+    }
+    // Spaces, ':', ';' and ',' only separate tokens
+}
+
+downlink_event_t HOT_FUNC(downlink_feed)(downlink_t *dl, const char c) {
+    if (c == '\n')
+        return end_line(dl);
+
+    switch (dl->state) {
+        case STATE_START:
+            if (c == DOWNLINK_PREFIX[dl->pos]) {
+                if (++dl->pos == DOWNLINK_PREFIX_LEN)
+                    dl->state = STATE_HEADER;
+            }
+            else if (c != '\r')
+                dl->state = STATE_SKIP;
+            break;
+
+        case STATE_HEADER:
+            if (c == ':') {
+                dl->field = FIELD_NONE;
+                dl->state = STATE_FIELDS;
+            }
+            break;
+
+        case STATE_FIELDS:
+            start_token(dl, c);
+            break;
+
+        case STATE_WORD:
+            if (is_letter(c) || is_digit(c)) {
+                if (dl->word_len++ < 8)
+                    dl->word = dl->word << 8 | (uint64_t)(c >= 'a' ? c - ('a' - 'A') : c);
+            }
+            else {
+                end_word(dl);
+                dl->state = STATE_FIELDS;
+                start_token(dl, c);
+            }
+            break;
+
+        case STATE_NUMBER:
+            if (is_digit(c)) {
+                if (dl->number < 100000) // Saturates well above any int16 field
+                    dl->number = dl->number * 10 + (c - '0');
+            }
+            else if (c == '.')
+                dl->state = STATE_FRACTION;
+            else {
+                end_number(dl);
+                dl->state = STATE_FIELDS;
+                start_token(dl, c);
+            }
+            break;
+
+        case STATE_FRACTION:
+            if (!is_digit(c)) {
+                end_number(dl);
+                dl->state = STATE_FIELDS;
+                start_token(dl, c);
+            }
+            break;
+
+        case STATE_HEX:
+            if (c == '"') {
+                if (dl->high_nibble >= 0)
+                    dl->flags |= DOWNLINK_BAD_HEX; // Odd number of digits
+                dl->flags |= DOWNLINK_HAS_PAYLOAD;
+                dl->event = DOWNLINK_PAYLOAD;
+                dl->field = FIELD_NONE;
+                dl->state = STATE_FIELDS;
+            }
+            else {
+                const int nibble = hex_nibble(c);
+                if (nibble < 0)
+                    dl->flags |= DOWNLINK_BAD_HEX;
+                else if (dl->high_nibble < 0)
+                    dl->high_nibble = (int8_t)nibble;
+                else {
+                    // Decode in place into the caller's buffer as soon as a byte is complete
+                    if (dl->len < dl->capacity)
+                        dl->payload[dl->len++] = (uint8_t)(dl->high_nibble << 4 | nibble);
+                    else
+                        dl->flags |= DOWNLINK_OVERFLOW;
+                    dl->high_nibble = -1;
+                }
+            }
+            break;
+
+        default: // STATE_SKIP
+            break;
+    }
+    return DOWNLINK_NONE;
+}
@@ -0,0 +1,57 @@
+#ifndef DOWNLINK_H
+#define DOWNLINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Incremental parser for the module's "+MSG:"/"+MSGHEX:" report lines, e.g.
+//   +MSGHEX: PORT: 1; RX: "A1B2C3"
+//   +MSGHEX: RXWIN1, RSSI -106, SNR 4.5
+//   +MSGHEX: Done
+// Bytes are fed one at a time as they come off the UART. The hex payload is
+// decoded straight into a caller-provided buffer and numeric fields are kept as
+// integers, so no line buffer or intermediate strings are needed.
+
+// Flags describing what has been seen during the current transaction
+#define DOWNLINK_HAS_PAYLOAD 0x01 // RX field received, payload/len valid
+#define DOWNLINK_HAS_RSSI 0x02
+#define DOWNLINK_HAS_SNR 0x04
+#define DOWNLINK_FAILED 0x08 // Module reported an error (not joined, busy, ...)
+#define DOWNLINK_OVERFLOW 0x10 // Payload longer than the buffer, extra bytes dropped
+#define DOWNLINK_BAD_HEX 0x20 // Non-hex character or odd digit count in RX field
+
+// Result of feeding one byte
+typedef enum {
+    DOWNLINK_NONE, // Nothing completed yet
+    DOWNLINK_LINE, // A report line without payload was completed
+    DOWNLINK_PAYLOAD, // A line with an RX payload was completed
+    DOWNLINK_DONE // "Done" line, end of the transaction
+} downlink_event_t;
+
+typedef struct {
+    // Results, valid according to flags
+    uint8_t *payload; // Caller's buffer
+    size_t capacity;
+    size_t len;
+    int16_t port;
+    int16_t rssi; // dBm
+    int16_t snr; // dB, fraction discarded
+    uint8_t flags;
+
+    // Parser state
+    uint8_t state;
+    uint8_t event; // Event to report when the line ends
+    uint8_t pos; // Characters matched of the "+MSG" prefix
+    uint8_t word_len;
+    uint64_t word; // Current word packed in upper case, first 8 characters
+    uint8_t field; // Field the next value belongs to
+    bool negative;
+    int32_t number;
+    int8_t high_nibble; // -1 when no digit is pending
+} downlink_t;
+
+void downlink_begin(downlink_t *dl, uint8_t *payload, size_t capacity); // Reset for a new transaction
+downlink_event_t downlink_feed(downlink_t *dl, char c); // Consume one received character
+
+#endif
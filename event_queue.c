@@ -0,0 +1,116 @@
+#include "event_queue.h"
+#include "hot.h"
+
+#define NIL 0xFF // End of a slot list
+
+void event_queue_init(event_queue_t *q) {
+    critical_section_init(&q->lock);
+    for (int i = 0; i < EVENT_QUEUE_LEN; i++)
+        q->next[i] = i + 1 < EVENT_QUEUE_LEN ? (uint8_t)(i + 1) : NIL;
+    q->free_head = 0;
+    for (int p = 0; p < EVENT_PRIO_COUNT; p++) {
+        q->head[p] = NIL;
+        q->tail[p] = NIL;
+    }
+    for (int t = 0; t < EVENT_TYPE_COUNT; t++) {
+        q->priority[t] = EVENT_PRIO_NORMAL;
+        q->coalesce[t] = false;
+    }
+    q->pending = 0;
+    q->high_water = 0;
+    q->dropped = 0;
+    q->coalesced = 0;
+}
+
+void event_queue_configure(event_queue_t *q, const event_type type, const event_prio_t priority, const bool coalesce) {
+    q->priority[type] = (uint8_t)priority;
+    q->coalesce[type] = coalesce;
+}
+
+// Remove the newest event of the lowest priority below prio, returning its slot
+static uint8_t HOT_FUNC(evict_below)(event_queue_t *q, const int prio) {
+    for (int p = EVENT_PRIO_COUNT - 1; p > prio; p--) {
+        const uint8_t victim = q->tail[p];
+        if (victim == NIL)
+            continue;
+        // Lists are singly linked, find the element in front of the tail
+        if (q->head[p] == victim) {
+            q->head[p] = NIL;
+            q->tail[p] = NIL;
+        }
+        else {
+            uint8_t i = q->head[p];
+            while (q->next[i] != victim)
+                i = q->next[i];
+            q->next[i] = NIL;
+            q->tail[p] = i;
+        }
+        q->pending--;
+        return victim;
+    }
+    return NIL;
+}
+
+bool HOT_FUNC(event_queue_add)(event_queue_t *q, const event_t *event) {
+    bool added = false;
+    critical_section_enter_blocking(&q->lock);
+    const int prio = q->priority[event->type];
+
+    if (q->coalesce[event->type]) {
+        for (uint8_t i = q->head[prio]; i != NIL; i = q->next[i]) {
+            if (q->slots[i].type == event->type && q->slots[i].data == event->data) {
+                q->coalesced++;
+                critical_section_exit(&q->lock);
+                return true; // Already pending, nothing new to deliver
+            }
+        }
+    }
+
+    uint8_t slot = q->free_head;
+    if (slot != NIL)
+        q->free_head = q->next[slot];
+    else {
+        slot = evict_below(q, prio);
+        if (slot != NIL)
+            q->dropped++; // Evicted event is lost instead of the new one
+    }
+
+    if (slot != NIL) {
+        q->slots[slot] = *event;
+        q->next[slot] = NIL;
+        if (q->tail[prio] == NIL)
+            q->head[prio] = slot;
+        else
+            q->next[q->tail[prio]] = slot;
+        q->tail[prio] = slot;
+        if (++q->pending > q->high_water)
+            q->high_water = q->pending;
+        added = true;
+    }
+    else
+        q->dropped++;
+
+    critical_section_exit(&q->lock);
+    return added;
+}
+
+bool event_queue_remove(event_queue_t *q, event_t *event) {
+    bool removed = false;
+    critical_section_enter_blocking(&q->lock);
+    for (int p = 0; p < EVENT_PRIO_COUNT; p++) {
+        const uint8_t slot = q->head[p];
+        if (slot == NIL)
+            continue;
+        *event = q->slots[slot];
+        q->head[p] = q->next[slot];
+        if (q->head[p] == NIL)
+            q->tail[p] = NIL;
+        q->next[slot] = q->free_head;
+        q->free_head = slot;
+        q->pending--;
+        removed = true;
+        break;
+    }
+    critical_section_exit(&q->lock);
+    return removed;
+}
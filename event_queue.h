@@ -0,0 +1,57 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/sync.h"
+
+// Fixed-size event queue between interrupt handlers and the main loop.
+// Every event type has a priority: higher priorities are delivered first and
+// may evict the newest low-priority event when the queue is full. Types can be
+// marked as coalescing, so an event identical to one still pending is counted
+// instead of stored. This keeps an interrupt storm from flooding the loop.
+
+#define EVENT_QUEUE_LEN 32 // Total number of pending events, at most 255
+
+// Type of event delivered to the main loop
+typedef enum {
+    EVENT_BUTTON, // Debounced button action
+    EVENT_TIMER, // Software timer expired
+    EVENT_UART_LINE, // Unsolicited line received from a module
+    EVENT_CONSOLE, // Characters typed on the console
+    EVENT_USER, // Application defined
+    EVENT_TYPE_COUNT
+} event_type;
+
+// Generic event passed from ISR to main loop through the queue
+typedef struct {
+    event_type type;
+    int32_t data; // BUTTON: button_action_t (1 = press, 0 = release, 2 = long press, 3 = double press)
+                  // TIMER: timer id, UART_LINE: module index, CONSOLE: unused, USER: application defined
+} event_t;
+
+typedef enum { EVENT_PRIO_HIGH, EVENT_PRIO_NORMAL, EVENT_PRIO_LOW, EVENT_PRIO_COUNT } event_prio_t;
+
+typedef struct {
+    critical_section_t lock;
+    event_t slots[EVENT_QUEUE_LEN];
+    uint8_t next[EVENT_QUEUE_LEN]; // Links slots into per-priority FIFOs and the free list
+    uint8_t head[EVENT_PRIO_COUNT]; // Oldest pending event of each priority
+    uint8_t tail[EVENT_PRIO_COUNT]; // Newest pending event of each priority
+    uint8_t free_head;
+    uint8_t priority[EVENT_TYPE_COUNT];
+    bool coalesce[EVENT_TYPE_COUNT];
+
+    // Statistics
+    uint32_t pending;
+    uint32_t high_water; // Largest number of events pending at once
+    uint32_t dropped; // Events lost because the queue was full (incl. evicted ones)
+    uint32_t coalesced; // Events merged into an identical pending one
+} event_queue_t;
+
+void event_queue_init(event_queue_t *q); // All types normal priority, no coalescing
+void event_queue_configure(event_queue_t *q, event_type type, event_prio_t priority, bool coalesce);
+bool event_queue_add(event_queue_t *q, const event_t *event); // Interrupt safe, false if the event was dropped
+bool event_queue_remove(event_queue_t *q, event_t *event); // Highest priority first, FIFO within a priority
+
+#endif
@@ -0,0 +1,279 @@
+#include "flash_queue.h"
+#include <string.h>
+
+#define FQ_MAGIC 0x5146 // "FQ", marks a programmed slot
+#define FQ_STATE_PENDING 0xFF // Left erased when the record is written
+#define FQ_STATE_CONSUMED 0x00 // Cleared in place once the record is sent
+#define FQ_SLOTS_PER_PAGE (FQ_PAGE_SIZE / FQ_SLOT_SIZE)
+
+// Slot layout: magic(2) len(1) state(1) seq(4) crc(4) payload(len)
+typedef struct {
+    uint16_t magic;
+    uint8_t len;
+    uint8_t state;
+    uint32_t seq;
+    uint32_t crc;
+} fq_header_t;
+
+// CRC-32 (IEEE), nibble table keeps it at 64 bytes of flash
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return crc;
+}
+
+static uint32_t record_crc(uint32_t seq, uint8_t len, const uint8_t *payload) {
+    const uint8_t meta[5] = { (uint8_t)seq, (uint8_t)(seq >> 8), (uint8_t)(seq >> 16), (uint8_t)(seq >> 24), len };
+    uint32_t crc = crc32_update(0xFFFFFFFF, meta, sizeof(meta));
+    crc = crc32_update(crc, payload, len);
+    return ~crc;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put_u32(uint8_t *p, const uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void read_slot(const flash_queue_t *q, const uint32_t slot, uint8_t *raw, fq_header_t *hdr) {
+    q->storage->read(q->storage->ctx, slot * FQ_SLOT_SIZE, raw, FQ_SLOT_SIZE);
+    hdr->magic = (uint16_t)(raw[0] | raw[1] << 8);
+    hdr->len = raw[2];
+    hdr->state = raw[3];
+    hdr->seq = get_u32(&raw[4]);
+    hdr->crc = get_u32(&raw[8]);
+}
+
+// A slot holds a complete record if the magic and CRC match (torn writes fail the CRC)
+static bool slot_is_valid(const uint8_t *raw, const fq_header_t *hdr) {
+    return hdr->magic == FQ_MAGIC && hdr->len <= FQ_PAYLOAD_MAX &&
+        record_crc(hdr->seq, hdr->len, &raw[FQ_HEADER_SIZE]) == hdr->crc;
+}
+
+static bool slot_is_pending(const flash_queue_t *q, const uint32_t slot) {
+    uint8_t raw[FQ_SLOT_SIZE];
+    fq_header_t hdr;
+    read_slot(q, slot, raw, &hdr);
+    return slot_is_valid(raw, &hdr) && hdr.state == FQ_STATE_PENDING;
+}
+
+static bool slot_is_blank(const flash_queue_t *q, const uint32_t slot) {
+    uint8_t raw[FQ_SLOT_SIZE];
+    q->storage->read(q->storage->ctx, slot * FQ_SLOT_SIZE, raw, FQ_SLOT_SIZE);
+    for (int i = 0; i < FQ_SLOT_SIZE; i++) {
+        if (raw[i] != 0xFF)
+            return false;
+    }
+    return true;
+}
+
+// Program one slot. The rest of the page is padded with 0xFF, which leaves
+// the neighbouring slots untouched because programming can only clear bits.
+static void program_slot(const flash_queue_t *q, const uint32_t slot, const uint8_t *raw) {
+    uint8_t page[FQ_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    memcpy(&page[(slot % FQ_SLOTS_PER_PAGE) * FQ_SLOT_SIZE], raw, FQ_SLOT_SIZE);
+    q->storage->program(q->storage->ctx, (slot / FQ_SLOTS_PER_PAGE) * FQ_PAGE_SIZE, page);
+}
+
+static uint32_t next_slot(const flash_queue_t *q, const uint32_t slot) {
+    return slot + 1 < q->slot_count ? slot + 1 : 0;
+}
+
+// True if slot lies in the pending span [tail, head) of the ring
+static bool in_pending_span(const flash_queue_t *q, const uint32_t slot) {
+    const uint32_t n = q->slot_count;
+    return (slot + n - q->tail) % n < (q->head + n - q->tail) % n;
+}
+
+static bool sector_has_pending(const flash_queue_t *q, const uint32_t sector) {
+    const uint32_t first = sector * FQ_SLOTS_PER_SECTOR;
+    if (q->pending == 0)
+        return false;
+    // Two arcs of the ring overlap if either one contains the start of the other
+    return in_pending_span(q, first) || (q->tail / FQ_SLOTS_PER_SECTOR == sector);
+}
+
+// First pending record at or after slot, or head if there is none
+static uint32_t find_pending(const flash_queue_t *q, uint32_t slot) {
+    while (slot != q->head) {
+        if (slot_is_pending(q, slot))
+            return slot;
+        slot = next_slot(q, slot);
+    }
+    return q->head;
+}
+
+static void erase_sector(flash_queue_t *q, const uint32_t sector) {
+    q->storage->erase(q->storage->ctx, sector * FQ_SECTOR_SIZE);
+    q->erases++;
+}
+
+// Make the sector at head writable. If the ring is full, the oldest records
+// living in that sector are given up so that new readings are never refused.
+static void enter_sector(flash_queue_t *q) {
+    const uint32_t sector = q->head / FQ_SLOTS_PER_SECTOR;
+    if (q->clean_sector == (int32_t)sector) {
+        q->clean_sector = -1;
+        return;
+    }
+    if (sector_has_pending(q, sector)) {
+        const uint32_t first = sector * FQ_SLOTS_PER_SECTOR;
+        for (uint32_t i = first; i < first + FQ_SLOTS_PER_SECTOR; i++) {
+            if (slot_is_pending(q, i)) {
+                q->pending--;
+                q->dropped++;
+            }
+        }
+        erase_sector(q, sector);
+        if (q->tail / FQ_SLOTS_PER_SECTOR == sector)
+            q->tail = q->pending ? find_pending(q, (first + FQ_SLOTS_PER_SECTOR) % q->slot_count) : q->head;
+    }
+    else
+        erase_sector(q, sector);
+}
+
+void flash_queue_mount(flash_queue_t *q, const fq_storage_t *storage) {
+    memset(q, 0, sizeof(*q));
+    q->storage = storage;
+    q->slot_count = storage->sector_count * FQ_SLOTS_PER_SECTOR;
+    q->clean_sector = -1;
+
+    // Newest valid record gives the head, oldest pending record gives the tail
+    bool have_newest = false, have_oldest = false;
+    uint32_t newest_seq = 0, oldest_seq = 0;
+    uint8_t raw[FQ_SLOT_SIZE];
+    fq_header_t hdr;
+    for (uint32_t i = 0; i < q->slot_count; i++) {
+        read_slot(q, i, raw, &hdr);
+        if (!slot_is_valid(raw, &hdr)) {
+            if (hdr.magic != 0xFFFF)
+                q->corrupted++;
+            continue;
+        }
+        // Sequence numbers are compared with wrap-around
+        if (!have_newest || (int32_t)(hdr.seq - newest_seq) > 0) {
+            newest_seq = hdr.seq;
+            q->head = next_slot(q, i);
+            have_newest = true;
+        }
+        if (hdr.state == FQ_STATE_PENDING) {
+            q->pending++;
+            if (!have_oldest || (int32_t)(hdr.seq - oldest_seq) < 0) {
+                oldest_seq = hdr.seq;
+                q->tail = i;
+                have_oldest = true;
+            }
+        }
+    }
+    q->next_seq = have_newest ? newest_seq + 1 : 0;
+    if (!have_oldest)
+        q->tail = q->head;
+}
+
+bool flash_queue_append(flash_queue_t *q, const uint8_t *payload, const size_t len) {
+    if (len > FQ_PAYLOAD_MAX)
+        return false;
+
+    // Slots left behind by a torn write cannot be reprogrammed, step over them
+    for (uint32_t tries = 0; tries < q->slot_count; tries++) {
+        if (q->head % FQ_SLOTS_PER_SECTOR == 0)
+            enter_sector(q);
+        else if (!slot_is_blank(q, q->head)) {
+            q->corrupted++;
+            q->head = next_slot(q, q->head);
+            continue;
+        }
+
+        uint8_t raw[FQ_SLOT_SIZE];
+        memset(raw, 0xFF, sizeof(raw));
+        raw[0] = (uint8_t)FQ_MAGIC;
+        raw[1] = (uint8_t)(FQ_MAGIC >> 8);
+        raw[2] = (uint8_t)len;
+        raw[3] = FQ_STATE_PENDING;
+        put_u32(&raw[4], q->next_seq);
+        put_u32(&raw[8], record_crc(q->next_seq, (uint8_t)len, payload));
+        memcpy(&raw[FQ_HEADER_SIZE], payload, len);
+        program_slot(q, q->head, raw);
+
+        if (q->pending == 0)
+            q->tail = q->head;
+        q->pending++;
+        q->next_seq++;
+        q->head = next_slot(q, q->head);
+        return true;
+    }
+    return false;
+}
+
+bool flash_queue_peek(const flash_queue_t *q, uint8_t *payload, size_t *len) {
+    if (q->pending == 0)
+        return false;
+    uint8_t raw[FQ_SLOT_SIZE];
+    fq_header_t hdr;
+    read_slot(q, q->tail, raw, &hdr);
+    memcpy(payload, &raw[FQ_HEADER_SIZE], hdr.len);
+    *len = hdr.len;
+    return true;
+}
+
+void flash_queue_pop(flash_queue_t *q) {
+    if (q->pending == 0)
+        return;
+    // Mark as consumed by clearing the state byte in place (no erase needed)
+    uint8_t raw[FQ_SLOT_SIZE];
+    memset(raw, 0xFF, sizeof(raw));
+    raw[3] = FQ_STATE_CONSUMED;
+    program_slot(q, q->tail, raw);
+
+    q->pending--;
+    q->tail = q->pending ? find_pending(q, next_slot(q, q->tail)) : q->head;
+}
+
+size_t flash_queue_drain(flash_queue_t *q, const fq_handler_t handler, void *ctx, const size_t max_records) {
+    size_t sent = 0;
+    uint8_t payload[FQ_PAYLOAD_MAX];
+    size_t len;
+    while (sent < max_records && flash_queue_peek(q, payload, &len)) {
+        if (!handler(payload, len, ctx))
+            break; // Keep the record, try again on the next drain
+        flash_queue_pop(q);
+        sent++;
+    }
+    return sent;
+}
+
+bool flash_queue_maintain(flash_queue_t *q) {
+    // Sector that head will enter next (its own sector if it sits on a boundary)
+    uint32_t sector = q->head / FQ_SLOTS_PER_SECTOR;
+    if (q->head % FQ_SLOTS_PER_SECTOR != 0)
+        sector = (sector + 1) % q->storage->sector_count;
+    // Nothing to do if already erased, or if erasing now would throw away unsent records
+    if (q->clean_sector == (int32_t)sector || sector_has_pending(q, sector))
+        return false;
+    erase_sector(q, sector);
+    q->clean_sector = (int32_t)sector;
+    return true;
+}
+
+void flash_queue_format(flash_queue_t *q) {
+    for (uint32_t s = 0; s < q->storage->sector_count; s++)
+        erase_sector(q, s);
+    q->head = 0;
+    q->tail = 0;
+    q->pending = 0;
+    q->next_seq = 0; // What flash_queue_mount() would find on the blank region
+    q->clean_sector = 0; // Every sector is blank, the first append needs no erase
+}
@@ -0,0 +1,56 @@
+#ifndef FLASH_QUEUE_H
+#define FLASH_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Persistent store-and-forward queue for pending uplinks.
+// Records are appended to a ring of flash sectors (log-structured), so every
+// sector is erased once per lap of the ring and wear is spread evenly.
+// Each record sits in a fixed 64-byte slot with a sequence number and a CRC-32,
+// which lets the queue be rebuilt after a power loss by scanning the slots.
+
+#define FQ_SECTOR_SIZE 4096 // Erase unit of the QSPI flash
+#define FQ_PAGE_SIZE 256 // Program unit of the QSPI flash
+#define FQ_SLOT_SIZE 64 // One record per slot, 4 slots per page
+#define FQ_SLOTS_PER_SECTOR (FQ_SECTOR_SIZE / FQ_SLOT_SIZE)
+#define FQ_HEADER_SIZE 12 // magic + len + state + seq + crc
+#define FQ_PAYLOAD_MAX (FQ_SLOT_SIZE - FQ_HEADER_SIZE) // 52 bytes of uplink data
+
+// Storage backend used by the queue. Offsets are relative to the start of the
+// queue region. program() is always called with a page-aligned offset and a
+// whole page, erase() with a sector-aligned offset.
+typedef struct {
+    void (*read)(void *ctx, uint32_t offset, uint8_t *dst, size_t len);
+    void (*program)(void *ctx, uint32_t offset, const uint8_t *page);
+    void (*erase)(void *ctx, uint32_t offset);
+    void *ctx;
+    uint32_t sector_count; // Size of the region in sectors, at least 2
+} fq_storage_t;
+
+// Called for every record while draining; return false to stop (e.g. send failed)
+typedef bool (*fq_handler_t)(const uint8_t *payload, size_t len, void *ctx);
+
+typedef struct {
+    const fq_storage_t *storage;
+    uint32_t slot_count; // Total number of slots in the region
+    uint32_t head; // Next free slot
+    uint32_t tail; // Oldest pending slot (== head when empty)
+    uint32_t next_seq; // Sequence number of the next appended record
+    uint32_t pending; // Number of records waiting to be sent
+    int32_t clean_sector; // Sector known to be erased ahead of head, -1 if none
+    uint32_t dropped; // Records overwritten because the ring was full
+    uint32_t corrupted; // Slots skipped because of a bad CRC (torn writes)
+    uint32_t erases; // Sector erases since mount
+} flash_queue_t;
+
+void flash_queue_mount(flash_queue_t *q, const fq_storage_t *storage); // Rebuild state by scanning the region
+bool flash_queue_append(flash_queue_t *q, const uint8_t *payload, size_t len); // O(1) append of one record
+bool flash_queue_peek(const flash_queue_t *q, uint8_t *payload, size_t *len); // Oldest pending record into FQ_PAYLOAD_MAX bytes, false when empty
+void flash_queue_pop(flash_queue_t *q); // Mark the oldest pending record sent
+size_t flash_queue_drain(flash_queue_t *q, fq_handler_t handler, void *ctx, size_t max_records); // Send a batch
+bool flash_queue_maintain(flash_queue_t *q); // Pre-erase the next sector, call while UART RX is idle
+void flash_queue_format(flash_queue_t *q); // Erase the whole region and start empty
+
+#endif
@@ -0,0 +1,83 @@
+#include "flash_storage.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#ifdef LORA_FREERTOS
+#include "pico/flash.h"
+#endif
+
+// Queue region is placed at the very end of flash, away from the program image
+#define FLASH_STORAGE_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_STORAGE_SECTORS * FLASH_SECTOR_SIZE)
+
+// Flash is memory mapped through XIP, so reading is a plain copy
+static void storage_read(void *ctx, const uint32_t offset, uint8_t *dst, const size_t len) {
+    (void)ctx;
+    memcpy(dst, (const uint8_t *)(XIP_BASE + FLASH_STORAGE_OFFSET + offset), len);
+}
+
+// XIP is unavailable while flash is programmed or erased, so these run from RAM
+// with interrupts disabled (an ISR fetching code from flash would hang the chip).
+// The UART keeps receiving into its 32-byte hardware FIFO meanwhile, which is
+// about 33 ms at 9600 baud: plenty for a page program (< 1 ms) but not for every
+// sector erase, which is why erases are done ahead of time by flash_queue_maintain().
+#ifdef LORA_FREERTOS
+// With the SMP scheduler the other core keeps executing from flash, so the
+// operation goes through flash_safe_execute(), which parks that core in RAM.
+#define FLASH_SAFE_TIMEOUT_MS 100 // Waiting for the other core to park
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *page;
+} flash_op_t;
+
+static void __not_in_flash_func(do_program)(void *param) {
+    const flash_op_t *op = param;
+    flash_range_program(FLASH_STORAGE_OFFSET + op->offset, op->page, FLASH_PAGE_SIZE);
+}
+
+static void __not_in_flash_func(do_erase)(void *param) {
+    const flash_op_t *op = param;
+    flash_range_erase(FLASH_STORAGE_OFFSET + op->offset, FLASH_SECTOR_SIZE);
+}
+
+static void storage_program(void *ctx, const uint32_t offset, const uint8_t *page) {
+    (void)ctx;
+    flash_op_t op = { .offset = offset, .page = page };
+    if (flash_safe_execute(do_program, &op, FLASH_SAFE_TIMEOUT_MS) != PICO_OK)
+        panic("Flash program at %u failed", (unsigned)offset);
+}
+
+static void storage_erase(void *ctx, const uint32_t offset) {
+    (void)ctx;
+    flash_op_t op = { .offset = offset, .page = NULL };
+    if (flash_safe_execute(do_erase, &op, FLASH_SAFE_TIMEOUT_MS) != PICO_OK)
+        panic("Flash erase at %u failed", (unsigned)offset);
+}
+#else
+static void __not_in_flash_func(storage_program)(void *ctx, const uint32_t offset, const uint8_t *page) {
+    (void)ctx;
+    const uint32_t ints = save_and_disable_interrupts();
+    flash_range_program(FLASH_STORAGE_OFFSET + offset, page, FLASH_PAGE_SIZE);
+    restore_interrupts(ints);
+}
+
+static void __not_in_flash_func(storage_erase)(void *ctx, const uint32_t offset) {
+    (void)ctx;
+    const uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(FLASH_STORAGE_OFFSET + offset, FLASH_SECTOR_SIZE);
+    restore_interrupts(ints);
+}
+#endif
+
+static const fq_storage_t storage = {
+    .read = storage_read,
+    .program = storage_program,
+    .erase = storage_erase,
+    .ctx = NULL,
+    .sector_count = FLASH_STORAGE_SECTORS
+};
+
+const fq_storage_t *flash_storage_get(void) {
+    return &storage;
+}
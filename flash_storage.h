@@ -0,0 +1,10 @@
+#ifndef FLASH_STORAGE_H
+#define FLASH_STORAGE_H
+
+#include "flash_queue.h"
+
+#define FLASH_STORAGE_SECTORS 16 // 64 KB at the end of flash reserved for the uplink queue
+
+const fq_storage_t *flash_storage_get(void); // RP2040 QSPI flash backend for flash_queue
+
+#endif
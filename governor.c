@@ -0,0 +1,56 @@
+#include "governor.h"
+#include <string.h>
+
+static const uint32_t level_khz[GOVERNOR_LEVELS] = GOVERNOR_KHZ;
+static const uint32_t level_current_ua[GOVERNOR_LEVELS] = GOVERNOR_CURRENT_UA;
+
+void governor_init(governor_t *g, const uint32_t now_ms) {
+    memset(g, 0, sizeof(*g));
+    g->last_busy_ms = now_ms;
+    g->last_update_ms = now_ms;
+}
+
+uint8_t governor_update(governor_t *g, const bool busy, const uint32_t now_ms) {
+    // Charge the time since the last update to the level that was running
+    const uint32_t elapsed_ms = now_ms - g->last_update_ms;
+    // uA * mV * ms = pJ, / 1000 = nJ
+    const uint64_t energy_nj = (uint64_t)level_current_ua[g->level] * GOVERNOR_SUPPLY_MV * elapsed_ms / 1000;
+    g->time_ms[g->level] += elapsed_ms;
+    g->energy_nj += energy_nj;
+    if (busy)
+        g->busy_energy_nj += energy_nj;
+    g->last_update_ms = now_ms;
+
+    uint8_t level = g->level;
+    if (busy) {
+        g->last_busy_ms = now_ms;
+        level = 0;
+    }
+    else {
+        const uint32_t idle_ms = now_ms - g->last_busy_ms;
+        if (idle_ms >= GOVERNOR_HOLD_MS) {
+            const uint32_t steps = 1 + (idle_ms - GOVERNOR_HOLD_MS) / GOVERNOR_STEP_MS;
+            level = steps < GOVERNOR_LEVELS - 1 ? (uint8_t)steps : GOVERNOR_LEVELS - 1;
+        }
+    }
+    return level;
+}
+
+void governor_set_level(governor_t *g, const uint8_t level) {
+    if (level != g->level) {
+        g->level = level;
+        g->changes++;
+    }
+}
+
+uint32_t governor_khz(const uint8_t level) {
+    return level_khz[level < GOVERNOR_LEVELS ? level : GOVERNOR_LEVELS - 1];
+}
+
+void governor_transaction_done(governor_t *g) {
+    g->transactions++;
+}
+
+uint32_t governor_energy_per_transaction_uj(const governor_t *g) {
+    return g->transactions ? (uint32_t)(g->busy_energy_nj / 1000 / g->transactions) : 0;
+}
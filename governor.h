@@ -0,0 +1,45 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// clk_sys governor. The firmware mostly waits for 9600 baud traffic, so the
+// clock is dropped step by step while nothing is in progress and raised to
+// full speed as soon as a burst starts (probe parsing, uplink drain, flash
+// work). The policy and the energy estimate are plain integer code with no
+// SDK dependency; applying a level is left to the caller (see sysclk.h).
+
+#define GOVERNOR_LEVELS 3
+#define GOVERNOR_HOLD_MS 200 // Stay at full speed this long after a burst
+#define GOVERNOR_STEP_MS 500 // Then drop one level per step
+#define GOVERNOR_SUPPLY_MV 3300
+
+// Frequencies the PLL can produce exactly, fastest first, with the typical
+// supply current at that speed (estimates for the energy figures, not measurements)
+#define GOVERNOR_KHZ { 125000, 48000, 24000 }
+#define GOVERNOR_CURRENT_UA { 25000, 12000, 8000 }
+
+typedef struct {
+    uint8_t level; // 0 is the fastest
+    uint32_t last_busy_ms;
+    uint32_t last_update_ms;
+
+    // Statistics
+    uint32_t changes;
+    uint32_t time_ms[GOVERNOR_LEVELS]; // Time spent at each level
+    uint64_t energy_nj; // Estimated energy since init
+    uint64_t busy_energy_nj; // Part of it spent on bursts
+    uint32_t transactions; // Completed bursts reported by the caller
+} governor_t;
+
+void governor_init(governor_t *g, uint32_t now_ms); // Starts at full speed
+// Level to run at from now on. Only proposed: the caller switches the clock and
+// then reports the level it actually runs at with governor_set_level()
+uint8_t governor_update(governor_t *g, bool busy, uint32_t now_ms);
+void governor_set_level(governor_t *g, uint8_t level);
+uint32_t governor_khz(uint8_t level);
+void governor_transaction_done(governor_t *g); // One probe or uplink finished
+uint32_t governor_energy_per_transaction_uj(const governor_t *g); // Busy energy / transactions
+
+#endif
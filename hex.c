@@ -0,0 +1,53 @@
+#include "hex.h"
+#include "hot.h"
+
+// Encoded byte as two ASCII digits, first digit in the low byte (memory order)
+#define HEX_DIGIT(n) ((n) < 10 ? '0' + (n) : 'A' - 10 + (n))
+#define HEX_PAIR(n) (uint16_t)(HEX_DIGIT((n) >> 4) | HEX_DIGIT((n) & 0x0F) << 8)
+#define HEX_ROW(n) HEX_PAIR(n), HEX_PAIR(n + 1), HEX_PAIR(n + 2), HEX_PAIR(n + 3), \
+    HEX_PAIR(n + 4), HEX_PAIR(n + 5), HEX_PAIR(n + 6), HEX_PAIR(n + 7), \
+    HEX_PAIR(n + 8), HEX_PAIR(n + 9), HEX_PAIR(n + 10), HEX_PAIR(n + 11), \
+    HEX_PAIR(n + 12), HEX_PAIR(n + 13), HEX_PAIR(n + 14), HEX_PAIR(n + 15)
+
+static const uint16_t hex_pairs[256] = {
+    HEX_ROW(0x00), HEX_ROW(0x10), HEX_ROW(0x20), HEX_ROW(0x30),
+    HEX_ROW(0x40), HEX_ROW(0x50), HEX_ROW(0x60), HEX_ROW(0x70),
+    HEX_ROW(0x80), HEX_ROW(0x90), HEX_ROW(0xA0), HEX_ROW(0xB0),
+    HEX_ROW(0xC0), HEX_ROW(0xD0), HEX_ROW(0xE0), HEX_ROW(0xF0)
+};
+
+// Digit value with bit 4 set, 0 for characters that are not hex digits
+static const uint8_t HOT_DATA("hex") hex_values[256] = {
+    ['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14,
+    ['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17, ['8'] = 0x18, ['9'] = 0x19,
+    ['A'] = 0x1A, ['B'] = 0x1B, ['C'] = 0x1C, ['D'] = 0x1D, ['E'] = 0x1E, ['F'] = 0x1F,
+    ['a'] = 0x1A, ['b'] = 0x1B, ['c'] = 0x1C, ['d'] = 0x1D, ['e'] = 0x1E, ['f'] = 0x1F
+};
+
+size_t hex_encode(char *dst, const uint8_t *src, const size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        const uint16_t pair = hex_pairs[src[i]];
+        // Two byte stores: the M0+ faults on unaligned 16-bit accesses
+        *dst++ = (char)pair;
+        *dst++ = (char)(pair >> 8);
+    }
+    return len * 2;
+}
+
+int HOT_FUNC(hex_nibble)(const char c) {
+    const uint8_t v = hex_values[(uint8_t)c];
+    return v ? v & 0x0F : -1;
+}
+
+int hex_decode(uint8_t *dst, const size_t dst_len, const char *src, const size_t src_len) {
+    if (src_len % 2 != 0 || src_len / 2 > dst_len)
+        return -1;
+    for (size_t i = 0; i < src_len; i += 2) {
+        const uint8_t hi = hex_values[(uint8_t)src[i]];
+        const uint8_t lo = hex_values[(uint8_t)src[i + 1]];
+        if (!hi || !lo)
+            return -1;
+        *dst++ = (uint8_t)((hi & 0x0F) << 4 | (lo & 0x0F));
+    }
+    return (int)(src_len / 2);
+}
@@ -0,0 +1,15 @@
+#ifndef HEX_H
+#define HEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Table-driven hex conversion used for AT+MSGHEX payloads and downlink data.
+// One 16-bit table lookup per byte replaces a sprintf("%02X") call, which matters
+// on the Cortex-M0+ where formatted output costs hundreds of cycles per byte.
+
+size_t hex_encode(char *dst, const uint8_t *src, size_t len); // Writes 2 * len upper-case digits, no terminator
+int hex_decode(uint8_t *dst, size_t dst_len, const char *src, size_t src_len); // Bytes written or -1 on bad input
+int hex_nibble(char c); // Value of one hex digit (either case) or -1
+
+#endif
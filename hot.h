@@ -0,0 +1,23 @@
+#ifndef HOT_H
+#define HOT_H
+
+// Placement of the receive path. With LORA_RAM_HOT_PATHS the interrupt
+// handlers, the line framer and the tables they read are linked into SRAM
+// (.time_critical), so handling a byte takes the same time whether or not the
+// XIP cache still holds the code. The RX rings themselves are ordinary static
+// data and always live in SRAM.
+//
+//   static void HOT_FUNC(uart1_irq_handler)(void) { ... }
+//   static const uint8_t HOT_DATA(hex) table[256] = { ... };
+
+// Without the option nothing here needs the SDK, the parsers stay portable
+#ifdef LORA_RAM_HOT_PATHS
+#include "pico/platform.h"
+#define HOT_FUNC(name) __not_in_flash_func(name)
+#define HOT_DATA(group) __not_in_flash(group)
+#else
+#define HOT_FUNC(name) name
+#define HOT_DATA(group)
+#endif
+
+#endif
@@ -0,0 +1,82 @@
+#include "latency.h"
+#include <stdio.h>
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hot.h"
+
+static int alarm_num = -1;
+static uint32_t due_us; // Time the pending alarm was armed for
+static latency_stats_t stats;
+
+static void reset_stats(void) {
+    stats.samples = 0;
+    stats.min_us = UINT32_MAX;
+    stats.max_us = 0;
+    stats.total_us = 0;
+}
+
+static void HOT_FUNC(alarm_irq)(void) {
+    const uint32_t now = timer_hw->timerawl; // First thing, everything after this is not latency
+    LATENCY_ENTER();
+    hw_clear_bits(&timer_hw->intr, 1u << alarm_num);
+
+    const uint32_t late = now - due_us;
+    stats.samples++;
+    stats.total_us += late;
+    if (late < stats.min_us)
+        stats.min_us = late;
+    if (late > stats.max_us)
+        stats.max_us = late;
+
+    // Armed from the current time: the alarm only matches the low 32 bits, a
+    // due time already in the past would not fire again for 72 minutes
+    due_us = timer_hw->timerawl + LATENCY_PERIOD_US;
+    timer_hw->alarm[alarm_num] = due_us;
+    LATENCY_EXIT();
+}
+
+bool latency_init(void) {
+    gpio_init(LATENCY_PIN);
+    gpio_set_dir(LATENCY_PIN, GPIO_OUT);
+    gpio_put(LATENCY_PIN, 0);
+
+    alarm_num = hardware_alarm_claim_unused(false);
+    if (alarm_num < 0)
+        return false;
+    reset_stats();
+
+    // Direct handler instead of hardware_alarm_set_callback(), whose dispatch
+    // would be part of every sample
+    const uint irq = TIMER_IRQ_0 + (uint)alarm_num;
+    irq_set_exclusive_handler(irq, alarm_irq);
+    hw_set_bits(&timer_hw->inte, 1u << alarm_num);
+    irq_set_enabled(irq, true);
+    due_us = timer_hw->timerawl + LATENCY_PERIOD_US;
+    timer_hw->alarm[alarm_num] = due_us;
+    return true;
+}
+
+latency_stats_t latency_stats(const bool reset) {
+    const uint32_t saved = save_and_disable_interrupts();
+    const latency_stats_t snapshot = stats;
+    if (reset)
+        reset_stats();
+    restore_interrupts(saved);
+    return snapshot;
+}
+
+void latency_print(void) {
+    const latency_stats_t s = latency_stats(true);
+    if (s.samples == 0) {
+        printf("ISR latency: no samples\r\n");
+        return;
+    }
+#ifdef LORA_RAM_HOT_PATHS
+    const char *placement = "RAM";
+#else
+    const char *placement = "flash";
+#endif
+    printf("ISR latency (hot paths in %s): %u samples, min %u us, avg %u us, max %u us\r\n", placement,
+        (unsigned)s.samples, (unsigned)s.min_us, (unsigned)(s.total_us / s.samples), (unsigned)s.max_us);
+}
@@ -0,0 +1,37 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/gpio.h"
+
+// Interrupt latency measurement (LORA_ISR_LATENCY). A spare hardware alarm
+// fires every LATENCY_PERIOD_US and its handler compares the timer with the
+// time the alarm was due: the difference is how long the interrupt waited
+// behind other handlers, masked sections and flash fetches. The UART and GPIO
+// handlers raise LATENCY_PIN for as long as they run, so a scope on the module
+// RX line and LATENCY_PIN shows the latency of the receive path itself.
+
+#define LATENCY_PIN 22 // Free on the Pico header
+#define LATENCY_PERIOD_US 10007 // Prime, does not stay in step with the 1 ms tick or the reactor timers
+
+typedef struct {
+    uint32_t samples;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} latency_stats_t;
+
+#ifdef LORA_ISR_LATENCY
+#define LATENCY_ENTER() gpio_put(LATENCY_PIN, 1)
+#define LATENCY_EXIT() gpio_put(LATENCY_PIN, 0)
+#else
+#define LATENCY_ENTER() ((void)0)
+#define LATENCY_EXIT() ((void)0)
+#endif
+
+bool latency_init(void); // Claim an alarm and start sampling, false when none is free
+latency_stats_t latency_stats(bool reset); // Snapshot, optionally starting a new window
+void latency_print(void); // One-line report on the console
+
+#endif
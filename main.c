@@ -1,219 +1,1001 @@
 #include <stdio.h>
-#include "hardware/pwm.h"
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/uart.h"
 #include "hardware/gpio.h"
-#include "pico/util/queue.h"
+#include "flash_queue.h"
+#include "flash_storage.h"
+#include "hex.h"
+#include "downlink.h"
+#include "modem.h"
+#include "module_info.h"
+#include "provision.h"
+#include "pio_uart.h"
+#include "debounce.h"
+#include "reactor.h"
+#include "app.h"
+#include "pool.h"
+#include "console.h"
+#ifdef LORA_CAPTURE
+#include "hardware/sync.h"
+#include "capture.h"
+#endif
+#include "hot.h"
+#ifdef LORA_COROUTINES
+#include "at_coro.h"
+#endif
+#ifdef LORA_DORMANT
+#include "dormant.h"
+#endif
+#ifdef LORA_GOVERNOR
+#include "governor.h"
+#include "sysclk.h"
+#endif
+#ifdef LORA_ISR_LATENCY
+#include "latency.h"
+#endif
+#ifdef LORA_RECOVERY
+#include "recovery.h"
+#endif
+#ifdef LORA_BRIDGE
+#include "bridge.h"
+#include "bridge_ports.h"
+#endif
 
 #define SW_0 9 // left button
 
 #define UART uart1 // LoRa module UART1
 #define UART_TX 4 // UART0 TX (GP4) - to LoRa
 #define UART_RX 5 // UART0 RX (GP5) - from LoRa
+#ifndef LORA_CTS_PIN
+#define LORA_CTS_PIN 6 // UART1 CTS (GP6) - from LoRa RTS (LORA_FLOW_RTS_CTS)
+#endif
+#ifndef LORA_RTS_PIN
+#define LORA_RTS_PIN 7 // UART1 RTS (GP7) - to LoRa CTS
+#endif
+
+// Second module on UART0 for the provisioning jig, console is moved to USB
+#define UART0_TX 0 // UART0 TX (GP0) - to LoRa
+#define UART0_RX 1 // UART0 RX (GP1) - from LoRa
 
 #define BAUD_RATE 9600 // LoRa module UART speed
 
-#define LINE_LEN 128 // Maximum line length for UART input buffer
+// Extra modules on PIO UARTs (LORA_PIO_CHANNELS), pins listed as TX, RX
+#define PIO_UART_PINS { { 10, 11 }, { 12, 13 }, { 14, 15 }, { 16, 17 } }
 
-// AT commands for the LoRa-E5 module
-#define CMD_AT "AT\r\n"
-#define CMD_VERSION "AT+VER\r\n"
-#define CMD_DEV_EUI "AT+ID=DevEui\r\n"
+#ifdef LORA_JIG_UART0
+#define UART_MODEMS 2
+#else
+#define UART_MODEMS 1
+#endif
+#ifndef LORA_CAPTURE_BYTES
+#define LORA_CAPTURE_BYTES 16384 // Traffic log of the uart1 module (LORA_CAPTURE)
+#endif
+#define CAPTURE_DUMP_LINE 32 // Log bytes per "CAP" line of a dump
 
-#define DEBOUNCE_MS 20 // Debounce delay in milliseconds
+#ifndef LORA_PIO_CHANNELS
+#define LORA_PIO_CHANNELS 0
+#endif
+#if LORA_PIO_CHANNELS > PIO_UART_MAX_CHANNELS
+#error "LORA_PIO_CHANNELS exceeds the number of PIO state machine pairs"
+#endif
+#define MODEM_COUNT (UART_MODEMS + LORA_PIO_CHANNELS)
+
+// AT commands for the LoRa-E5 module
+#define CMD_MSGHEX "AT+MSGHEX=\"" // Followed by hex payload and closing quote
+#define CMD_RESET "AT+RESET\r\n" // Software reset, used for recovery without LORA_RESET_PIN
 
-// Type of event coming from the interrupt callback
-typedef enum { EVENT_BUTTON } event_type;
+#define TX_LEN 256 // Transmit buffer for AT+MSGHEX, fits up to 120 payload bytes
+#define DOWNLINK_LEN 64 // Largest downlink payload kept by the application
+#define UPLINK_RETRY_MS 30000 // Next attempt after an uplink that did not go through
+#define DORMANT_QUIET_MS 5000 // Inactivity before entering dormant mode (LORA_DORMANT)
+#define UPLINK_FRAMES 2 // Uplink commands that can be in flight at once
+#define LATENCY_REPORT_MS 5000 // Interrupt latency report period (LORA_ISR_LATENCY)
+#define BRIDGE_REPORT_MS 1000 // Bridge counters are printed at most this often when bytes were dropped
+#define CONSOLE_AT_COMMANDS 4 // Raw AT commands from the console queued or waiting for their answer
+#define CONSOLE_AT_LINES 8 // Answer lines kept until their console command is complete
+#define CONSOLE_AT_QUIET_MS 300 // A console command is complete once its module has been quiet this long
+#define CONSOLE_AT_TIMEOUT_MS 10000 // ... or this long after sending without any answer
 
-// Generic event passed from ISR to main loop through a queue
+// Pending uplinks kept in flash while the network is unavailable
+static flash_queue_t uplinks;
+// In-flight uplink: the AT+MSGHEX command and the downlink received in answer
 typedef struct {
-    event_type type; // EVENT_BUTTON
-    int32_t data; // BUTTON: 1 = press, 0 = release;
-} event_t;
-
-// Global event queue used by ISR (Interrupt Service Routine) and main loop
-static queue_t events;
-
-void gpio_callback(uint gpio, uint32_t event_mask);
-void ini_button(); // Initialize button SW_0
-bool check_connection(); // Send "AT" and verify that the module responds
-bool check_version(); // Read and print firmware version with "AT+VER"
-bool check_dev_eui(); // Read, print, and format DevEui with "AT+ID=DevEui"
-void write_str(const char *string); // Send a null-terminated string over UART
-bool read_line(char *buffer, int len, int timeout_ms); // Read one line from UART with timeout
+    char tx[TX_LEN];
+    uint8_t downlink[DOWNLINK_LEN];
+} uplink_frame_t;
+
+POOL_STORAGE(frame_storage, uplink_frame_t, UPLINK_FRAMES);
+static pool_t frames;
+// Line of a module's answer to a console command
+typedef struct response_line {
+    struct response_line *next;
+    char text[LINE_LEN];
+} response_line_t;
+// Raw AT command typed on the console: queued until its module is free, then
+// the module is claimed and the answer collected until it goes quiet
+typedef struct console_cmd {
+    struct console_cmd *next; // Next command for the same module
+    char text[LINE_LEN];
+    bool sent;
+    uint32_t sent_ms;
+    uint32_t last_ms; // Sent or last answer line
+    response_line_t *lines; // Answer, oldest first
+    response_line_t **tail;
+    uint16_t lost_lines; // Answer lines that found the response pool empty
+} console_cmd_t;
+
+POOL_STORAGE(command_storage, console_cmd_t, CONSOLE_AT_COMMANDS);
+POOL_STORAGE(response_storage, response_line_t, CONSOLE_AT_LINES);
+static pool_t commands;
+static pool_t responses;
+
+// LoRa modules driven by this board, modems[0] is the one used for uplinks
+static modem_t modems[MODEM_COUNT];
+#if LORA_PIO_CHANNELS > 0
+static pio_uart_t pio_channels[LORA_PIO_CHANNELS];
+#endif
+#ifdef LORA_DORMANT
+static power_t power;
+#endif
+#ifdef LORA_GOVERNOR
+static governor_t governor;
+static bool burst = false; // Module traffic or flash work in progress, read by the governor
+#endif
+#ifdef LORA_CAPTURE
+// Timestamped uart1 traffic since boot, dumped with "capture dump" for tools/capture_replay.py
+static uint8_t capture_buf[LORA_CAPTURE_BYTES];
+static capture_t capture;
+#endif
+#ifdef LORA_RECOVERY
+// Reset and re-probe of each module when it stops answering properly
+static recovery_t recovery[MODEM_COUNT];
+static recovery_ops_t recovery_ops[MODEM_COUNT]; // ctx is the module
+void module_reset(void *ctx, bool asserted);
+#endif
+// Console commands and the module raw AT lines go to
+static console_t console;
+static ring_t console_rx; // Filled from the stdio chars-available callback
+static int console_module = 0;
+static console_cmd_t *console_cmds[MODEM_COUNT]; // Per module, the one on the wire first
+// DevEui seen on each module slot at the last successful probe, 0 before the first
+static uint64_t known_dev_eui[MODEM_COUNT];
+// Successful probes and start of the first one, for the devices-per-minute figure
+static uint32_t devices_done = 0;
+static uint32_t first_probe_ms = 0;
+// Queued uplinks are not attempted again before this time after a failure
+static uint32_t uplink_retry_ms = 0;
+// Uplink in flight on modems[0]: its frame and the queue slot of its record
+static uplink_frame_t *uplink_frame = NULL;
+static uint32_t uplink_slot;
+
+void button_handler(uint gpio, button_action_t action); // Debounced button action from the alarm interrupt
+void ini_button(button_handler_t handler); // Initialize button SW_0
+void on_button(const event_t *event, void *ctx); // EVENT_BUTTON handler
+void on_uart_line(const event_t *event, void *ctx); // EVENT_UART_LINE handler
+#ifdef LORA_COROUTINES
+void coro_unsolicited(modem_t *m); // Line the coroutine flow did not wait for
+#endif
+void on_console(const event_t *event, void *ctx); // EVENT_CONSOLE handler
+void console_chars_available(void *param); // stdio input callback, interrupt context
+void console_at(const char *line, void *ctx); // Raw AT line typed on the console
+bool console_exchange(int index, uint32_t now_ms); // Send and collect console commands, true while the module is ours
+void cmd_stats(int argc, char *argv[], void *ctx); // Console: event loop, module and pool counters
+void cmd_hist(int argc, char *argv[], void *ctx); // Console: handler execution time histograms
+void cmd_config(int argc, char *argv[], void *ctx); // Console: show or change runtime settings
+void cmd_probe(int argc, char *argv[], void *ctx); // Console: same as pressing SW_0
+void cmd_capture(int argc, char *argv[], void *ctx); // Console: traffic log status, start, stop, dump
+void cmd_recovery(int argc, char *argv[], void *ctx); // Console: recovery statistics, forced recovery
+void cmd_uplink(int argc, char *argv[], void *ctx); // Console: queue an uplink or erase the queue
+#ifdef LORA_RECOVERY
+bool print_recovery(const recovery_t *r, recovery_event_t event); // Report recovery progress, false while retrying
+#endif
+void print_pools(); // Pool usage and high-water marks
+bool govern_clock(void *ctx); // Poller: scale clk_sys with the load
+void report_latency(const event_t *event, void *ctx); // Timer: print and restart the latency window
+void run_bridge(void); // USB <-> module pass-through, never returns
+void print_name(const modem_t *m); // Prefix output with the module name on multi-module builds
+void report_probe(modem_t *m); // Print the results of a finished probe
+void print_dev_eui(uint64_t dev_eui); // DevEui in the required format: lower case, no colons
 void convert_and_print(const char *line); // Convert DevEui response to required format
+bool queue_uplink(const uint8_t *payload, size_t len); // Store an uplink in flash, it is sent from there
+void start_uplink(modem_t *m, uint32_t now_ms); // Send the oldest queued uplink with "AT+MSGHEX" if the module is free
+void finish_uplink(modem_t *m, uplink_state_t state, uint32_t now_ms); // Report the result, release the record once sent
 
+#if !defined(LORA_FREERTOS) && !defined(LORA_BENCH)
+// Built-in console commands, anything starting with AT goes to the module
+static const console_command_t console_commands[] = {
+    { "stats", "", "Event loop, module and pool counters", cmd_stats, 0, 0 },
+    { "hist", "", "Handler execution time histograms", cmd_hist, 0, 0 },
+    { "config", "[module <n> | provision on|off | echo on|off]", "Show or change settings", cmd_config, 0, 2 },
+    { "probe", "", "Probe the modules, same as SW_0", cmd_probe, 0, 0 },
+    { "uplink", "<hex payload> | format", "Queue an uplink, or erase the uplink queue", cmd_uplink, 1, 1 },
+#ifdef LORA_CAPTURE
+    { "capture", "[start | stop | dump]", "uart1 traffic log", cmd_capture, 0, 1 },
+#endif
+#ifdef LORA_RECOVERY
+    { "recovery", "[reset]", "Module fault recovery statistics, or recover the console's module now", cmd_recovery,
+        0, 1 },
+#endif
+};
+#endif
+
+static const char *const event_names[EVENT_TYPE_COUNT] = { "button", "timer", "uart-line", "console", "user" };
+
+#if !defined(LORA_FREERTOS) && !defined(LORA_BENCH)
 int main() {
     // Initialize chosen serial port
     stdio_init_all();
-    // Initialize buttons and event queue + interrupt
-    ini_button();
-
-    // Initialize UART1 for LoRa module
-    uart_init(UART, BAUD_RATE);
-    gpio_set_function(UART_TX, GPIO_FUNC_UART);
-    gpio_set_function(UART_RX, GPIO_FUNC_UART);
-    // Configure UART as 8 data bits, 1 stop bit, no parity (8N1)
-    uart_set_format(UART, 8, 1, UART_PARITY_NONE);
-    uart_set_fifo_enabled(UART, true);
-
-    event_t event;
-    while (true) {
-        // Process pending events from the queue
-        while (queue_try_remove(&events, &event)) {
-            // React only to button press (falling edge event, data == 1)
-            if (event.type == EVENT_BUTTON && event.data == 1) {
-                // 1. Check AT connectivity
-                if (check_connection()) {
-                    printf("Connected to LoRa module\r\n");
-                    // 2. Read firmware version
-                    if (check_version()) {
-                        // 3. Read and process DevEui
-                        if (!check_dev_eui())
-                            printf("Module not responding\r\n");
-                    }
-                    else
-                        printf("Module not responding\r\n");
-                }
-                else
-                    printf("Module not responding\r\n");
+#ifdef LORA_BRIDGE
+    // Holding SW_0 through reset turns the board into a USB adapter for the module
+    gpio_init(SW_0);
+    gpio_pull_up(SW_0);
+    sleep_ms(1); // Let the pull-up charge the line
+    if (!gpio_get(SW_0))
+        run_bridge();
+#endif
+    // Initialize event loop with its event queue
+    reactor_init();
+    // Repeated button states are coalesced so a bouncing or stuck button cannot fill the queue
+    event_queue_configure(reactor_queue(), EVENT_BUTTON, EVENT_PRIO_NORMAL, true);
+    // Initialize buttons, modules and uplink queue
+    app_init(button_handler);
+
+    // Subsystems hook into the event loop, which never returns
+    reactor_register(EVENT_BUTTON, on_button, NULL);
+    reactor_add_poller(poll_modems, NULL);
+    // Console input arrives by interrupt; one pending EVENT_CONSOLE is enough however much was typed
+    console_init(&console, console_commands, count_of(console_commands), console_at, NULL);
+    event_queue_configure(reactor_queue(), EVENT_CONSOLE, EVENT_PRIO_LOW, true);
+    reactor_register(EVENT_CONSOLE, on_console, NULL);
+    stdio_set_chars_available_callback(console_chars_available, NULL);
+    reactor_set_idle(on_idle, NULL);
+#ifdef LORA_GOVERNOR
+    // Runs after poll_modems so it sees this iteration's load
+    governor_init(&governor, to_ms_since_boot(get_absolute_time()));
+    reactor_add_poller(govern_clock, NULL);
+#endif
+#ifdef LORA_DORMANT
+    // Sleep between presses, woken by the button or by a module starting to talk
+    power_init(&power, dormant_get(), DORMANT_QUIET_MS);
+    power_add_wake_pin(&power, SW_0);
+    power_add_wake_pin(&power, UART_RX);
+    power_add_wake_pin(&power, PICO_DEFAULT_UART_RX_PIN); // Console, the first character typed is lost
+    static const uint wake_pio_pins[PIO_UART_MAX_CHANNELS][2] = PIO_UART_PINS;
+    for (int i = 0; i < LORA_PIO_CHANNELS; i++)
+        power_add_wake_pin(&power, wake_pio_pins[i][1]);
+#endif
+#ifdef LORA_COROUTINES
+    // A press queries the first module with the coroutine flow instead of the probe engine
+    at_coro_init(&modems[0], coro_unsolicited);
+    reactor_add_poller(at_coro_poll, NULL);
+#endif
+#ifdef LORA_ISR_LATENCY
+    // Sample interrupt latency in the background, worst case per report window
+    if (latency_init())
+        reactor_add_timer(LATENCY_REPORT_MS, true, report_latency, NULL);
+    else
+        printf("No hardware alarm free for the latency probe\r\n");
+#endif
+    reactor_run();
+}
+#endif
+
+void app_init(const button_handler_t handler) {
+    // Initialize buttons + interrupt
+    ini_button(handler);
+
+    // Initialize UART1 (and UART0 on the jig) for the LoRa modules
+    modem_init_uart(&modems[0], "uart1", UART, UART_TX, UART_RX, BAUD_RATE);
+#if defined(LORA_FLOW_RTS_CTS)
+    if (!modem_set_flow(&modems[0], MODEM_FLOW_RTS_CTS, LORA_CTS_PIN, LORA_RTS_PIN))
+        panic("GP%u/GP%u are not the CTS/RTS pins of uart1", LORA_CTS_PIN, LORA_RTS_PIN);
+#elif defined(LORA_FLOW_XON_XOFF)
+    modem_set_flow(&modems[0], MODEM_FLOW_XON_XOFF, 0, 0);
+#endif
+#ifdef LORA_CAPTURE
+    // Recording starts at boot so a field incident is in the log before anyone asks for it
+    capture_init(&capture, capture_buf, sizeof(capture_buf));
+    capture_start(&capture, time_us_64());
+    modems[0].capture = &capture;
+#endif
+#if defined(LORA_RECOVERY) && defined(LORA_RESET_PIN)
+    gpio_init(LORA_RESET_PIN); // Input with the output latch low, see module_reset()
+#endif
+#ifdef LORA_JIG_UART0
+    modem_init_uart(&modems[1], "uart0", uart0, UART0_TX, UART0_RX, BAUD_RATE);
+#endif
+#if LORA_PIO_CHANNELS > 0
+    static const uint pio_pins[PIO_UART_MAX_CHANNELS][2] = PIO_UART_PINS;
+    static const char *const pio_names[PIO_UART_MAX_CHANNELS] = { "pio-a", "pio-b", "pio-c", "pio-d" };
+    for (int i = 0; i < LORA_PIO_CHANNELS; i++) {
+        if (!pio_uart_init(&pio_channels[i], pio_pins[i][0], pio_pins[i][1], BAUD_RATE))
+            panic("No free PIO state machines or DMA channels for %s", pio_names[i]);
+        modem_init(&modems[UART_MODEMS + i], pio_names[i], &pio_uart_port, &pio_channels[i]);
+    }
+#endif
+#ifdef LORA_RECOVERY
+    // Each module is watched and reset on its own
+    for (int i = 0; i < MODEM_COUNT; i++) {
+        recovery_ops[i] = (recovery_ops_t){ .reset = module_reset, .ctx = &modems[i] };
+        recovery_init(&recovery[i], &modems[i], &recovery_ops[i]);
+    }
+#endif
+
+    // Recover uplinks that were queued before the last reset or power loss
+    pool_init(&frames, "uplinks", frame_storage, sizeof(frame_storage[0]), UPLINK_FRAMES);
+    pool_init(&commands, "commands", command_storage, sizeof(command_storage[0]), CONSOLE_AT_COMMANDS);
+    pool_init(&responses, "responses", response_storage, sizeof(response_storage[0]), CONSOLE_AT_LINES);
+    flash_queue_mount(&uplinks, flash_storage_get());
+    if (uplinks.pending > 0)
+        printf("%u uplinks pending in flash\r\n", (unsigned)uplinks.pending);
+
+    // Provisioning mode watches every module slot for attached devices
+    provision_init(modems, MODEM_COUNT);
+#ifdef LORA_PRESENCE_PIN
+    provision_set_presence_pin(0, LORA_PRESENCE_PIN);
+#endif
+#ifdef LORA_PROVISIONING
+    provision_enable(true, to_ms_since_boot(get_absolute_time()));
+    printf("Provisioning mode\r\n");
+#endif
+
+    // Unsolicited module lines are dispatched synchronously, also without the reactor loop
+    reactor_register(EVENT_UART_LINE, on_uart_line, NULL);
+}
+
+void on_button(const event_t *event, void *ctx) {
+    (void)ctx;
+#ifdef LORA_DORMANT
+    power_activity(&power);
+#endif
+    // A single press (no second one within DOUBLE_PRESS_MS) starts the probes
+    if (event->data == BUTTON_PRESS) {
+#ifdef LORA_COROUTINES
+        at_coro_start();
+#endif
+        start_probes();
+    }
+    else if (event->data == BUTTON_LONG_PRESS)
+        print_pools();
+    else if (event->data == BUTTON_DOUBLE_PRESS) {
+        // Toggle continuous provisioning
+        provision_enable(!provision_enabled(), to_ms_since_boot(get_absolute_time()));
+        printf("Provisioning mode %s\r\n", provision_enabled() ? "on" : "off");
+    }
+}
+
+// Lines a module sends on its own (boot banner, late responses) are shown as-is
+void on_uart_line(const event_t *event, void *ctx) {
+    (void)ctx;
+    const modem_t *m = &modems[event->data];
+#ifdef LORA_DORMANT
+    power_activity(&power);
+#endif
+    // Ping answers and attach banners drive provisioning instead of being shown
+    if (provision_line(event->data, m->line, to_ms_since_boot(get_absolute_time())))
+        return;
+    print_name(m);
+    printf("%s\r\n", m->line);
+}
+
+#ifdef LORA_COROUTINES
+// Goes the same way as lines of a module nobody has claimed
+void coro_unsolicited(modem_t *m) {
+    const event_t event = { .type = EVENT_UART_LINE, .data = (int32_t)(m - modems) };
+    reactor_dispatch(&event);
+}
+#endif
+
+// Advance every module's probe: AT -> AT+VER -> AT+ID=DevEui
+bool poll_modems(void *ctx) {
+    (void)ctx;
+    bool busy = false;
+    const uint32_t now = to_ms_since_boot(get_absolute_time());
+    provision_poll(now);
+    for (int i = 0; i < MODEM_COUNT; i++) {
+        modem_t *m = &modems[i];
+#ifdef LORA_RECOVERY
+        print_recovery(&recovery[i], recovery_poll(&recovery[i], now));
+        if (recovery_busy(&recovery[i])) {
+            busy = true; // Not available while it is reset and boots
+            continue;
+        }
+#endif
+        if (console_cmds[i] != NULL && console_exchange(i, now)) {
+            busy = true;
+            continue;
+        }
+        const probe_state_t state = modem_probe_poll(m, now);
+        if (state == PROBE_DONE || state == PROBE_FAILED) {
+#ifdef LORA_RECOVERY
+            if (!print_recovery(&recovery[i], recovery_probe_finished(&recovery[i], now))) {
+                m->state = PROBE_IDLE; // Failed re-probe, the recovery resets the module again
+                busy = true;
+                continue;
             }
+#endif
+            report_probe(m);
+            provision_probe_finished(i, now);
+#ifdef LORA_GOVERNOR
+            governor_transaction_done(&governor);
+            printf("Estimated %u uJ per probe, %u clock changes\r\n",
+                (unsigned)governor_energy_per_transaction_uj(&governor), (unsigned)governor.changes);
+#endif
+            // The module answers again: uplinks stored while offline need not wait for the retry
+            if (state == PROBE_DONE && m == &modems[0])
+                uplink_retry_ms = now;
+            m->state = PROBE_IDLE;
         }
+        else if (m->uplink != UPLINK_IDLE) {
+            const uplink_state_t uplink = modem_uplink_poll(m, now);
+            if (uplink == UPLINK_SENT || uplink == UPLINK_FAILED)
+                finish_uplink(m, uplink, now);
+        }
+        else if (state == PROBE_IDLE && !m->claimed) {
+            // Line buffer is only valid until the next poll, so dispatch synchronously
+            while (modem_poll_line(m)) {
+                const event_t event = { .type = EVENT_UART_LINE, .data = i };
+                reactor_dispatch(&event);
+            }
+        }
+        busy |= modem_busy(m);
+    }
+    start_uplink(&modems[0], now);
+#ifdef LORA_GOVERNOR
+    burst = busy;
+#endif
+    return busy;
+}
 
-        sleep_ms(10); // 10 ms delay (0.01 second) to reduce CPU usage
+#ifdef LORA_GOVERNOR
+// Full speed during bursts, lower clocks while waiting; the UARTs keep their baud
+// rate through sysclk_set_khz() and the PIO channels are retuned here
+bool govern_clock(void *ctx) {
+    (void)ctx;
+    const uint8_t level = governor_update(&governor, burst, to_ms_since_boot(get_absolute_time()));
+    // A level the PLL could not be switched to is proposed again on the next update
+    if (level != governor.level && sysclk_set_khz(governor_khz(level))) {
+        governor_set_level(&governor, level);
+#if LORA_PIO_CHANNELS > 0
+        for (int i = 0; i < LORA_PIO_CHANNELS; i++)
+            pio_uart_retune(&pio_channels[i]);
+#endif
     }
+    return false;
 }
+#endif
 
-// Interrupt callback for pressing SW_0
-void gpio_callback(uint const gpio, uint32_t const event_mask) {
-    // Button press/release with debounce to ensure one physical press counts as one event
-    if (gpio == SW_0) {
-        static uint32_t last_ms = 0; // Store last interrupt time
-        const uint32_t now = to_ms_since_boot(get_absolute_time());
+#ifdef LORA_RECOVERY
+// The reset line of the uart1 module is open drain: pulled low while asserted,
+// otherwise left to the module's pull-up. Other modules get a software reset
+void module_reset(void *ctx, const bool asserted) {
+    modem_t *m = ctx;
+#ifdef LORA_RESET_PIN
+    if (m == &modems[0]) {
+        gpio_set_dir(LORA_RESET_PIN, asserted ? GPIO_OUT : GPIO_IN);
+        return;
+    }
+#endif
+    // No reset line wired: only helps while the module's AT parser still listens
+    if (asserted)
+        modem_write_str(m, CMD_RESET);
+}
+
+bool print_recovery(const recovery_t *r, const recovery_event_t event) {
+    const modem_t *m = r->m;
+    switch (event) {
+        case RECOVERY_STARTED:
+            print_name(m);
+            printf("Module fault (%s), resetting\r\n", recovery_fault_name(r->fault));
+            break;
+        case RECOVERY_RETRY:
+            print_name(m);
+            printf("Module did not come back, reset %u of %u\r\n", (unsigned)r->resets,
+                (unsigned)RECOVERY_MAX_RESETS);
+            return false;
+        case RECOVERY_DONE:
+            print_name(m);
+            printf("Module recovered in %u ms\r\n", (unsigned)r->last_ms);
+            break;
+        case RECOVERY_GAVE_UP:
+            print_name(m);
+            printf("Module not recovered after %u resets\r\n", (unsigned)RECOVERY_MAX_RESETS);
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+#endif
+
+#ifdef LORA_ISR_LATENCY
+// The worst case includes the windows where flash erases run with interrupts off
+void report_latency(const event_t *event, void *ctx) {
+    (void)event;
+    (void)ctx;
+    latency_print();
+}
+#endif
 
-        // Detect button release (rising edge)
-        if (event_mask & GPIO_IRQ_EDGE_RISE && now - last_ms >= DEBOUNCE_MS) {
-            last_ms = now;
-            const event_t event = { .type = EVENT_BUTTON, .data = 0 };
-            queue_try_add(&events, &event); // Add event to queue
+// Erase the next queue sector while no module is being talked to
+void on_idle(void *ctx) {
+    (void)ctx;
+    const bool erased = flash_queue_maintain(&uplinks);
+#ifdef LORA_GOVERNOR
+    burst |= erased; // Counted as load on the next governor update
+#endif
+#ifdef LORA_DORMANT
+    // Provisioning pings the module slots continuously, queued uplinks wait for
+    // their retry and a module may still owe a response: all need the timer running
+    bool waiting = erased || provision_enabled() || uplinks.pending > 0;
+    for (int i = 0; i < MODEM_COUNT; i++)
+        waiting |= modem_busy(&modems[i]);
+    if (power_idle(&power, waiting)) {
+        printf("Woke from dormant, ready in %u us\r\n", (unsigned)power.last_wake_us);
+        // The falling edge that woke the chip was not seen by the debouncer
+        if (!gpio_get(SW_0))
+            button_handler(SW_0, BUTTON_PRESS);
+    }
+#else
+    (void)erased;
+#endif
+}
+
+#ifdef LORA_BRIDGE
+// The module's UART is passed through to the USB CDC interface byte for byte,
+// the console stays on uart0 and reports dropped bytes. A baud rate chosen on
+// the host is applied to the module UART, so AT+UART=BR changes can be followed
+void run_bridge(void) {
+    const bridge_port_t *module = bridge_uart_port(UART, UART_TX, UART_RX, BAUD_RATE);
+    if (module == NULL)
+        panic("No free DMA channels for the bridge");
+    static bridge_t bridge;
+    bridge_init(&bridge, bridge_usb_port(), module);
+    printf("Bridge mode: USB <-> uart1 at %u baud\r\n", BAUD_RATE);
+
+    uint32_t dropped = 0;
+    uint32_t reported_ms = to_ms_since_boot(get_absolute_time());
+    while (true) {
+        bridge_pump(&bridge);
+
+        // Every line coding the host sets is applied, the first one too whatever its rate
+        uint32_t baud;
+        if (bridge_usb_line_coding(&baud)) {
+            bridge_uart_set_baud(baud);
+            printf("Bridge baud rate %u\r\n", (unsigned)baud);
         }
 
-        // Detect button press (falling edge)
-        if (event_mask & GPIO_IRQ_EDGE_FALL && now - last_ms >= DEBOUNCE_MS){
-            last_ms = now;
-            const event_t event = { .type = EVENT_BUTTON, .data = 1 };
-            queue_try_add(&events, &event); // Add event to queue
+        const uint32_t now = to_ms_since_boot(get_absolute_time());
+        const uint32_t lost = bridge_dropped(&bridge.dir[BRIDGE_B_TO_A]);
+        if (lost != dropped && now - reported_ms >= BRIDGE_REPORT_MS) {
+            const bridge_uart_stats_t s = bridge_uart_stats();
+            printf("Bridge: %u bytes to module, %u from module, dropped %u (ring %u, FIFO overruns %u)\r\n",
+                (unsigned)bridge.dir[BRIDGE_A_TO_B].bytes, (unsigned)bridge.dir[BRIDGE_B_TO_A].bytes,
+                (unsigned)lost, (unsigned)s.ring_lost, (unsigned)s.fifo_overruns);
+            dropped = lost;
+            reported_ms = now;
         }
     }
 }
+#endif
 
-void ini_button() {
-    gpio_init(SW_0); // Initialize GPIO pin
-    gpio_set_dir(SW_0, GPIO_IN); // Set as input
-    gpio_pull_up(SW_0); // Enable internal pull-up resistor (button reads high = true when not pressed)
+// Debounced button actions are forwarded to the main loop through the event queue
+void HOT_FUNC(button_handler)(uint const gpio, button_action_t const action) {
+    if (gpio == SW_0) {
+        reactor_post(EVENT_BUTTON, action); // Add event to queue
+    }
+}
 
-    // Initialize event queue for Interrupt Service Routine (ISR)
-    // 32 chosen as a safe buffer size: large enough to handle bursts of interrupts
-    // without losing events, yet small enough to keep RAM usage minimal.
-    queue_init(&events, sizeof(event_t), 32);
+void ini_button(const button_handler_t handler) {
+    // Configure SW_0 as pulled-up input with interrupt driven, timer based debounce
+    debounce_init(handler);
+    debounce_add(SW_0);
+}
 
-    // Configure button interrupt and callback
-    gpio_set_irq_enabled_with_callback(SW_0, GPIO_IRQ_EDGE_FALL |
-        GPIO_IRQ_EDGE_RISE, true, &gpio_callback);
+void start_probes() {
+    const uint32_t now = to_ms_since_boot(get_absolute_time());
+    if (devices_done == 0)
+        first_probe_ms = now;
+    for (int i = 0; i < MODEM_COUNT; i++) {
+        if (!modem_busy(&modems[i]) && !modems[i].claimed)
+            modem_probe_start(&modems[i], now);
+    }
 }
 
-// Send "AT" command and check if module responds with a line that contains "OK"
-// Tries up to 5 times, each with a 500 ms timeout
-bool check_connection() {
-    char line[LINE_LEN];
-    for (int i = 0; i < 5; i++) {
-        write_str(CMD_AT);
-        if (read_line(line, sizeof(line), 500)) {
-            if (strstr(line, "OK") != NULL)
-                return true;
-        }
+// In use, high-water mark and exhaustion count of each object pool
+void print_pools() {
+    const pool_t *pools[] = { &frames, &commands, &responses };
+    for (size_t i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+        const pool_t *p = pools[i];
+        printf("Pool %s: %u/%u in use, high water %u, exhausted %u\r\n", p->name,
+            (unsigned)p->in_use, (unsigned)p->count, (unsigned)p->high_water, (unsigned)p->exhausted);
     }
-    return false;
 }
 
-// Send "AT+VER" and print the firmware version line
-// Returns true if a line containing "VER" is received within timeout
-bool check_version() {
-    char line[LINE_LEN];
-    write_str(CMD_VERSION);
-    if (read_line(line, sizeof(line), 500)) {
-        if (strstr(line, "VER") != NULL) {
-            printf("%s\r\n", line);
-            return true;
-        }
+// Runs in interrupt context: only move the characters into the ring and wake the loop
+void HOT_FUNC(console_chars_available)(void *param) {
+    (void)param;
+    int ch;
+    while ((ch = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
+        ring_put(&console_rx, (uint8_t)ch);
+    reactor_post(EVENT_CONSOLE, 0);
+}
+
+void on_console(const event_t *event, void *ctx) {
+    (void)event;
+    (void)ctx;
+#ifdef LORA_DORMANT
+    power_activity(&power);
+#endif
+    uint8_t ch;
+    while (ring_get(&console_rx, &ch))
+        console_feed(&console, (char)ch);
+}
+
+// The answer comes back through on_uart_line like any other line from the module
+void console_at(const char *line, void *ctx) {
+    (void)ctx;
+    console_cmd_t *c = pool_alloc(&commands);
+    if (c == NULL) {
+        printf("Too many AT commands waiting\r\n");
+        return;
     }
-    return false;
+    snprintf(c->text, sizeof(c->text), "%s", line);
+    c->next = NULL;
+    c->sent = false;
+    c->lines = NULL;
+    c->tail = &c->lines;
+    c->lost_lines = 0;
+    console_cmd_t **last = &console_cmds[console_module];
+    while (*last != NULL)
+        last = &(*last)->next;
+    *last = c;
+    const modem_t *m = &modems[console_module];
+    if (c != console_cmds[console_module] || modem_busy(m) || m->claimed)
+        printf("%s is busy, command queued\r\n", m->name);
 }
 
-// Send "AT+ID=DevEui" and print both the raw response and the processed DevEui
-// Returns true if a valid DevEui line is received
-bool check_dev_eui() {
-    char line[LINE_LEN];
-    write_str(CMD_DEV_EUI);
-    if (read_line(line, sizeof(line), 500)) {
-        if (strstr(line, "DevEui") != NULL) {
-            printf("%s\r\n", line);
-            convert_and_print(line);
-            return true;
+bool console_exchange(const int index, const uint32_t now_ms) {
+    modem_t *m = &modems[index];
+    console_cmd_t *c = console_cmds[index];
+    if (!c->sent) {
+        if (modem_busy(m) || m->claimed)
+            return false;
+        m->claimed = true; // Its lines are the answer, not unsolicited
+        modem_write_str(m, c->text);
+        modem_write_str(m, "\r\n");
+        c->sent = true;
+        c->sent_ms = c->last_ms = now_ms;
+        return true;
+    }
+    while (modem_poll_line(m)) {
+        c->last_ms = now_ms;
+        response_line_t *r = pool_alloc(&responses);
+        if (r == NULL) {
+            c->lost_lines++;
+            continue;
         }
+        snprintf(r->text, sizeof(r->text), "%s", m->line);
+        r->next = NULL;
+        *c->tail = r;
+        c->tail = &r->next;
+    }
+    const bool answered = c->lines != NULL || c->lost_lines > 0;
+    if (now_ms - c->last_ms < (answered ? CONSOLE_AT_QUIET_MS : CONSOLE_AT_TIMEOUT_MS))
+        return true;
+
+    print_name(m);
+    if (answered)
+        printf("%s: answer after %u ms\r\n", c->text, (unsigned)(c->last_ms - c->sent_ms));
+    else
+        printf("%s: no answer\r\n", c->text);
+    while (c->lines != NULL) {
+        response_line_t *r = c->lines;
+        printf("%s\r\n", r->text);
+        c->lines = r->next;
+        pool_free(&responses, r);
     }
+    if (c->lost_lines > 0)
+        printf("(%u more lines, response pool empty)\r\n", (unsigned)c->lost_lines);
+    console_cmds[index] = c->next;
+    pool_free(&commands, c);
+    m->claimed = false;
     return false;
 }
 
-// Send a string to the LoRa module using UART
-void write_str(const char *string) {
-    while (*string) {
-        uart_putc_raw(UART, *string++);
+void cmd_stats(int argc, char *argv[], void *ctx) {
+    (void)argc;
+    (void)argv;
+    (void)ctx;
+    const event_queue_t *q = reactor_queue();
+    printf("Events: %u pending, high water %u, dropped %u, coalesced %u\r\n", (unsigned)q->pending,
+        (unsigned)q->high_water, (unsigned)q->dropped, (unsigned)q->coalesced);
+    for (int t = 0; t < EVENT_TYPE_COUNT; t++) {
+        const handler_stats_t *s = reactor_stats((event_type)t);
+        if (s->calls > 0)
+            printf("  %-10s %u calls, avg %u us, max %u us\r\n", event_names[t], (unsigned)s->calls,
+                (unsigned)(s->total_us / s->calls), (unsigned)s->max_us);
+    }
+    for (int i = 0; i < MODEM_COUNT; i++) {
+        const modem_t *m = &modems[i];
+        printf("%s: RX overruns %u ring, %u FIFO\r\n", m->name, (unsigned)m->rx.overruns,
+            (unsigned)m->fifo_overruns);
+        if (m->flow != MODEM_FLOW_NONE)
+            printf("  flow control: throttled %u times%s, XOFF received %u\r\n", (unsigned)m->throttles,
+                m->throttled ? " (now)" : "", (unsigned)m->tx_pauses);
     }
+    print_pools();
+    printf("Uplinks pending %u\r\n", (unsigned)uplinks.pending);
 }
 
-// Read a single line from UART into buffer with timeout
-bool read_line(char *buffer, const int len, const int timeout_ms) {
-    const uint32_t us = timeout_ms * 1000; // convert to microseconds
-    // Wait for data to become available within timeout
-    if (uart_is_readable_within_us(UART, us)) {
-        int i = 0;
-        while (i < len) {
-            const char c = uart_getc(UART);
-            if (c != '\n') {
-                if (c != '\r') // Ignore carriage return
-                    buffer[i++] = c;
-            }
-            else break; // End of line
+void cmd_hist(int argc, char *argv[], void *ctx) {
+    (void)argc;
+    (void)argv;
+    (void)ctx;
+    for (int t = 0; t < EVENT_TYPE_COUNT; t++) {
+        const handler_stats_t *s = reactor_stats((event_type)t);
+        if (s->calls == 0)
+            continue;
+        printf("%s:\r\n", event_names[t]);
+        for (int b = 0; b < REACTOR_HIST_BUCKETS; b++) {
+            if (s->histogram[b] == 0)
+                continue;
+            const unsigned low = b ? 1u << (b - 1) : 0;
+            if (b == REACTOR_HIST_BUCKETS - 1)
+                printf("  >= %5u us %8u\r\n", low, (unsigned)s->histogram[b]);
+            else
+                printf("  %5u-%5u us %8u\r\n", low, b ? (1u << b) - 1 : 0, (unsigned)s->histogram[b]);
         }
-        buffer[i] = '\0'; // Null-terminate resulting string
-        return true;
     }
-    // No data received within timeout
-    return false;
 }
 
-// Convert DevEui response line into hex string and print it
-void convert_and_print(const char *line) {
-    const char *line_after_comma = strchr(line, ','); // Find comma after "DevEui"
-    line_after_comma += 2; // Skip ", " to point at first hex digit
-    const int len = (int)strlen(line_after_comma);
-    char current_hexadecimal[5]; // Temporary buffer for each grou
-    int j = 0;
-    for (int i = 0; i <= len; i++) {
-        // Copy characters until ':' or temporary buffer is full
-        if (line_after_comma[i] != ':' && j < 4) {
-            current_hexadecimal[j++] = line_after_comma[i];
+// "on"/"off" into *value, false for anything else
+static bool parse_switch(const char *text, bool *value) {
+    if (strcmp(text, "on") == 0)
+        *value = true;
+    else if (strcmp(text, "off") == 0)
+        *value = false;
+    else
+        return false;
+    return true;
+}
+
+void cmd_config(int argc, char *argv[], void *ctx) {
+    (void)ctx;
+    if (argc == 1) {
+        printf("module %d (%s), %u modules at %u baud\r\n", console_module, modems[console_module].name,
+            (unsigned)MODEM_COUNT, (unsigned)BAUD_RATE);
+        printf("provision %s\r\n", provision_enabled() ? "on" : "off");
+        printf("echo %s\r\n", console.echo ? "on" : "off");
+        return;
+    }
+    bool on;
+    if (argc == 3 && strcmp(argv[1], "module") == 0) {
+        char *end;
+        const long index = strtol(argv[2], &end, 10);
+        if (*end != '\0' || index < 0 || index >= MODEM_COUNT) {
+            printf("Module index 0-%d\r\n", MODEM_COUNT - 1);
+            return;
         }
-        else {
-            // Terminate current group and print it
-            current_hexadecimal[j] = '\0';
-            printf("%s", current_hexadecimal);
-            j = 0;
+        console_module = (int)index;
+    }
+    else if (argc == 3 && strcmp(argv[1], "provision") == 0 && parse_switch(argv[2], &on))
+        provision_enable(on, to_ms_since_boot(get_absolute_time()));
+    else if (argc == 3 && strcmp(argv[1], "echo") == 0 && parse_switch(argv[2], &on))
+        console.echo = on;
+    else {
+        printf("Usage: config [module <n> | provision on|off | echo on|off]\r\n");
+        return;
+    }
+    printf("OK\r\n");
+}
+
+void cmd_probe(int argc, char *argv[], void *ctx) {
+    (void)argc;
+    (void)argv;
+    (void)ctx;
+    start_probes();
+}
+
+void cmd_uplink(int argc, char *argv[], void *ctx) {
+    (void)argc;
+    (void)ctx;
+    if (strcmp(argv[1], "format") == 0) {
+        if (uplink_frame != NULL) {
+            printf("Uplink in progress\r\n");
+            return;
         }
+        flash_queue_format(&uplinks);
+        printf("OK\r\n");
+        return;
     }
-    printf("\r\n");
-}
\ No newline at end of file
+    uint8_t payload[FQ_PAYLOAD_MAX];
+    const int len = hex_decode(payload, sizeof(payload), argv[1], strlen(argv[1]));
+    if (len <= 0) {
+        printf("Payload is 1-%u bytes in hex\r\n", (unsigned)FQ_PAYLOAD_MAX);
+        return;
+    }
+    if (!queue_uplink(payload, (size_t)len))
+        printf("Uplink not queued\r\n");
+    else
+        printf("Uplink queued, %u pending\r\n", (unsigned)uplinks.pending);
+}
+
+#ifdef LORA_CAPTURE
+// The dump is framed so tools/capture_replay.py can pick it out of a console log
+static void dump_capture(void) {
+    const size_t len = capture.len; // Records added while dumping lie beyond this point
+    printf("CAPTURE BEGIN %u %u %u\r\n", (unsigned)len, (unsigned)capture.records, (unsigned)capture.dropped);
+    char text[2 * CAPTURE_DUMP_LINE + 1];
+    for (size_t pos = 0; pos < len; pos += CAPTURE_DUMP_LINE) {
+        const size_t n = len - pos < CAPTURE_DUMP_LINE ? len - pos : CAPTURE_DUMP_LINE;
+        text[hex_encode(text, &capture_buf[pos], n)] = '\0';
+        printf("CAP %s\r\n", text);
+    }
+    printf("CAPTURE END\r\n");
+}
+
+void cmd_capture(int argc, char *argv[], void *ctx) {
+    (void)ctx;
+    if (argc == 1)
+        printf("Capture %s: %u of %u bytes, %u records, %u bytes dropped\r\n", capture.active ? "on" : "off",
+            (unsigned)capture.len, (unsigned)capture.size, (unsigned)capture.records, (unsigned)capture.dropped);
+    else if (strcmp(argv[1], "start") == 0) {
+        // The RX interrupt must not add a record while the log is reset
+        const uint32_t saved = save_and_disable_interrupts();
+        capture_start(&capture, time_us_64());
+        restore_interrupts(saved);
+    }
+    else if (strcmp(argv[1], "stop") == 0)
+        capture_stop(&capture);
+    else if (strcmp(argv[1], "dump") == 0)
+        dump_capture();
+    else
+        printf("Usage: capture [start | stop | dump]\r\n");
+}
+#endif
+
+#ifdef LORA_RECOVERY
+void cmd_recovery(int argc, char *argv[], void *ctx) {
+    (void)ctx;
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        // The module "config module <n>" selected for AT lines
+        recovery_request(&recovery[console_module]);
+        printf("OK\r\n");
+        return;
+    }
+    if (argc != 1) {
+        printf("Usage: recovery [reset]\r\n");
+        return;
+    }
+    for (int i = 0; i < MODEM_COUNT; i++) {
+        const recovery_t *r = &recovery[i];
+        const modem_t *m = r->m;
+        printf("%s: %u recovered, %u given up, last cause %s\r\n", m->name, (unsigned)r->recoveries,
+            (unsigned)r->failures, recovery_fault_name(r->fault));
+        if (r->recoveries > 0)
+            printf("  Time to recovery: last %u ms, mean %u ms, max %u ms\r\n", (unsigned)r->last_ms,
+                (unsigned)(r->total_ms / r->recoveries), (unsigned)r->max_ms);
+        printf("  Since boot: %u timeouts, %u garbled lines, %u framing errors\r\n", (unsigned)m->timeouts,
+            (unsigned)m->garbled_lines, (unsigned)m->framing_errors);
+    }
+}
+#endif
+
+// Module name in front of each result, only when more than one module is driven
+void print_name(const modem_t *m) {
+    if (MODEM_COUNT > 1)
+        printf("%s: ", m->name);
+}
+
+// Print results in probe order: connection, firmware version, DevEui
+void report_probe(modem_t *m) {
+    const probe_state_t reached = m->state == PROBE_DONE ? PROBE_DONE : m->failed_step;
+    if (reached > PROBE_CONNECT) {
+        print_name(m);
+        printf("Connected to LoRa module\r\n");
+    }
+    if (reached > PROBE_VERSION) {
+        print_name(m);
+        printf("+VER: %u.%u.%u\r\n", MODULE_VERSION_MAJOR(m->info.version),
+            MODULE_VERSION_MINOR(m->info.version), MODULE_VERSION_PATCH(m->info.version));
+    }
+    if (reached != PROBE_DONE) {
+        print_name(m);
+        printf("Module not responding\r\n");
+        return;
+    }
+
+    print_name(m);
+    print_dev_eui(m->info.dev_eui);
+
+    // A different DevEui on the same port means the module was swapped
+    const int slot = (int)(m - modems);
+    if (known_dev_eui[slot] != 0 && known_dev_eui[slot] != m->info.dev_eui) {
+        char previous[MODULE_DEV_EUI_TEXT_LEN];
+        module_format_dev_eui(previous, known_dev_eui[slot]);
+        print_name(m);
+        printf("Module replaced, previous DevEui %s\r\n", previous);
+    }
+    known_dev_eui[slot] = m->info.dev_eui;
+
+    devices_done++;
+    if (MODEM_COUNT > 1) {
+        // Aggregate rate over all modules since the first probe
+        const uint32_t elapsed_ms = m->finished_ms - first_probe_ms;
+        const uint32_t per_minute_x10 = elapsed_ms ? (uint32_t)((uint64_t)devices_done * 600000 / elapsed_ms) : 0;
+        printf("%u devices, %u.%u devices/min\r\n", (unsigned)devices_done,
+            (unsigned)(per_minute_x10 / 10), (unsigned)(per_minute_x10 % 10));
+    }
+}
+
+// Every uplink is written to flash before it is sent, so a module that is
+// offline or a reset in the middle of the exchange does not lose it
+bool queue_uplink(const uint8_t *payload, const size_t len) {
+    if (!flash_queue_append(&uplinks, payload, len))
+        return false;
+    uplink_retry_ms = to_ms_since_boot(get_absolute_time()); // Send as soon as the module is free
+    return true;
+}
+
+// Called from the module poller: the queue is drained one uplink at a time
+// whenever the module is not probed or owned by another driver
+void start_uplink(modem_t *m, const uint32_t now_ms) {
+    if (uplinks.pending == 0 || modem_busy(m) || m->claimed || (int32_t)(now_ms - uplink_retry_ms) < 0)
+        return;
+    uint8_t payload[FQ_PAYLOAD_MAX];
+    size_t len;
+    const size_t prefix = sizeof(CMD_MSGHEX) - 1;
+    if (!flash_queue_peek(&uplinks, payload, &len) || prefix + len * 2 + sizeof("\"\r\n") > TX_LEN)
+        return;
+    uplink_frame_t *frame = pool_alloc(&frames);
+    if (frame == NULL)
+        return; // Counted in frames.exhausted, tried again on the next poll
+    // The command is hex-encoded straight into the pooled frame
+    memcpy(frame->tx, CMD_MSGHEX, prefix);
+    const size_t end = prefix + hex_encode(&frame->tx[prefix], payload, len);
+    memcpy(&frame->tx[end], "\"\r\n", sizeof("\"\r\n")); // Closing quote, CRLF and terminator
+    // Any downlink is decoded directly into the frame while it arrives
+    modem_uplink_start(m, frame->tx, frame->downlink, sizeof(frame->downlink), now_ms);
+    uplink_frame = frame;
+    uplink_slot = uplinks.tail;
+}
+
+void finish_uplink(modem_t *m, const uplink_state_t state, const uint32_t now_ms) {
+    const downlink_t *dl = &m->dl;
+    if (state == UPLINK_SENT) {
+        // Unless the ring was full and the record given up meanwhile
+        if (uplinks.pending > 0 && uplinks.tail == uplink_slot)
+            flash_queue_pop(&uplinks);
+        if (dl->flags & DOWNLINK_HAS_PAYLOAD)
+            printf("Downlink port %d, %u bytes, RSSI %d, SNR %d\r\n", dl->port, (unsigned)dl->len, dl->rssi, dl->snr);
+        printf("Uplink sent, %u pending\r\n", (unsigned)uplinks.pending);
+    }
+    else {
+        uplink_retry_ms = now_ms + UPLINK_RETRY_MS;
+        printf("Uplink failed, %u pending, retry in %u s\r\n", (unsigned)uplinks.pending,
+            (unsigned)(UPLINK_RETRY_MS / 1000));
+    }
+    pool_free(&frames, uplink_frame);
+    uplink_frame = NULL;
+    m->uplink = UPLINK_IDLE;
+}
+
+void print_dev_eui(const uint64_t dev_eui) {
+    char text[MODULE_DEV_EUI_TEXT_LEN];
+    module_format_dev_eui(text, dev_eui);
+    printf("%s\r\n", text);
+}
+
+// Convert DevEui response line into hex string and print it
+void convert_and_print(const char *line) {
+    uint64_t dev_eui;
+    if (module_parse_dev_eui(line, &dev_eui))
+        print_dev_eui(dev_eui);
+    else
+        printf("Invalid DevEui response\r\n");
+}
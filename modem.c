@@ -0,0 +1,495 @@
+#include "modem.h"
+#include <string.h>
+#include "hardware/uart.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hot.h"
+#include "latency.h"
+
+// AT commands for the LoRa-E5 module
+#define CMD_AT "AT\r\n"
+#define CMD_VERSION "AT+VER\r\n"
+#define CMD_DEV_EUI "AT+ID=DevEui\r\n"
+
+#define UART_FIFO_DEPTH 32
+#define UART_PIN_CTS 2 // Signal of a GPIO in its UART pin group: TX, RX, CTS, RTS
+#define UART_PIN_RTS 3
+
+// Module served by each hardware UART interrupt
+static modem_t *uart_modems[2];
+
+// Bytes waiting for the consumer, in the ring or (FreeRTOS) the stream buffer
+static uint16_t HOT_FUNC(rx_level)(const modem_t *m) {
+#ifdef LORA_FREERTOS
+    if (m->rx_stream != NULL)
+        return (uint16_t)xStreamBufferBytesAvailable(m->rx_stream);
+#endif
+    return ring_count(&m->rx);
+}
+
+// XON/XOFF go out as soon as the TX FIFO has room. Called with the RX
+// interrupt excluded, the byte is left in flow_char when the FIFO is full.
+static void HOT_FUNC(send_flow_char)(uart_inst_t *uart, modem_t *m, uint8_t c) {
+    if (uart_is_writable(uart)) {
+        uart_get_hw(uart)->dr = c;
+        c = 0;
+    }
+    m->flow_char = c;
+}
+
+// Count FIFO overruns since the last interrupt and retry a pending XON/XOFF
+static void HOT_FUNC(uart_rx_errors)(uart_inst_t *uart, modem_t *m) {
+    if (uart_get_hw(uart)->rsr & UART_UARTRSR_OE_BITS) {
+        m->fifo_overruns++;
+        uart_get_hw(uart)->rsr = UART_UARTRSR_OE_BITS; // Any write clears the error flags
+    }
+    if (m->flow_char != 0)
+        send_flow_char(uart, m, m->flow_char);
+}
+
+// Up to one FIFO load. Bytes with a line error are dropped, XON/XOFF from the
+// module only pause our transmit
+static size_t HOT_FUNC(read_fifo)(uart_inst_t *uart, modem_t *m, uint8_t *got) {
+    size_t n = 0;
+    while (n < UART_FIFO_DEPTH && uart_is_readable(uart)) {
+        const uint32_t dr = uart_get_hw(uart)->dr;
+        if (dr & (UART_UARTDR_FE_BITS | UART_UARTDR_PE_BITS | UART_UARTDR_BE_BITS)) {
+            m->framing_errors++;
+            continue;
+        }
+        const uint8_t c = (uint8_t)dr;
+        if (m->flow == MODEM_FLOW_XON_XOFF && (c == MODEM_XON || c == MODEM_XOFF)) {
+            m->tx_paused = c == MODEM_XOFF;
+            if (m->tx_paused)
+                m->tx_pauses++;
+            continue;
+        }
+        got[n++] = c;
+    }
+    return n;
+}
+
+// Pause the module once the receive buffer reaches the high watermark. True
+// when the interrupt has to leave the remaining bytes in the FIFO.
+static bool HOT_FUNC(rx_throttle)(uart_inst_t *uart, modem_t *m) {
+    if (m->flow == MODEM_FLOW_NONE || m->throttled || rx_level(m) < MODEM_RX_HIGH_WATER)
+        return false;
+    m->throttled = true;
+    m->throttles++;
+    if (m->flow == MODEM_FLOW_XON_XOFF) {
+        send_flow_char(uart, m, MODEM_XOFF);
+        return false; // Bytes already on the way are still taken
+    }
+    // The UART drops RTS once the FIFO holds more than the RX interrupt
+    // level, the remaining space covers what the module sends after that
+    uart_set_irq_enables(uart, false, false);
+    return true;
+}
+
+// Consumer side: let the module send again once the buffer has drained to
+// the low watermark, and flush an XON/XOFF that found the TX FIFO full
+static void HOT_FUNC(flow_resume)(modem_t *m) {
+    uart_inst_t *uart = (uart_inst_t *)m->hw;
+    const uint32_t saved = save_and_disable_interrupts();
+    if (m->throttled && rx_level(m) <= MODEM_RX_LOW_WATER) {
+        m->throttled = false;
+        if (m->flow == MODEM_FLOW_RTS_CTS)
+            uart_set_irq_enables(uart, true, false);
+        else
+            send_flow_char(uart, m, MODEM_XON);
+    } else if (m->flow_char != 0) {
+        send_flow_char(uart, m, m->flow_char);
+    }
+    restore_interrupts(saved);
+}
+
+#ifdef LORA_FREERTOS
+// Hand the hardware FIFO contents to the module's stream buffer and wake its task
+static void HOT_FUNC(uart_rx_irq)(uart_inst_t *uart, modem_t *m) {
+    BaseType_t woken = pdFALSE;
+    uart_rx_errors(uart, m);
+    while (uart_is_readable(uart)) {
+        uint8_t buf[UART_FIFO_DEPTH];
+        const size_t n = read_fifo(uart, m, buf);
+        // Counted in bytes, like ring_put() does for the bare-metal build
+        const size_t sent = xStreamBufferSendFromISR(m->rx_stream, buf, n, &woken);
+        m->rx.overruns += (uint32_t)(n - sent);
+        if (rx_throttle(uart, m))
+            break;
+    }
+    if (m->rx_task != NULL)
+        xTaskNotifyFromISR(m->rx_task, MODEM_NOTIFY_RX, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+#else
+// Move everything from the hardware FIFO into the module's ring
+static void HOT_FUNC(uart_rx_irq)(uart_inst_t *uart, modem_t *m) {
+    uart_rx_errors(uart, m);
+    while (uart_is_readable(uart)) {
+        uint8_t got[UART_FIFO_DEPTH];
+        const size_t n = read_fifo(uart, m, got);
+        for (size_t i = 0; i < n; i++)
+            ring_put(&m->rx, got[i]);
+#ifdef LORA_CAPTURE
+        // One capture record per FIFO load, timestamped when it is taken
+        if (m->capture != NULL && n > 0)
+            capture_add(m->capture, CAPTURE_RX, time_us_64(), got, n);
+#endif
+        if (rx_throttle(uart, m))
+            break;
+    }
+}
+#endif
+
+static void HOT_FUNC(uart0_irq_handler)(void) {
+    LATENCY_ENTER();
+    uart_rx_irq(uart0, uart_modems[0]);
+    LATENCY_EXIT();
+}
+
+static void HOT_FUNC(uart1_irq_handler)(void) {
+    LATENCY_ENTER();
+    uart_rx_irq(uart1, uart_modems[1]);
+    LATENCY_EXIT();
+}
+
+// Let other work run while waiting for the module
+static void rx_wait(void) {
+#ifdef LORA_FREERTOS
+    vTaskDelay(1);
+#else
+    tight_loop_contents();
+#endif
+}
+
+static void uart_port_write(void *hw, const char *data, size_t len) {
+    uart_inst_t *uart = (uart_inst_t *)hw;
+    modem_t *m = uart_modems[uart_get_index(uart)];
+    if (m == NULL || m->flow != MODEM_FLOW_XON_XOFF) {
+        // With RTS/CTS the UART holds transmit while CTS is deasserted
+        while (len--)
+            uart_putc_raw(uart, *data++);
+        return;
+    }
+    // The RX interrupt writes XOFF into the same FIFO, so each byte is
+    // written with it masked
+    uint64_t paused_at = 0;
+    while (len > 0) {
+        if (m->tx_paused) {
+            if (paused_at == 0)
+                paused_at = time_us_64();
+            else if (time_us_64() - paused_at >= (uint64_t)MODEM_XOFF_TIMEOUT_MS * 1000)
+                m->tx_paused = false; // XON lost or never sent
+            rx_wait();
+            continue;
+        }
+        paused_at = 0;
+        const uint32_t saved = save_and_disable_interrupts();
+        if (uart_is_writable(uart)) {
+            if (m->flow_char != 0) {
+                uart_get_hw(uart)->dr = m->flow_char;
+                m->flow_char = 0;
+            } else {
+                uart_get_hw(uart)->dr = (uint8_t)*data++;
+                len--;
+            }
+        }
+        restore_interrupts(saved);
+    }
+}
+
+static const modem_port_t uart_port = { .write = uart_port_write, .poll = NULL };
+
+// Pull in bytes from transports that are not interrupt driven
+static void HOT_FUNC(service_port)(modem_t *m) {
+    if (m->port->poll)
+        m->port->poll(m->hw, &m->rx, &m->framing_errors);
+}
+
+// Next received byte: polled transports use the ring, under FreeRTOS the UART
+// interrupt feeds a stream buffer instead
+static bool HOT_FUNC(rx_get)(modem_t *m, uint8_t *c) {
+    if (m->throttled || m->flow_char != 0)
+        flow_resume(m);
+    if (ring_get(&m->rx, c))
+        return true;
+#ifdef LORA_FREERTOS
+    if (m->rx_stream != NULL)
+        return xStreamBufferReceive(m->rx_stream, c, 1, 0) == 1;
+#endif
+    return false;
+}
+
+// GPIO n belongs to the pin group of UART ((n + 4) / 8) % 2 and carries
+// signal n % 4 of it
+static bool uart_pin_is(uart_inst_t *uart, const uint pin, const uint signal) {
+    return pin < NUM_BANK0_GPIOS && ((pin + 4) / 8) % 2 == uart_get_index(uart) && pin % 4 == signal;
+}
+
+void modem_init(modem_t *m, const char *name, const modem_port_t *port, void *hw) {
+    memset(m, 0, sizeof(*m));
+    m->name = name;
+    m->port = port;
+    m->hw = hw;
+    ring_init(&m->rx);
+    m->state = PROBE_IDLE;
+}
+
+void modem_init_uart(modem_t *m, const char *name, uart_inst_t *uart, const uint tx_pin, const uint rx_pin,
+    const uint baud) {
+    modem_init(m, name, &uart_port, uart);
+#ifdef LORA_FREERTOS
+    m->rx_stream = xStreamBufferCreate(MODEM_RX_STREAM_LEN, 1);
+    m->rx_task = xTaskGetCurrentTaskHandle(); // Task that runs the AT engine
+#endif
+
+    uart_init(uart, baud);
+    gpio_set_function(tx_pin, GPIO_FUNC_UART);
+    gpio_set_function(rx_pin, GPIO_FUNC_UART);
+    // Configure UART as 8 data bits, 1 stop bit, no parity (8N1)
+    uart_set_format(uart, 8, 1, UART_PARITY_NONE);
+    uart_set_fifo_enabled(uart, true);
+
+    // Receive through the interrupt so bytes are buffered while the main loop is busy
+    const uint index = uart_get_index(uart);
+    uart_modems[index] = m;
+    const uint irq = index ? UART1_IRQ : UART0_IRQ;
+    irq_set_exclusive_handler(irq, index ? uart1_irq_handler : uart0_irq_handler);
+    irq_set_enabled(irq, true);
+    uart_set_irq_enables(uart, true, false);
+}
+
+bool modem_set_flow(modem_t *m, const modem_flow_t flow, const uint cts_pin, const uint rts_pin) {
+    if (m->port != &uart_port)
+        return false;
+    uart_inst_t *uart = (uart_inst_t *)m->hw;
+    const bool hardware = flow == MODEM_FLOW_RTS_CTS;
+    if (hardware && (!uart_pin_is(uart, cts_pin, UART_PIN_CTS) || !uart_pin_is(uart, rts_pin, UART_PIN_RTS)))
+        return false;
+
+    uart_set_irq_enables(uart, false, false);
+    m->flow = flow;
+    m->throttled = false;
+    m->tx_paused = false;
+    m->flow_char = 0;
+    if (hardware) {
+        gpio_set_function(cts_pin, GPIO_FUNC_UART);
+        gpio_set_function(rts_pin, GPIO_FUNC_UART);
+    }
+    uart_set_hw_flow(uart, hardware, hardware);
+    uart_set_irq_enables(uart, true, false);
+    return true;
+}
+
+void modem_write_str(modem_t *m, const char *string) {
+    const size_t len = strlen(string);
+#ifdef LORA_CAPTURE
+    if (m->capture != NULL) {
+        // The RX interrupt adds records to the same log
+        const uint32_t saved = save_and_disable_interrupts();
+        capture_add(m->capture, CAPTURE_TX, time_us_64(), (const uint8_t *)string, len);
+        restore_interrupts(saved);
+    }
+#endif
+    m->port->write(m->hw, string, len);
+}
+
+bool modem_getc(modem_t *m, char *c, const uint32_t timeout_us) {
+    const uint64_t deadline = time_us_64() + timeout_us;
+    uint8_t byte;
+    while (true) {
+        service_port(m);
+        if (rx_get(m, &byte))
+            break;
+        if (time_us_64() >= deadline)
+            return false;
+        rx_wait();
+    }
+    *c = (char)byte;
+    return true;
+}
+
+bool HOT_FUNC(modem_poll_line)(modem_t *m) {
+    uint8_t c;
+    service_port(m);
+    while (rx_get(m, &c)) {
+        if (c == '\n') {
+            m->line[m->line_len] = '\0'; // Null-terminate resulting string
+            m->line_len = 0;
+            if (m->line_bad)
+                m->garbled_lines++;
+            m->line_bad = false;
+            return true;
+        }
+        if (c == '\r')
+            continue;
+        // Drop what does not fit, noise on the line shows up as control or non-ASCII bytes
+        if (m->line_len == LINE_LEN - 1 || c < ' ' || c > '~')
+            m->line_bad = true;
+        if (m->line_len < LINE_LEN - 1)
+            m->line[m->line_len++] = (char)c;
+    }
+    return false;
+}
+
+void modem_flush(modem_t *m) {
+    uint8_t c;
+    service_port(m);
+    while (rx_get(m, &c)) {}
+    m->line_len = 0;
+    m->line_bad = false;
+}
+
+bool modem_read_line(modem_t *m, char *buffer, const int len, const int timeout_ms) {
+    if (len <= 0)
+        return false; // No room for the terminator
+    const uint64_t deadline = time_us_64() + (uint64_t)timeout_ms * 1000;
+    while (time_us_64() < deadline) {
+        if (modem_poll_line(m)) {
+            strncpy(buffer, m->line, len - 1);
+            buffer[len - 1] = '\0';
+            return true;
+        }
+        rx_wait();
+    }
+    // No complete line received within timeout
+    return false;
+}
+
+// Identity probe in progress
+static bool probing(const modem_t *m) {
+    return m->state == PROBE_CONNECT || m->state == PROBE_VERSION || m->state == PROBE_DEV_EUI;
+}
+
+// Record how long the step in progress took (retries of "AT" count towards it)
+static void end_step(modem_t *m, const uint32_t now_ms) {
+    m->step_ms[m->state - PROBE_CONNECT] = now_ms - m->step_started_ms;
+    m->step_started_ms = now_ms;
+}
+
+static void probe_send(modem_t *m, const char *cmd, const probe_state_t state, const uint32_t now_ms) {
+    if (state != m->state) {
+        if (probing(m))
+            end_step(m, now_ms);
+        else
+            m->step_started_ms = now_ms;
+    }
+    modem_write_str(m, cmd);
+    m->state = state;
+    m->deadline_ms = now_ms + PROBE_TIMEOUT_MS;
+}
+
+static void probe_fail(modem_t *m, const uint32_t now_ms) {
+    end_step(m, now_ms);
+    m->failed_step = m->state;
+    m->state = PROBE_FAILED;
+    m->finished_ms = now_ms;
+}
+
+// "AT" is resent until the module answers OK or attempts run out
+static void probe_retry(modem_t *m, const uint32_t now_ms) {
+    if (m->attempts < PROBE_AT_ATTEMPTS) {
+        m->attempts++;
+        probe_send(m, CMD_AT, PROBE_CONNECT, now_ms);
+    }
+    else
+        probe_fail(m, now_ms);
+}
+
+void modem_probe_start(modem_t *m, const uint32_t now_ms) {
+    // Throw away anything the module sent before the probe
+    modem_flush(m);
+    memset(&m->info, 0, sizeof(m->info));
+    memset(m->step_ms, 0, sizeof(m->step_ms));
+    m->attempts = 1;
+    m->started_ms = now_ms;
+    probe_send(m, CMD_AT, PROBE_CONNECT, now_ms);
+}
+
+probe_state_t modem_probe_poll(modem_t *m, const uint32_t now_ms) {
+    // Outside a probe, lines are left in the ring for the caller
+    while (probing(m) && modem_poll_line(m)) {
+        switch (m->state) {
+            case PROBE_CONNECT:
+                // Module responds with a line that contains "OK"
+                if (strstr(m->line, "OK") != NULL)
+                    probe_send(m, CMD_VERSION, PROBE_VERSION, now_ms);
+                else
+                    probe_retry(m, now_ms);
+                break;
+            case PROBE_VERSION:
+                // Parsed once here, only the packed version is kept
+                if (strstr(m->line, "VER") != NULL && module_parse_version(m->line, &m->info.version))
+                    probe_send(m, CMD_DEV_EUI, PROBE_DEV_EUI, now_ms);
+                else
+                    probe_fail(m, now_ms);
+                break;
+            case PROBE_DEV_EUI:
+                if (strstr(m->line, "DevEui") != NULL && module_parse_dev_eui(m->line, &m->info.dev_eui)) {
+                    end_step(m, now_ms);
+                    m->state = PROBE_DONE;
+                    m->finished_ms = now_ms;
+                }
+                else
+                    probe_fail(m, now_ms);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (probing(m) && (int32_t)(now_ms - m->deadline_ms) >= 0) {
+        m->timeouts++;
+        if (m->state == PROBE_CONNECT)
+            probe_retry(m, now_ms);
+        else
+            probe_fail(m, now_ms);
+    }
+    return m->state;
+}
+
+void modem_probe_abort(modem_t *m, const uint32_t now_ms) {
+    if (probing(m))
+        probe_fail(m, now_ms);
+}
+
+void modem_uplink_start(modem_t *m, const char *cmd, uint8_t *downlink, const size_t capacity, const uint32_t now_ms) {
+    modem_flush(m);
+    downlink_begin(&m->dl, downlink, capacity);
+    modem_write_str(m, cmd);
+    m->uplink = UPLINK_SENDING;
+    m->uplink_deadline_ms = now_ms + UPLINK_TIMEOUT_MS;
+}
+
+// Module answers "+MSGHEX: Start", then an error or RX info, then "+MSGHEX: Done".
+// Bytes go from the RX ring straight into the downlink parser, no line buffer is used
+uplink_state_t modem_uplink_poll(modem_t *m, const uint32_t now_ms) {
+    if (m->uplink != UPLINK_SENDING)
+        return m->uplink;
+    uint8_t c;
+    service_port(m);
+    while (rx_get(m, &c)) {
+        const downlink_event_t event = downlink_feed(&m->dl, (char)c);
+        if (event == DOWNLINK_DONE) {
+            m->uplink = m->dl.flags & DOWNLINK_FAILED ? UPLINK_FAILED : UPLINK_SENT;
+            return m->uplink;
+        }
+        if (event != DOWNLINK_NONE)
+            m->uplink_deadline_ms = now_ms + UPLINK_TIMEOUT_MS; // Each report restarts the wait
+    }
+    if ((int32_t)(now_ms - m->uplink_deadline_ms) >= 0) {
+        m->timeouts++;
+        m->uplink = UPLINK_FAILED;
+    }
+    return m->uplink;
+}
+
+void modem_uplink_abort(modem_t *m) {
+    if (m->uplink == UPLINK_SENDING)
+        m->uplink = UPLINK_FAILED;
+}
+
+bool modem_busy(const modem_t *m) {
+    return probing(m) || m->uplink == UPLINK_SENDING;
+}
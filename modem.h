@@ -0,0 +1,141 @@
+#ifndef MODEM_H
+#define MODEM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "ring.h"
+#include "module_info.h"
+#include "downlink.h"
+#ifdef LORA_CAPTURE
+#include "capture.h"
+#endif
+#ifdef LORA_FREERTOS
+#include "FreeRTOS.h"
+#include "stream_buffer.h"
+#include "task.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-instance driver context for one LoRa module. Each module has its own
+// RX ring (filled from its interrupt handler), line assembler and AT probe
+// engine, so any number of modules can be driven from one event loop.
+
+#define LINE_LEN 128 // Maximum line length for UART input buffer
+#define PROBE_TIMEOUT_MS 500 // Response timeout for each probe command
+#define PROBE_AT_ATTEMPTS 5 // "AT" is retried this many times before giving up
+#define UPLINK_TIMEOUT_MS 8000 // Longest wait for the next report of an uplink, covers both receive windows
+#define MODEM_RX_STREAM_LEN 256 // FreeRTOS stream buffer per hardware UART module
+#define MODEM_NOTIFY_RX (1u << 31) // Task notification bit set by the UART RX interrupt
+#define MODEM_RX_HIGH_WATER 192 // Buffered bytes at which a flow-controlled module is paused
+#define MODEM_RX_LOW_WATER 64 // Buffered bytes at which it may send again
+#define MODEM_XOFF_TIMEOUT_MS 2000 // Transmit resumes without XON after this long
+#define MODEM_XON 0x11
+#define MODEM_XOFF 0x13
+
+// Transport used by a module: hardware UART or PIO UART
+typedef struct {
+    void (*write)(void *hw, const char *data, size_t len); // Blocking transmit
+    // Move received bytes into rx and add line errors to *framing_errors, NULL when an ISR fills the ring
+    void (*poll)(void *hw, ring_t *rx, uint32_t *framing_errors);
+} modem_port_t;
+
+// Flow control between a hardware UART and its module (modem_set_flow)
+typedef enum {
+    MODEM_FLOW_NONE,
+    MODEM_FLOW_RTS_CTS, // UART hardware handshake, RTS follows the receive buffer watermarks
+    MODEM_FLOW_XON_XOFF // In-band XON/XOFF in both directions, filtered out of the received stream
+} modem_flow_t;
+
+// Steps of the identity probe: AT -> AT+VER -> AT+ID=DevEui
+typedef enum {
+    PROBE_IDLE,
+    PROBE_CONNECT,
+    PROBE_VERSION,
+    PROBE_DEV_EUI,
+    PROBE_DONE, // All responses received
+    PROBE_FAILED // Module did not respond or answered unexpectedly
+} probe_state_t;
+
+#define PROBE_STEPS 3 // CONNECT, VERSION, DEV_EUI
+
+// Uplink exchange: the command is sent, then the module's "+MSGHEX:" reports
+// are parsed until "Done"
+typedef enum {
+    UPLINK_IDLE,
+    UPLINK_SENDING, // Waiting for the reports
+    UPLINK_SENT, // "Done" without an error
+    UPLINK_FAILED // Module reported an error, or no report within UPLINK_TIMEOUT_MS
+} uplink_state_t;
+
+typedef struct {
+    const char *name; // Printed in front of the results when several modules are used
+    const modem_port_t *port;
+    void *hw; // uart_inst_t, PIO channel, ...
+    ring_t rx; // Filled by the UART interrupt or the port's poll hook
+#ifdef LORA_FREERTOS
+    StreamBufferHandle_t rx_stream; // Filled by the UART interrupt instead of rx
+    TaskHandle_t rx_task; // Notified with MODEM_NOTIFY_RX when bytes arrive
+#endif
+#ifdef LORA_CAPTURE
+    capture_t *capture; // Traffic log, NULL when not recorded (hardware UART modules only)
+#endif
+
+    modem_flow_t flow;
+    volatile bool throttled; // Module asked to pause: RX interrupt masked (RTS/CTS) or XOFF sent
+    volatile bool tx_paused; // Module sent XOFF
+    volatile uint8_t flow_char; // XON/XOFF waiting for room in the TX FIFO, 0 when none
+    uint32_t fifo_overruns; // UART FIFO overruns seen by the RX interrupt (bytes lost in hardware)
+    uint32_t throttles; // Times the receive buffer reached MODEM_RX_HIGH_WATER
+    uint32_t tx_pauses; // XOFFs received from the module
+    // Fault indicators, watched by the recovery (recovery.h)
+    uint32_t framing_errors; // Bytes received with a framing, parity or break error (dropped)
+    uint32_t garbled_lines; // Lines with control or non-ASCII bytes, or too long for line[]
+    uint32_t timeouts; // Responses that did not arrive in time
+
+    char line[LINE_LEN]; // Line being assembled from the ring
+    uint16_t line_len; // Characters beyond LINE_LEN - 1 are discarded
+    bool line_bad; // Line being assembled is garbled
+    bool claimed; // Lines belong to another driver (coroutine layer), not to the event loop
+
+    probe_state_t state;
+    probe_state_t failed_step; // Step that failed when state == PROBE_FAILED
+    uint8_t attempts;
+    uint32_t deadline_ms;
+    uint32_t started_ms;
+    uint32_t finished_ms;
+    uint32_t step_started_ms;
+    uint32_t step_ms[PROBE_STEPS]; // Time spent in each step, indexed by state - PROBE_CONNECT
+    module_info_t info; // Parsed probe results, valid up to the step the probe reached
+
+    uplink_state_t uplink;
+    uint32_t uplink_deadline_ms;
+    downlink_t dl; // Reports of the uplink, the payload goes to the caller's buffer
+} modem_t;
+
+void modem_init(modem_t *m, const char *name, const modem_port_t *port, void *hw); // Generic part of the setup
+void modem_init_uart(modem_t *m, const char *name, uart_inst_t *uart, uint tx_pin, uint rx_pin, uint baud); // Hardware UART module
+
+bool modem_set_flow(modem_t *m, modem_flow_t flow, uint cts_pin, uint rts_pin); // False for other ports or pins that are not CTS/RTS of the UART
+void modem_write_str(modem_t *m, const char *string); // Send a null-terminated string to the module
+bool modem_getc(modem_t *m, char *c, uint32_t timeout_us); // Next received byte with timeout
+bool modem_read_line(modem_t *m, char *buffer, int len, int timeout_ms); // Read one line with timeout (blocking)
+bool modem_poll_line(modem_t *m); // Assemble buffered bytes into m->line, true when a line is complete
+void modem_flush(modem_t *m); // Drop everything received so far, including a partial line
+
+void modem_probe_start(modem_t *m, uint32_t now_ms); // Begin the identity probe
+probe_state_t modem_probe_poll(modem_t *m, uint32_t now_ms); // Advance the probe without blocking, no-op when idle
+void modem_probe_abort(modem_t *m, uint32_t now_ms); // End a running probe as failed at its current step
+void modem_uplink_start(modem_t *m, const char *cmd, uint8_t *downlink, size_t capacity, uint32_t now_ms); // Send an uplink command
+uplink_state_t modem_uplink_poll(modem_t *m, uint32_t now_ms); // Parse the reports without blocking, no-op when idle
+void modem_uplink_abort(modem_t *m); // End a running uplink as failed, the module forgot it (reset)
+bool modem_busy(const modem_t *m); // Probe or uplink in progress
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
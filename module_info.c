@@ -0,0 +1,69 @@
+#include "module_info.h"
+#include <string.h>
+#include "hex.h"
+
+#define VERSION_PART_MAX 255 // Each part is packed into 8 bits (major has 16, but 255 is plenty)
+
+bool module_parse_version(const char *line, uint32_t *version) {
+    const char *p = strchr(line, ':'); // After "+VER"
+    if (p == NULL)
+        return false;
+    p++;
+    while (*p == ' ')
+        p++;
+
+    // major.minor.patch, missing trailing parts count as 0
+    uint32_t parts[3] = { 0, 0, 0 };
+    int count = 0;
+    while (count < 3) {
+        if (*p < '0' || *p > '9')
+            break;
+        uint32_t value = 0;
+        while (*p >= '0' && *p <= '9') {
+            value = value * 10 + (uint32_t)(*p++ - '0');
+            if (value > VERSION_PART_MAX)
+                return false;
+        }
+        parts[count++] = value;
+        if (*p != '.')
+            break;
+        p++;
+    }
+    if (count == 0)
+        return false;
+    *version = MODULE_VERSION(parts[0], parts[1], parts[2]);
+    return true;
+}
+
+bool module_parse_dev_eui(const char *line, uint64_t *dev_eui) {
+    const char *p = strchr(line, ','); // Find comma after "DevEui"
+    if (p == NULL)
+        return false;
+    p++;
+    while (*p == ' ')
+        p++;
+
+    // Exactly 16 hex digits, bytes may be separated by colons
+    uint64_t value = 0;
+    int digits = 0;
+    for (; *p != '\0' && *p != '\r' && *p != ' '; p++) {
+        if (*p == ':')
+            continue;
+        const int nibble = hex_nibble(*p);
+        if (nibble < 0 || digits == MODULE_DEV_EUI_DIGITS)
+            return false;
+        value = value << 4 | (uint64_t)nibble;
+        digits++;
+    }
+    if (digits != MODULE_DEV_EUI_DIGITS)
+        return false;
+    *dev_eui = value;
+    return true;
+}
+
+void module_format_dev_eui(char *out, const uint64_t dev_eui) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < MODULE_DEV_EUI_DIGITS; i++)
+        out[i] = digits[(dev_eui >> (60 - 4 * i)) & 0x0F];
+    out[MODULE_DEV_EUI_DIGITS] = '\0';
+}
@@ -0,0 +1,29 @@
+#ifndef MODULE_INFO_H
+#define MODULE_INFO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Identity of a LoRa module kept in binary form. The probe parses the AT
+// responses once; text is only produced when the identity is printed, and
+// comparing two modules is an integer compare.
+
+// Packed semantic version, compares in version order
+#define MODULE_VERSION(major, minor, patch) ((uint32_t)(major) << 16 | (uint32_t)(minor) << 8 | (uint32_t)(patch))
+#define MODULE_VERSION_MAJOR(v) ((unsigned)((v) >> 16))
+#define MODULE_VERSION_MINOR(v) ((unsigned)(((v) >> 8) & 0xFF))
+#define MODULE_VERSION_PATCH(v) ((unsigned)((v) & 0xFF))
+
+#define MODULE_DEV_EUI_DIGITS 16 // 8 bytes
+#define MODULE_DEV_EUI_TEXT_LEN (MODULE_DEV_EUI_DIGITS + 1)
+
+typedef struct {
+    uint64_t dev_eui;
+    uint32_t version; // MODULE_VERSION()
+} module_info_t;
+
+bool module_parse_version(const char *line, uint32_t *version); // "+VER: 4.0.11"
+bool module_parse_dev_eui(const char *line, uint64_t *dev_eui); // "+ID: DevEui, 2C:F7:F1:20:32:30:A5:70"
+void module_format_dev_eui(char *out, uint64_t dev_eui); // 16 lower-case digits without colons, null-terminated
+
+#endif
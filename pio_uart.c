@@ -0,0 +1,156 @@
+#include "pio_uart.h"
+#include <string.h>
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hot.h"
+#include "pio_uart.pio.h"
+
+// Programs are loaded once per PIO block and shared by all of its channels
+static int tx_offset[2] = { -1, -1 };
+static int rx_offset[2] = { -1, -1 };
+
+static bool load_programs(PIO pio) {
+    const uint index = pio_get_index(pio);
+    if (tx_offset[index] < 0) {
+        if (!pio_can_add_program(pio, &uart_tx_program))
+            return false;
+        tx_offset[index] = (int)pio_add_program(pio, &uart_tx_program);
+    }
+    if (rx_offset[index] < 0) {
+        if (!pio_can_add_program(pio, &uart_rx_program))
+            return false;
+        rx_offset[index] = (int)pio_add_program(pio, &uart_rx_program);
+    }
+    return true;
+}
+
+// TX and RX state machines of a channel must live in the same block, pio0 is tried first
+static bool claim_state_machines(pio_uart_t *ch) {
+    PIO const blocks[2] = { pio0, pio1 };
+    for (int i = 0; i < 2; i++) {
+        PIO pio = blocks[i];
+        if (!load_programs(pio))
+            continue;
+        const int sm_tx = pio_claim_unused_sm(pio, false);
+        if (sm_tx < 0)
+            continue;
+        const int sm_rx = pio_claim_unused_sm(pio, false);
+        if (sm_rx < 0) {
+            pio_sm_unclaim(pio, (uint)sm_tx);
+            continue;
+        }
+        ch->pio = pio;
+        ch->sm_tx = (uint)sm_tx;
+        ch->sm_rx = (uint)sm_rx;
+        return true;
+    }
+    return false;
+}
+
+// Endless RX transfer: the upper byte of each FIFO word (bits are shifted in from
+// the left) goes into rx_buf, wrapping at its end
+static void start_rx_dma(pio_uart_t *ch) {
+    dma_channel_config c = dma_channel_get_default_config(ch->dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, PIO_UART_RX_RING_BITS);
+    channel_config_set_dreq(&c, pio_get_dreq(ch->pio, ch->sm_rx, false));
+    dma_channel_configure(ch->dma_rx, &c, &ch->rx_buf[ch->rx_tail],
+        (const volatile uint8_t *)&ch->pio->rxf[ch->sm_rx] + 3, UINT32_MAX, true);
+    ch->rx_remaining = UINT32_MAX;
+}
+
+bool pio_uart_init(pio_uart_t *ch, const uint tx_pin, const uint rx_pin, const uint baud) {
+    ch->rx_tail = 0;
+    ch->overruns = 0;
+    ch->framing_errors = 0;
+    ch->baud = baud;
+    if (!claim_state_machines(ch))
+        return false;
+    const int dma_rx = dma_claim_unused_channel(false);
+    const int dma_tx = dma_claim_unused_channel(false);
+    if (dma_rx < 0 || dma_tx < 0) {
+        if (dma_rx >= 0)
+            dma_channel_unclaim((uint)dma_rx);
+        if (dma_tx >= 0)
+            dma_channel_unclaim((uint)dma_tx);
+        pio_sm_unclaim(ch->pio, ch->sm_tx);
+        pio_sm_unclaim(ch->pio, ch->sm_rx);
+        return false;
+    }
+    ch->dma_rx = (uint)dma_rx;
+    ch->dma_tx = (uint)dma_tx;
+
+    const uint index = pio_get_index(ch->pio);
+    uart_tx_program_init(ch->pio, ch->sm_tx, (uint)tx_offset[index], tx_pin, baud);
+    uart_rx_program_init(ch->pio, ch->sm_rx, (uint)rx_offset[index], rx_pin, baud);
+    start_rx_dma(ch);
+
+    // TX: bytes from tx_buf into the TX FIFO, started by each write
+    dma_channel_config c = dma_channel_get_default_config(ch->dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(ch->pio, ch->sm_tx, true));
+    dma_channel_configure(ch->dma_tx, &c, &ch->pio->txf[ch->sm_tx], ch->tx_buf, 0, false);
+    return true;
+}
+
+// Both programs run 8 cycles per bit, so the divider follows clk_sys
+void pio_uart_retune(pio_uart_t *ch) {
+    const float div = (float)clock_get_hz(clk_sys) / (8 * ch->baud);
+    pio_sm_set_clkdiv(ch->pio, ch->sm_tx, div);
+    pio_sm_set_clkdiv(ch->pio, ch->sm_rx, div);
+}
+
+// Data is copied into tx_buf and sent by DMA, so the call only waits for the
+// previous write to finish instead of for every byte to go out
+static void pio_uart_write(void *hw, const char *data, size_t len) {
+    pio_uart_t *ch = hw;
+    while (len > 0) {
+        const size_t chunk = len < PIO_UART_TX_LEN ? len : PIO_UART_TX_LEN;
+        dma_channel_wait_for_finish_blocking(ch->dma_tx);
+        memcpy(ch->tx_buf, data, chunk);
+        dma_channel_transfer_from_buffer_now(ch->dma_tx, ch->tx_buf, (uint32_t)chunk);
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+// Hand bytes written by the RX DMA since the last poll to the modem ring. The
+// write address alone cannot tell a full lap from no data, so the number of
+// new bytes comes from the transfer count.
+static void HOT_FUNC(pio_uart_poll)(void *hw, ring_t *rx, uint32_t *framing_errors) {
+    pio_uart_t *ch = hw;
+    const uint32_t remaining = dma_channel_hw_addr(ch->dma_rx)->transfer_count;
+    uint32_t count = ch->rx_remaining - remaining;
+    ch->rx_remaining = remaining;
+    if (count > PIO_UART_RX_LEN) {
+        // A lap behind: the oldest bytes are overwritten and the DMA is still
+        // writing over the rest, so the lot is dropped and reading resumes
+        // where the DMA is now
+        ch->overruns += count;
+        rx->overruns += count;
+        ch->rx_tail = (uint16_t)((ch->rx_tail + count) & (PIO_UART_RX_LEN - 1));
+        count = 0;
+    }
+    for (; count > 0; count--) {
+        ring_put(rx, ch->rx_buf[ch->rx_tail]);
+        ch->rx_tail = (ch->rx_tail + 1) & (PIO_UART_RX_LEN - 1);
+    }
+
+    // The transfer count runs out after 2^32 bytes (weeks at 9600 baud), re-arm where it stopped
+    if (!dma_channel_is_busy(ch->dma_rx))
+        start_rx_dma(ch);
+
+    // RX program raises IRQ 4 + sm on a bad stop bit. The flag is sticky, so
+    // several errors between two polls count once; recovery still sees a noisy line.
+    if (pio_interrupt_get(ch->pio, 4 + ch->sm_rx)) {
+        pio_interrupt_clear(ch->pio, 4 + ch->sm_rx);
+        ch->framing_errors++;
+        (*framing_errors)++;
+    }
+}
+
+const modem_port_t pio_uart_port = { .write = pio_uart_write, .poll = pio_uart_poll };
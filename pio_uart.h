@@ -0,0 +1,43 @@
+#ifndef PIO_UART_H
+#define PIO_UART_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/pio.h"
+#include "modem.h"
+
+// Extra 8N1 UART channels implemented with PIO state machines. Received bytes
+// are moved from the RX state machine into a RAM ring by DMA, and transmit
+// buffers are fed to the TX state machine by DMA, so the CPU only copies
+// bytes when the main loop polls the channel. Channels plug into modem_t
+// through pio_uart_port, the same way the hardware UARTs do.
+
+// Each channel needs two of the eight state machines (TX and RX)
+#define PIO_UART_MAX_CHANNELS 4
+#define PIO_UART_RX_LEN 256 // DMA ring, a power of two aligned to its own size
+#define PIO_UART_RX_RING_BITS 8 // log2(PIO_UART_RX_LEN)
+#define PIO_UART_TX_LEN 256 // Largest single write handed to the TX DMA
+
+typedef struct {
+    // DMA writes here with address wrapping, so the ring must be aligned to its size
+    uint8_t rx_buf[PIO_UART_RX_LEN] __attribute__((aligned(PIO_UART_RX_LEN)));
+    uint8_t tx_buf[PIO_UART_TX_LEN];
+    PIO pio;
+    uint sm_tx;
+    uint sm_rx;
+    uint dma_rx;
+    uint dma_tx;
+    uint baud;
+    uint16_t rx_tail; // Next byte of rx_buf to hand to the modem ring
+    uint32_t rx_remaining; // RX DMA transfer count at the last poll, it counts down once per byte
+    uint32_t overruns; // Bytes the RX DMA overwrote before a poll took them
+    uint32_t framing_errors; // Bad stop bits or line breaks seen by the RX state machine
+} pio_uart_t;
+
+// Claim state machines and DMA channels for one channel, false when none are left
+bool pio_uart_init(pio_uart_t *ch, uint tx_pin, uint rx_pin, uint baud);
+void pio_uart_retune(pio_uart_t *ch); // Recompute the bit clock after clk_sys changed
+
+extern const modem_port_t pio_uart_port; // Transport for modem_init()
+
+#endif
@@ -0,0 +1,38 @@
+#include "pool.h"
+
+void pool_init(pool_t *p, const char *name, void *storage, const size_t block_size, const size_t count) {
+    p->name = name;
+    p->block_size = (uint16_t)block_size;
+    p->count = (uint16_t)count;
+    p->in_use = 0;
+    p->high_water = 0;
+    p->exhausted = 0;
+
+    // Thread the blocks back to front so the first one is handed out first
+    p->free_list = NULL;
+    for (size_t i = count; i-- > 0;) {
+        void **block = (void **)((uint8_t *)storage + i * block_size);
+        *block = p->free_list;
+        p->free_list = block;
+    }
+}
+
+void *pool_alloc(pool_t *p) {
+    void **block = p->free_list;
+    if (block == NULL) {
+        p->exhausted++;
+        return NULL;
+    }
+    p->free_list = *block;
+    if (++p->in_use > p->high_water)
+        p->high_water = p->in_use;
+    return block;
+}
+
+void pool_free(pool_t *p, void *block) {
+    if (block == NULL)
+        return;
+    *(void **)block = p->free_list;
+    p->free_list = block;
+    p->in_use--;
+}
@@ -0,0 +1,34 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-size object pool over a statically dimensioned array. Free blocks are
+// linked through their own first word, so allocation and release are O(1) and
+// there is no per-block overhead. Pools are used from the main loop only (or
+// from the single task that owns them), there is no locking.
+
+// Storage for count objects of type, aligned for both the object and the free-list link
+#define POOL_STORAGE(name, type, count) \
+    static union { type object; void *link; } name[count]
+
+typedef struct {
+    const char *name; // Shown in reports
+    void *free_list;
+    uint16_t block_size;
+    uint16_t count;
+
+    // Statistics
+    uint16_t in_use;
+    uint16_t high_water; // Largest number of blocks allocated at once
+    uint32_t exhausted; // Allocations refused because every block was in use
+} pool_t;
+
+// Link every block of storage into the free list
+void pool_init(pool_t *p, const char *name, void *storage, size_t block_size, size_t count);
+void *pool_alloc(pool_t *p); // NULL when exhausted
+void pool_free(pool_t *p, void *block); // NULL is ignored
+
+#endif
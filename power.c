@@ -0,0 +1,47 @@
+#include "power.h"
+
+void power_init(power_t *p, const power_ops_t *ops, const uint32_t quiet_ms) {
+    p->ops = ops;
+    p->wake_count = 0;
+    p->quiet_ms = quiet_ms;
+    p->active_us = ops->now_us(ops->ctx);
+    p->sleeps = 0;
+    p->last_wake_us = 0;
+    p->max_wake_us = 0;
+}
+
+bool power_add_wake_pin(power_t *p, const uint32_t gpio) {
+    if (p->wake_count == POWER_MAX_WAKE_PINS)
+        return false;
+    p->wake_pins[p->wake_count++] = gpio;
+    return true;
+}
+
+void power_activity(power_t *p) {
+    p->active_us = p->ops->now_us(p->ops->ctx);
+}
+
+bool power_idle(power_t *p, const bool waiting) {
+    const power_ops_t *ops = p->ops;
+    // Nothing but an edge on a wake pin would bring the chip back from dormant
+    if (waiting) {
+        power_activity(p);
+        return false;
+    }
+    if (ops->now_us(ops->ctx) - p->active_us < (uint64_t)p->quiet_ms * 1000)
+        return false;
+
+    ops->save(ops->ctx, &p->saved);
+    ops->dormant(ops->ctx, p->wake_pins, p->wake_count);
+    // The timer stands still while dormant, so latency is measured from the first instruction after wake-up
+    const uint64_t woke_us = ops->now_us(ops->ctx);
+    ops->restore(ops->ctx, &p->saved);
+    const uint64_t ready_us = ops->now_us(ops->ctx);
+
+    p->sleeps++;
+    p->last_wake_us = (uint32_t)(ready_us - woke_us);
+    if (p->last_wake_us > p->max_wake_us)
+        p->max_wake_us = p->last_wake_us;
+    p->active_us = ready_us;
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Low-power idle: once nothing has happened for a quiet period the chip is put
+// into dormant mode until a falling edge on one of the wake pins (the button
+// or a module's RX line). Clock and UART state is captured before and put back
+// after, and the time from wake-up to ready is measured. The sequencing lives
+// here; the chip specific part is behind power_ops_t, like fq_storage_t for
+// the flash queue, so it can be exercised without hardware.
+
+#define POWER_MAX_WAKE_PINS 8
+#define POWER_UARTS 2
+
+// What has to survive dormant mode
+typedef struct {
+    uint32_t sys_hz; // clk_sys before sleeping
+    uint32_t uart_baud[POWER_UARTS]; // 0 when the UART was not enabled
+} power_state_t;
+
+typedef struct {
+    void (*save)(void *ctx, power_state_t *state);
+    // Stop the clocks and return after a falling edge on one of the pins
+    void (*dormant)(void *ctx, const uint32_t *wake_pins, size_t count);
+    void (*restore)(void *ctx, const power_state_t *state);
+    uint64_t (*now_us)(void *ctx);
+    void *ctx;
+} power_ops_t;
+
+typedef struct {
+    const power_ops_t *ops;
+    uint32_t wake_pins[POWER_MAX_WAKE_PINS];
+    size_t wake_count;
+    uint32_t quiet_ms; // Inactivity before sleeping
+    uint64_t active_us; // Time of the last activity
+    power_state_t saved;
+
+    // Statistics
+    uint32_t sleeps;
+    uint32_t last_wake_us; // Wake-up to ready (clocks and UARTs restored) of the last sleep
+    uint32_t max_wake_us;
+} power_t;
+
+void power_init(power_t *p, const power_ops_t *ops, uint32_t quiet_ms);
+bool power_add_wake_pin(power_t *p, uint32_t gpio); // False when POWER_MAX_WAKE_PINS are in use
+void power_activity(power_t *p); // Restart the quiet period
+// Sleep if the quiet period is over, true after a sleep. While waiting (work that
+// needs the timer, such as an uplink retry or a module response) the chip stays
+// awake and the quiet period starts again
+bool power_idle(power_t *p, bool waiting);
+
+#endif
@@ -0,0 +1,178 @@
+#include "provision.h"
+#include <stdio.h>
+#include <string.h>
+#include "hardware/gpio.h"
+
+#define PING "AT\r\n"
+#define MAX_SLOTS 8
+
+static modem_t *slot_modems;
+static provision_slot_t slots[MAX_SLOTS];
+static int slot_count;
+static bool enabled;
+static uint32_t next_ping_ms;
+static provision_stats_t stats;
+
+void provision_init(modem_t *modems, const int count) {
+    slot_modems = modems;
+    slot_count = count < MAX_SLOTS ? count : MAX_SLOTS;
+    for (int i = 0; i < slot_count; i++) {
+        slots[i].state = PROVISION_WAITING;
+        slots[i].missed = 0;
+        slots[i].attached = false;
+        slots[i].ping_pending = false;
+        slots[i].presence_pin = PROVISION_NO_PIN;
+    }
+}
+
+void provision_set_presence_pin(const int index, const int gpio) {
+    if (index < 0 || index >= slot_count)
+        return;
+    slots[index].presence_pin = gpio;
+    gpio_init(gpio);
+    gpio_set_dir(gpio, GPIO_IN);
+    gpio_pull_up(gpio);
+}
+
+void provision_enable(const bool enable, const uint32_t now_ms) {
+    enabled = enable;
+    if (!enable)
+        return;
+    memset(&stats, 0, sizeof(stats));
+    stats.started_ms = now_ms;
+    next_ping_ms = now_ms;
+    for (int i = 0; i < slot_count; i++) {
+        // A probe or uplink in progress is left to finish, a probe is then counted normally
+        if (modem_busy(&slot_modems[i]))
+            continue;
+        slots[i].state = PROVISION_WAITING;
+        slots[i].missed = 0;
+        slots[i].attached = false;
+        slots[i].ping_pending = false;
+    }
+}
+
+bool provision_enabled(void) {
+    return enabled;
+}
+
+// An answer to a ping still on its way after a boot banner would be taken for
+// the answer to the probe's first command, so the probe waits for it
+static bool ping_answered(const provision_slot_t *slot, const uint32_t now_ms) {
+    return !slot->ping_pending || now_ms - slot->ping_ms >= PROVISION_ANSWER_MS;
+}
+
+static void start_probe(const int index, const uint32_t now_ms) {
+    slots[index].state = PROVISION_PROBING;
+    slots[index].missed = 0;
+    slots[index].attached = false;
+    modem_probe_start(&slot_modems[index], now_ms);
+}
+
+// Device gone: print it once and arm the slot for the next one
+static void detach(const int index) {
+    slots[index].state = PROVISION_WAITING;
+    slots[index].missed = 0;
+    slots[index].attached = false;
+    printf("%s: device removed, ready for the next one\r\n", slot_modems[index].name);
+}
+
+void provision_poll(const uint32_t now_ms) {
+    if (!enabled)
+        return;
+    // Presence switches are sampled on every poll, a slot that is busy or claimed is left alone
+    for (int i = 0; i < slot_count; i++) {
+        provision_slot_t *slot = &slots[i];
+        const modem_t *m = &slot_modems[i];
+        if (modem_busy(m) || m->claimed)
+            continue;
+        if (slot->presence_pin == PROVISION_NO_PIN) {
+            if (slot->state == PROVISION_WAITING && slot->attached && ping_answered(slot, now_ms))
+                start_probe(i, now_ms);
+            continue;
+        }
+        const bool present = !gpio_get((uint)slot->presence_pin);
+        if (slot->state == PROVISION_WAITING && present)
+            start_probe(i, now_ms);
+        else if (slot->state == PROVISION_PRESENT && !present)
+            detach(i);
+    }
+
+    if ((int32_t)(now_ms - next_ping_ms) < 0)
+        return;
+    next_ping_ms = now_ms + PROVISION_PING_MS;
+    for (int i = 0; i < slot_count; i++) {
+        provision_slot_t *slot = &slots[i];
+        modem_t *m = &slot_modems[i];
+        if (slot->presence_pin != PROVISION_NO_PIN || slot->state == PROVISION_PROBING || modem_busy(m) ||
+            m->claimed)
+            continue;
+        // An answer to the previous ping resets missed in provision_line()
+        if (slot->state == PROVISION_PRESENT && ++slot->missed > PROVISION_DETACH_MISSES) {
+            detach(i);
+            continue;
+        }
+        modem_write_str(m, PING);
+        slot->ping_pending = true;
+        slot->ping_ms = now_ms;
+    }
+}
+
+bool provision_line(const int index, const char *line, const uint32_t now_ms) {
+    if (!enabled || index >= slot_count)
+        return false;
+    provision_slot_t *slot = &slots[index];
+    // Any line shows a device is there, only the ping answer is told apart
+    if (strstr(line, "OK") != NULL)
+        slot->ping_pending = false;
+    switch (slot->state) {
+        case PROVISION_WAITING:
+            // Ping answer or boot banner: a device has been attached
+            if (slot->presence_pin == PROVISION_NO_PIN) {
+                slot->attached = true;
+                if (ping_answered(slot, now_ms))
+                    start_probe(index, now_ms);
+            }
+            return true;
+        case PROVISION_PRESENT:
+            slot->missed = 0; // Still there
+            return true;
+        default:
+            return false;
+    }
+}
+
+void provision_probe_finished(const int index, const uint32_t now_ms) {
+    if (!enabled || index >= slot_count)
+        return;
+    const modem_t *m = &slot_modems[index];
+    if (m->state != PROBE_DONE) {
+        // Bad contact or a module that is still booting: try again right away
+        stats.failures++;
+        slots[index].state = PROVISION_WAITING;
+        return;
+    }
+
+    stats.devices++;
+    for (int i = 0; i < PROBE_STEPS; i++)
+        stats.step_total_ms[i] += m->step_ms[i];
+    slots[index].state = PROVISION_PRESENT;
+    slots[index].missed = 0;
+
+    // Per-device breakdown, running averages and throughput since the mode was enabled
+    const uint32_t elapsed_ms = now_ms - stats.started_ms;
+    const uint32_t per_hour = elapsed_ms ? (uint32_t)((uint64_t)stats.devices * 3600000 / elapsed_ms) : 0;
+    printf("%s: device %u in %u ms (AT %u, VER %u, DevEui %u ms), avg AT %u, VER %u, DevEui %u ms, %u devices/hour\r\n",
+        m->name, (unsigned)stats.devices, (unsigned)(m->finished_ms - m->started_ms),
+        (unsigned)m->step_ms[0], (unsigned)m->step_ms[1], (unsigned)m->step_ms[2],
+        (unsigned)(stats.step_total_ms[0] / stats.devices), (unsigned)(stats.step_total_ms[1] / stats.devices),
+        (unsigned)(stats.step_total_ms[2] / stats.devices), (unsigned)per_hour);
+}
+
+const provision_stats_t *provision_stats(void) {
+    return &stats;
+}
+
+provision_state_t provision_slot_state(const int index) {
+    return index >= 0 && index < slot_count ? slots[index].state : PROVISION_WAITING;
+}
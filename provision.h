@@ -0,0 +1,52 @@
+#ifndef PROVISION_H
+#define PROVISION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "modem.h"
+
+// Production-line provisioning mode. Instead of waiting for SW_0, every module
+// slot is watched for an attached device: a slot without a device is pinged
+// with "AT" and any line it answers with (or the module's boot banner) starts
+// the identity probe. After a successful probe the slot is watched for the
+// device being removed and then armed for the next one, so the operator only
+// swaps boards. Throughput and per-step probe timing are reported per device.
+
+#define PROVISION_PING_MS 250 // "AT" keep-alive / attach ping period per slot
+#define PROVISION_DETACH_MISSES 3 // Unanswered pings before a device counts as removed
+#define PROVISION_ANSWER_MS 50 // Longest a ping answer takes, the probe waits for it after a banner
+#define PROVISION_NO_PIN (-1)
+
+typedef enum {
+    PROVISION_WAITING, // No device, pinging for one
+    PROVISION_PROBING, // Identity probe running
+    PROVISION_PRESENT // Device done, waiting for it to be removed
+} provision_state_t;
+
+typedef struct {
+    provision_state_t state;
+    uint8_t missed; // Pings without an answer in a row
+    bool attached; // A line arrived while waiting, the probe starts once no ping answer is due
+    bool ping_pending; // The last ping has not been answered yet
+    uint32_t ping_ms;
+    int presence_pin; // Active-low attach switch, PROVISION_NO_PIN to detect by line activity
+} provision_slot_t;
+
+typedef struct {
+    uint32_t devices; // Successful probes since provisioning was enabled
+    uint32_t failures;
+    uint32_t started_ms;
+    uint64_t step_total_ms[PROBE_STEPS]; // Sum over successful probes, for the averages
+} provision_stats_t;
+
+void provision_init(modem_t *modems, int count);
+void provision_set_presence_pin(int index, int gpio); // Use a presence switch instead of line activity
+void provision_enable(bool enable, uint32_t now_ms);
+bool provision_enabled(void);
+void provision_poll(uint32_t now_ms); // Ping idle slots and start probes, call from the module poller
+bool provision_line(int index, const char *line, uint32_t now_ms); // Line outside a probe, true when consumed
+void provision_probe_finished(int index, uint32_t now_ms); // Probe reached PROBE_DONE or PROBE_FAILED
+const provision_stats_t *provision_stats(void);
+provision_state_t provision_slot_state(int index);
+
+#endif
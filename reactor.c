@@ -0,0 +1,141 @@
+#include "reactor.h"
+#include "pico/stdlib.h"
+#include "hot.h"
+
+typedef struct {
+    event_handler_t handler;
+    void *ctx;
+} handler_entry_t;
+
+typedef struct {
+    event_handler_t handler; // NULL when the slot is free
+    void *ctx;
+    uint32_t period_ms;
+    uint32_t due_ms;
+    bool repeat;
+} timer_entry_t;
+
+typedef struct {
+    reactor_poller_t poller;
+    void *ctx;
+} poller_entry_t;
+
+static event_queue_t queue;
+static handler_entry_t handlers[EVENT_TYPE_COUNT];
+static handler_stats_t stats[EVENT_TYPE_COUNT];
+static timer_entry_t timers[REACTOR_MAX_TIMERS];
+static poller_entry_t pollers[REACTOR_MAX_POLLERS];
+static int poller_count = 0;
+static reactor_idle_t idle_hook = NULL;
+static void *idle_ctx = NULL;
+
+void reactor_init(void) {
+    event_queue_init(&queue);
+}
+
+event_queue_t *reactor_queue(void) {
+    return &queue;
+}
+
+void reactor_register(const event_type type, const event_handler_t handler, void *ctx) {
+    handlers[type].handler = handler;
+    handlers[type].ctx = ctx;
+}
+
+bool HOT_FUNC(reactor_post)(const event_type type, const int32_t data) {
+    const event_t event = { .type = type, .data = data };
+    return event_queue_add(&queue, &event);
+}
+
+// Run a handler and account its execution time to the event type
+static void timed_call(const event_handler_t handler, void *ctx, const event_t *event) {
+    const uint32_t start = time_us_32();
+    handler(event, ctx);
+    const uint32_t elapsed = time_us_32() - start;
+    handler_stats_t *s = &stats[event->type];
+    s->calls++;
+    s->total_us += elapsed;
+    if (elapsed > s->max_us)
+        s->max_us = elapsed;
+    const uint32_t bucket = elapsed ? 32 - (uint32_t)__builtin_clz(elapsed) : 0;
+    s->histogram[bucket < REACTOR_HIST_BUCKETS ? bucket : REACTOR_HIST_BUCKETS - 1]++;
+}
+
+void reactor_dispatch(const event_t *event) {
+    const handler_entry_t *entry = &handlers[event->type];
+    if (entry->handler != NULL)
+        timed_call(entry->handler, entry->ctx, event);
+}
+
+int reactor_add_timer(const uint32_t period_ms, const bool repeat, const event_handler_t handler, void *ctx) {
+    for (int i = 0; i < REACTOR_MAX_TIMERS; i++) {
+        if (timers[i].handler == NULL) {
+            timers[i].handler = handler;
+            timers[i].ctx = ctx;
+            timers[i].period_ms = period_ms;
+            timers[i].due_ms = to_ms_since_boot(get_absolute_time()) + period_ms;
+            timers[i].repeat = repeat;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void reactor_cancel_timer(const int id) {
+    if (id >= 0 && id < REACTOR_MAX_TIMERS)
+        timers[id].handler = NULL;
+}
+
+bool reactor_add_poller(const reactor_poller_t poller, void *ctx) {
+    if (poller_count >= REACTOR_MAX_POLLERS)
+        return false;
+    pollers[poller_count].poller = poller;
+    pollers[poller_count].ctx = ctx;
+    poller_count++;
+    return true;
+}
+
+void reactor_set_idle(const reactor_idle_t idle, void *ctx) {
+    idle_hook = idle;
+    idle_ctx = ctx;
+}
+
+const handler_stats_t *reactor_stats(const event_type type) {
+    return &stats[type];
+}
+
+// Timer handlers get an EVENT_TIMER event carrying the timer id
+static void run_timers(const uint32_t now_ms) {
+    for (int i = 0; i < REACTOR_MAX_TIMERS; i++) {
+        timer_entry_t *t = &timers[i];
+        if (t->handler == NULL || (int32_t)(now_ms - t->due_ms) < 0)
+            continue;
+        const event_handler_t handler = t->handler;
+        if (t->repeat)
+            t->due_ms += t->period_ms;
+        else
+            t->handler = NULL; // Free the slot before the call so the handler can re-arm
+        const event_t event = { .type = EVENT_TIMER, .data = i };
+        timed_call(handler, t->ctx, &event);
+    }
+}
+
+void reactor_run(void) {
+    event_t event;
+    while (true) {
+        // Process pending events from the queue
+        while (event_queue_remove(&queue, &event))
+            reactor_dispatch(&event);
+
+        run_timers(to_ms_since_boot(get_absolute_time()));
+
+        bool busy = false;
+        for (int i = 0; i < poller_count; i++)
+            busy |= pollers[i].poller(pollers[i].ctx);
+
+        if (!busy && idle_hook != NULL)
+            idle_hook(idle_ctx);
+
+        sleep_ms(busy ? REACTOR_BUSY_SLEEP_MS : REACTOR_IDLE_SLEEP_MS); // Reduce CPU usage between iterations
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "event_queue.h"
+
+// Event loop with a dispatch table indexed by event type. Subsystems register
+// a handler per event type, pollers for work that is not interrupt driven and
+// software timers; the loop delivers queued events, fires due timers, runs the
+// pollers and sleeps when nothing is in progress. Every dispatch is timed, so
+// per-handler execution time is measured in one place.
+
+#define REACTOR_MAX_TIMERS 8
+#define REACTOR_MAX_POLLERS 4
+#define REACTOR_IDLE_SLEEP_MS 10 // Loop period when no poller is busy
+#define REACTOR_BUSY_SLEEP_MS 1 // Loop period while a poller has work in progress
+#define REACTOR_HIST_BUCKETS 16 // Execution time histogram, powers of two up to 16 ms and beyond
+
+typedef void (*event_handler_t)(const event_t *event, void *ctx);
+typedef bool (*reactor_poller_t)(void *ctx); // Returns true while work is in progress
+typedef void (*reactor_idle_t)(void *ctx);
+
+// Execution time of the handlers of one event type
+typedef struct {
+    uint32_t calls;
+    uint64_t total_us;
+    uint32_t max_us;
+    // Calls by execution time: bucket 0 is under 1 us, bucket n is 2^(n-1) to
+    // 2^n - 1 us and the last bucket also takes everything longer
+    uint32_t histogram[REACTOR_HIST_BUCKETS];
+} handler_stats_t;
+
+void reactor_init(void);
+event_queue_t *reactor_queue(void); // For priority/coalescing configuration and statistics
+void reactor_register(event_type type, event_handler_t handler, void *ctx); // One handler per type
+bool reactor_post(event_type type, int32_t data); // Queue an event, interrupt safe
+void reactor_dispatch(const event_t *event); // Deliver an event right away
+int reactor_add_timer(uint32_t period_ms, bool repeat, event_handler_t handler, void *ctx); // Timer id or -1
+void reactor_cancel_timer(int id);
+bool reactor_add_poller(reactor_poller_t poller, void *ctx);
+void reactor_set_idle(reactor_idle_t idle, void *ctx); // Called when no poller is busy
+const handler_stats_t *reactor_stats(event_type type);
+void reactor_run(void); // Never returns
+
+#endif
@@ -0,0 +1,172 @@
+#include "recovery.h"
+#include <string.h>
+
+#define PING "AT\r\n"
+
+static const char *const fault_names[] = { "none", "timeouts", "garbled lines", "framing errors", "requested" };
+
+// Errors up to now are what a healthy module has accumulated
+static void baseline(recovery_t *r) {
+    r->timeouts = r->m->timeouts;
+    r->garbled_lines = r->m->garbled_lines;
+    r->framing_errors = r->m->framing_errors;
+}
+
+static recovery_fault_t detect(recovery_t *r) {
+    const modem_t *m = r->m;
+    if (r->requested)
+        return RECOVERY_FAULT_REQUESTED;
+    if (m->timeouts - r->timeouts >= RECOVERY_TIMEOUTS)
+        return RECOVERY_FAULT_TIMEOUT;
+    if (m->garbled_lines - r->garbled_lines >= RECOVERY_GARBLED_LINES)
+        return RECOVERY_FAULT_GARBLED;
+    if (m->framing_errors - r->framing_errors >= RECOVERY_FRAMING_ERRORS)
+        return RECOVERY_FAULT_FRAMING;
+    return RECOVERY_FAULT_NONE;
+}
+
+// Lines are not handed to anyone else until the module is back. An uplink
+// in flight is lost with the reset and stays queued for the next attempt
+static void begin_reset(recovery_t *r, const uint32_t now_ms) {
+    r->ops->reset(r->ops->ctx, true);
+    modem_uplink_abort(r->m);
+    r->m->claimed = true;
+    r->resets++;
+    r->state = RECOVERY_RESET;
+    r->state_ms = now_ms;
+}
+
+static void finish(recovery_t *r) {
+    r->m->claimed = false;
+    r->state = RECOVERY_IDLE;
+    baseline(r);
+}
+
+static recovery_event_t retry(recovery_t *r, const uint32_t now_ms) {
+    if (r->resets < RECOVERY_MAX_RESETS) {
+        begin_reset(r, now_ms);
+        return RECOVERY_RETRY;
+    }
+    r->failures++;
+    finish(r);
+    // A probe that was interrupted by the fault ends now instead of running out its retries
+    modem_probe_abort(r->m, now_ms);
+    return RECOVERY_GAVE_UP;
+}
+
+void recovery_init(recovery_t *r, modem_t *m, const recovery_ops_t *ops) {
+    r->m = m;
+    r->ops = ops;
+    r->state = RECOVERY_IDLE;
+    r->fault = RECOVERY_FAULT_NONE;
+    r->requested = false;
+    r->resets = 0;
+    r->recoveries = 0;
+    r->failures = 0;
+    r->last_ms = 0;
+    r->max_ms = 0;
+    r->total_ms = 0;
+    baseline(r);
+}
+
+void recovery_request(recovery_t *r) {
+    r->requested = true;
+}
+
+recovery_event_t recovery_poll(recovery_t *r, const uint32_t now_ms) {
+    modem_t *m = r->m;
+    switch (r->state) {
+        case RECOVERY_IDLE: {
+            if (m->claimed)
+                return RECOVERY_NONE; // Another driver owns the module
+            const recovery_fault_t fault = detect(r);
+            if (fault == RECOVERY_FAULT_NONE)
+                return RECOVERY_NONE;
+            // A probe in progress is frozen until the module is back
+            r->fault = fault;
+            r->requested = false;
+            r->resets = 0;
+            r->fault_ms = now_ms;
+            begin_reset(r, now_ms);
+            return RECOVERY_STARTED;
+        }
+        case RECOVERY_RESET:
+            if (now_ms - r->state_ms < RECOVERY_RESET_MS)
+                return RECOVERY_NONE;
+            r->ops->reset(r->ops->ctx, false);
+            // Whatever arrived while the line was held is noise
+            modem_flush(m);
+            r->state = RECOVERY_BOOT;
+            r->state_ms = now_ms;
+            r->ping_ms = now_ms;
+            r->ping_pending = false;
+            r->up = false;
+            return RECOVERY_NONE;
+        case RECOVERY_BOOT:
+            // Boot banner or an answer to a ping: the module is up
+            while (true) {
+                const uint32_t garbled = m->garbled_lines;
+                if (!modem_poll_line(m))
+                    break;
+                if (m->garbled_lines == garbled) {
+                    r->up = true;
+                    if (strstr(m->line, "OK") != NULL)
+                        r->ping_pending = false;
+                }
+            }
+            // An answer to a ping still on its way after the banner would be taken
+            // for the answer to the probe's first command, so it is waited for
+            if (r->up && (!r->ping_pending || now_ms - r->ping_ms >= RECOVERY_PING_MS)) {
+                m->claimed = false;
+                modem_probe_start(m, now_ms);
+                r->state = RECOVERY_PROBE;
+                baseline(r);
+                return RECOVERY_NONE;
+            }
+            if (r->up)
+                return RECOVERY_NONE;
+            if (now_ms - r->state_ms >= RECOVERY_BOOT_MS)
+                return retry(r, now_ms);
+            if (now_ms - r->ping_ms >= RECOVERY_PING_MS) {
+                modem_write_str(m, PING);
+                r->ping_ms = now_ms;
+                r->ping_pending = true;
+            }
+            return RECOVERY_NONE;
+        case RECOVERY_PROBE:
+            // The probe is advanced by the module poller. A module that came
+            // up still wedged is reset again instead of running out the retries
+            if (m->timeouts - r->timeouts >= RECOVERY_TIMEOUTS)
+                return retry(r, now_ms);
+            return RECOVERY_NONE;
+        default:
+            return RECOVERY_NONE;
+    }
+}
+
+bool recovery_busy(const recovery_t *r) {
+    return r->state == RECOVERY_RESET || r->state == RECOVERY_BOOT;
+}
+
+recovery_event_t recovery_probe_finished(recovery_t *r, const uint32_t now_ms) {
+    const bool done = r->m->state == PROBE_DONE;
+    if (r->state != RECOVERY_PROBE) {
+        if (done)
+            baseline(r);
+        return RECOVERY_NONE;
+    }
+    if (!done)
+        return retry(r, now_ms);
+
+    r->recoveries++;
+    r->last_ms = now_ms - r->fault_ms;
+    r->total_ms += r->last_ms;
+    if (r->last_ms > r->max_ms)
+        r->max_ms = r->last_ms;
+    finish(r);
+    return RECOVERY_DONE;
+}
+
+const char *recovery_fault_name(const recovery_fault_t fault) {
+    return fault < sizeof(fault_names) / sizeof(fault_names[0]) ? fault_names[fault] : "?";
+}
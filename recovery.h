@@ -0,0 +1,86 @@
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "modem.h"
+
+// Fault recovery for one module. The module's error counters are watched
+// between successful probes; when responses time out, lines arrive garbled or
+// the UART sees framing errors, the module is reset, everything it sent is
+// thrown away, and it is pinged until it answers (or its boot banner
+// arrives). The identity probe then runs again. The reset line is behind
+// recovery_ops_t, like power_ops_t, so the sequencing does not depend on the
+// board. Time-to-recovery is measured from the detection to the end of the
+// successful re-probe.
+
+#define RECOVERY_TIMEOUTS 2 // Response timeouts since the last good probe that count as a wedged module
+#define RECOVERY_GARBLED_LINES 2 // Lines with control or non-ASCII bytes since the last good probe
+#define RECOVERY_FRAMING_ERRORS 8 // Framing, parity or break errors since the last good probe
+#define RECOVERY_RESET_MS 10 // Reset pulse
+#define RECOVERY_PING_MS 50 // "AT" period while waiting for the module to boot
+#define RECOVERY_BOOT_MS 1000 // No answer within this long after the reset: reset again
+#define RECOVERY_MAX_RESETS 3 // Resets per fault before giving up until the next one
+
+typedef struct {
+    void (*reset)(void *ctx, bool asserted); // Drive the module's reset line
+    void *ctx;
+} recovery_ops_t;
+
+typedef enum {
+    RECOVERY_IDLE, // Watching the error counters
+    RECOVERY_RESET, // Reset line asserted
+    RECOVERY_BOOT, // Pinging until the module answers
+    RECOVERY_PROBE // Identity probe re-establishing the module
+} recovery_state_t;
+
+typedef enum {
+    RECOVERY_FAULT_NONE,
+    RECOVERY_FAULT_TIMEOUT,
+    RECOVERY_FAULT_GARBLED,
+    RECOVERY_FAULT_FRAMING,
+    RECOVERY_FAULT_REQUESTED // recovery_request()
+} recovery_fault_t;
+
+// What happened, returned by recovery_poll() and recovery_probe_finished()
+typedef enum {
+    RECOVERY_NONE,
+    RECOVERY_STARTED, // Fault detected, the module is being reset
+    RECOVERY_RETRY, // Module did not come back, reset again
+    RECOVERY_DONE, // Re-probe succeeded, last_ms holds the time to recovery
+    RECOVERY_GAVE_UP // No answer after RECOVERY_MAX_RESETS resets
+} recovery_event_t;
+
+typedef struct {
+    modem_t *m;
+    const recovery_ops_t *ops;
+    recovery_state_t state;
+    recovery_fault_t fault; // Cause of the recovery in progress or the last one
+    bool requested;
+    uint8_t resets; // Resets for the current fault
+    uint32_t fault_ms; // Detection of the current fault
+    uint32_t state_ms; // Entry into the current state
+    uint32_t ping_ms; // Last ping while booting
+    bool ping_pending; // Its answer has not arrived yet
+    bool up; // Module has sent a good line since the reset
+    // Counters of the modem at the last good probe
+    uint32_t timeouts;
+    uint32_t garbled_lines;
+    uint32_t framing_errors;
+
+    // Statistics
+    uint32_t recoveries; // Successful
+    uint32_t failures; // Gave up
+    uint32_t last_ms; // Time to recovery of the last successful one
+    uint32_t max_ms;
+    uint64_t total_ms; // For the mean
+} recovery_t;
+
+void recovery_init(recovery_t *r, modem_t *m, const recovery_ops_t *ops);
+void recovery_request(recovery_t *r); // Recover on the next poll whatever the counters say
+recovery_event_t recovery_poll(recovery_t *r, uint32_t now_ms); // Detect faults and run the reset, call from the module poller
+bool recovery_busy(const recovery_t *r); // Reset or boot in progress, the module belongs to the recovery
+recovery_event_t recovery_probe_finished(recovery_t *r, uint32_t now_ms); // Module's probe reached PROBE_DONE or PROBE_FAILED
+const char *recovery_fault_name(recovery_fault_t fault);
+
+#endif
@@ -0,0 +1,56 @@
+#include "replay.h"
+
+static void load_next(replay_t *r) {
+    r->has_next = capture_next(&r->reader, &r->next);
+    r->next_pos = 0;
+    r->timed = false;
+}
+
+void replay_init(replay_t *r, const uint8_t *log, const size_t len, const uint32_t speed_pct) {
+    capture_reader_init(&r->reader, log, len);
+    r->speed_pct = speed_pct;
+    r->tx_expected = 0;
+    r->tx_written = 0;
+    r->rx_released = 0;
+    load_next(r);
+}
+
+void replay_write(replay_t *r, const size_t len) {
+    r->tx_written += (uint32_t)len;
+}
+
+size_t replay_poll(replay_t *r, ring_t *rx, const uint64_t now_us) {
+    size_t moved = 0;
+    while (r->has_next) {
+        if (r->next.direction == CAPTURE_TX) {
+            r->tx_expected += (uint32_t)r->next.len;
+            load_next(r);
+            continue;
+        }
+        if (r->tx_written < r->tx_expected)
+            break; // The firmware has not asked yet
+        // The gap runs from the first poll that could have released the record
+        if (!r->timed) {
+            r->due_us = now_us;
+            if (r->speed_pct != REPLAY_NO_DELAY)
+                r->due_us += (uint64_t)r->next.delta_us * 100 / r->speed_pct;
+            r->timed = true;
+        }
+        if (now_us < r->due_us)
+            break;
+        // A full ring is not a loss here, the rest of the record waits for the next poll
+        while (r->next_pos < r->next.len && ring_count(rx) < RING_SIZE - 1) {
+            ring_put(rx, r->next.data[r->next_pos++]);
+            moved++;
+        }
+        if (r->next_pos < r->next.len)
+            break;
+        load_next(r);
+    }
+    r->rx_released += (uint32_t)moved;
+    return moved;
+}
+
+bool replay_done(const replay_t *r) {
+    return !r->has_next;
+}
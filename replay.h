@@ -0,0 +1,41 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "capture.h"
+#include "ring.h"
+
+// Plays the module side of a capture back into the firmware's RX ring. The
+// TX records mark where the firmware spoke during the capture: received bytes
+// that followed a command are only released once the firmware has written at
+// least as many bytes as it had by then, so the AT engine sees the responses
+// in the order it asked for them whatever its own timing. Each received
+// record also waits for its recorded gap, scaled by the speed, counted from
+// when it could first go (the previous record released and the command it
+// answers written), as tools/capture_replay.py play does on real hardware.
+// With speed REPLAY_NO_DELAY records go as fast as the ring takes them.
+
+#define REPLAY_REALTIME 100 // Speed in percent: the captured gaps unchanged
+#define REPLAY_NO_DELAY 0
+
+typedef struct {
+    capture_reader_t reader;
+    capture_record_t next; // Record waiting to be released
+    bool has_next;
+    size_t next_pos; // Bytes of next already in the ring
+    bool timed; // due_us holds the release time of next
+    uint64_t due_us;
+    uint32_t speed_pct; // Gaps are divided by speed_pct / 100, REPLAY_NO_DELAY for none
+    uint32_t tx_expected; // Bytes the firmware had written at the capture's current point
+    uint32_t tx_written; // Bytes the firmware has written during the replay
+    uint32_t rx_released;
+} replay_t;
+
+void replay_init(replay_t *r, const uint8_t *log, size_t len, uint32_t speed_pct);
+void replay_write(replay_t *r, size_t len); // Account bytes the firmware sent
+size_t replay_poll(replay_t *r, ring_t *rx, uint64_t now_us); // Move what may be released by now into rx, bytes moved
+bool replay_done(const replay_t *r); // Every record has been released
+
+#endif
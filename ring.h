@@ -0,0 +1,51 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Single-producer/single-consumer byte ring. The producer is an interrupt
+// handler and the consumer is the main loop, so no locking is needed: each
+// side only ever writes its own index.
+
+#define RING_SIZE 256 // Must be a power of two
+
+typedef struct {
+    volatile uint16_t head; // Written by the producer
+    volatile uint16_t tail; // Written by the consumer
+    uint32_t overruns; // Bytes dropped because the ring was full
+    uint8_t buf[RING_SIZE];
+} ring_t;
+
+static inline void ring_init(ring_t *r) {
+    r->head = 0;
+    r->tail = 0;
+    r->overruns = 0;
+}
+
+static inline uint16_t ring_count(const ring_t *r) {
+    return (uint16_t)((r->head - r->tail) & (RING_SIZE - 1));
+}
+
+static inline bool ring_put(ring_t *r, const uint8_t c) {
+    const uint16_t head = r->head;
+    const uint16_t next = (head + 1) & (RING_SIZE - 1);
+    if (next == r->tail) {
+        r->overruns++;
+        return false;
+    }
+    r->buf[head] = c;
+    r->head = next;
+    return true;
+}
+
+static inline bool ring_get(ring_t *r, uint8_t *c) {
+    const uint16_t tail = r->tail;
+    if (tail == r->head)
+        return false;
+    *c = r->buf[tail];
+    r->tail = (tail + 1) & (RING_SIZE - 1);
+    return true;
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "modem.h"
+#include "app.h"
+
+// FreeRTOS-SMP variant of the event loop in main.c. The modem task owns every
+// LoRa module and sleeps until a UART interrupt or the button notifies it; the
+// background task does flash maintenance on the other core whenever no probe
+// is running, the same rule the bare-metal idle hook follows.
+
+#define SW_0 9 // Same button as the bare-metal build
+
+#define MODEM_TASK_STACK 1024 // Words
+#define BACKGROUND_TASK_STACK 512 // Words
+#define MODEM_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+#define BACKGROUND_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#define MODEM_TASK_CORE (1u << 1) // Core affinity masks
+#define BACKGROUND_TASK_CORE (1u << 0)
+
+#define NOTIFY_BUTTON (1u << 0) // Task notification bit for a debounced button press
+#define BUSY_POLL_MS 1 // PIO channels are polled, so keep polling quickly during a probe
+#define IDLE_POLL_MS 10
+#define BACKGROUND_PERIOD_MS 10
+
+static TaskHandle_t modem_task_handle;
+static volatile bool modems_busy = false; // A probe is in progress, flash work has to wait
+static SemaphoreHandle_t uplinks_lock; // Draining and erasing the uplink queue must not overlap
+
+void rtos_button_handler(uint gpio, button_action_t action); // Debounced button action from the alarm interrupt
+void modem_task(void *param); // LoRa module I/O and probes
+void background_task(void *param); // Flash queue maintenance
+
+int main() {
+    // Initialize chosen serial port
+    stdio_init_all();
+
+    uplinks_lock = xSemaphoreCreateMutex();
+    xTaskCreate(modem_task, "modem", MODEM_TASK_STACK, NULL, MODEM_TASK_PRIORITY, &modem_task_handle);
+    vTaskCoreAffinitySet(modem_task_handle, MODEM_TASK_CORE);
+    TaskHandle_t background;
+    xTaskCreate(background_task, "background", BACKGROUND_TASK_STACK, NULL, BACKGROUND_TASK_PRIORITY, &background);
+    vTaskCoreAffinitySet(background, BACKGROUND_TASK_CORE);
+
+    vTaskStartScheduler(); // Never returns
+}
+
+void modem_task(void *param) {
+    (void)param;
+    // Modules are set up from this task so their UART interrupts notify it
+    app_init(rtos_button_handler);
+
+    while (true) {
+        uint32_t bits = 0;
+        const uint32_t wait_ms = modems_busy ? BUSY_POLL_MS : IDLE_POLL_MS;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(wait_ms));
+        if (bits & NOTIFY_BUTTON)
+            start_probes();
+        // MODEM_NOTIFY_RX or timeout: assemble lines and advance the probes
+        xSemaphoreTake(uplinks_lock, portMAX_DELAY);
+        modems_busy = poll_modems(NULL);
+        xSemaphoreGive(uplinks_lock);
+    }
+}
+
+void background_task(void *param) {
+    (void)param;
+    while (true) {
+        if (!modems_busy && xSemaphoreTake(uplinks_lock, 0) == pdTRUE) {
+            on_idle(NULL);
+            xSemaphoreGive(uplinks_lock);
+        }
+        vTaskDelay(pdMS_TO_TICKS(BACKGROUND_PERIOD_MS));
+    }
+}
+
+// Single presses wake the modem task directly, double and long presses are not used here
+void rtos_button_handler(uint const gpio, button_action_t const action) {
+    if (gpio == SW_0 && action == BUTTON_PRESS) {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyFromISR(modem_task_handle, NOTIFY_BUTTON, eSetBits, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+// configCHECK_FOR_STACK_OVERFLOW: stop with the task name instead of corrupting memory
+void vApplicationStackOverflowHook(TaskHandle_t task, char *name) {
+    (void)task;
+    panic("Stack overflow in task %s", name);
+}
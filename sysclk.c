@@ -0,0 +1,33 @@
+#include "sysclk.h"
+#include "hardware/clocks.h"
+
+#define SYSCLK_UARTS 2
+
+// Baud rate = clk_peri / (16 * (IBRD + FBRD / 64))
+uint32_t sysclk_uart_baud(uart_inst_t *uart) {
+    const uint32_t divider = uart_get_hw(uart)->ibrd * 64 + uart_get_hw(uart)->fbrd;
+    return divider ? (uint32_t)((uint64_t)clock_get_hz(clk_peri) * 4 / divider) : 0;
+}
+
+bool sysclk_set_khz(const uint32_t khz) {
+    uint vco, postdiv1, postdiv2;
+    if (!check_sys_clock_khz(khz, &vco, &postdiv1, &postdiv2))
+        return false;
+
+    uint32_t baud[SYSCLK_UARTS];
+    for (uint i = 0; i < SYSCLK_UARTS; i++) {
+        uart_inst_t *uart = uart_get_instance(i);
+        baud[i] = uart_is_enabled(uart) ? sysclk_uart_baud(uart) : 0;
+        // A character in flight would be garbled by the divider change
+        if (baud[i])
+            uart_tx_wait_blocking(uart);
+    }
+
+    set_sys_clock_pll(vco, postdiv1, postdiv2);
+
+    for (uint i = 0; i < SYSCLK_UARTS; i++) {
+        if (baud[i])
+            uart_set_baudrate(uart_get_instance(i), baud[i]);
+    }
+    return true;
+}
@@ -0,0 +1,15 @@
+#ifndef SYSCLK_H
+#define SYSCLK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/uart.h"
+
+// Changing clk_sys with set_sys_clock_khz() also moves clk_peri, which clocks
+// the UARTs. sysclk_set_khz() puts every enabled UART (uart1 for the module,
+// uart0 for stdio) back on the baud rate it had before the change.
+
+uint32_t sysclk_uart_baud(uart_inst_t *uart); // Current baud rate from the divider registers
+bool sysclk_set_khz(uint32_t khz); // False if the PLL cannot produce khz, nothing is changed then
+
+#endif
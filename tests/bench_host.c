@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <time.h>
+#include "bench.h"
+
+// Host build of the benchmark suite: the kernels of bench_cases.c, the same
+// ones the LORA_BENCH firmware runs, timed with the monotonic clock of the
+// build machine. The whole suite takes a few seconds, and the JSON line goes
+// to tools/bench_compare.py against tools/bench_baseline.json.
+
+#define BENCH_MIN_MS 50 // Shortest measured run per case
+#define BENCH_REPEATS 5 // The build machine runs other work, keep the fastest run
+
+static uint64_t bench_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+int main(void) {
+    const bench_config_t config = {
+        .clock = bench_clock_ns,
+        .ticks_per_second = 1000000000u,
+        .cycles = false,
+        .min_ticks = (uint64_t)BENCH_MIN_MS * 1000000u,
+        .repeats = BENCH_REPEATS
+    };
+    static bench_result_t results[BENCH_MAX_CASES];
+    if (bench_case_count > BENCH_MAX_CASES) {
+        printf("BENCH_MAX_CASES is too small for %u cases\n", (unsigned)bench_case_count);
+        return 1;
+    }
+    printf("Benchmark, host monotonic clock\r\n");
+    bench_run_all(&config, bench_cases, bench_case_count, results);
+    bench_print_table(&config, results, bench_case_count);
+    bench_print_json(&config, results, bench_case_count);
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// Assertions for the host tests. A failed check is printed with its location
+// and the test goes on; main() returns check_result() so ctest sees the failure.
+
+static int check_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            check_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        const long long check_a = (long long)(actual), check_e = (long long)(expected); \
+        if (check_a != check_e) { \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, check_a, check_e); \
+            check_failures++; \
+        } \
+    } while (0)
+
+#define RUN(test) \
+    do { \
+        const int check_before = check_failures; \
+        test(); \
+        printf("%-40s %s\n", #test, check_failures == check_before ? "ok" : "FAILED"); \
+    } while (0)
+
+static inline int check_result(void) {
+    return check_failures ? 1 : 0;
+}
+
+#endif
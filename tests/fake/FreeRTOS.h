@@ -0,0 +1,31 @@
+#ifndef FAKE_FREERTOS_H
+#define FAKE_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Host stand-in for the FreeRTOS-SMP kernel, the part of the API rtos_main.c
+// and modem.c use. Tasks are threads that run one at a time on the virtual
+// clock of fake_sdk.h; fake_freertos.h lets the test run the scheduler.
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define portMAX_DELAY 0xffffffffu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms)) // configTICK_RATE_HZ 1000
+#define tskIDLE_PRIORITY 0
+#define portYIELD_FROM_ISR(woken) (void)(woken) // The woken task runs before the next tick
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
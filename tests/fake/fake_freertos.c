@@ -0,0 +1,311 @@
+#include "fake_freertos.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fake_sdk.h"
+#include "semphr.h"
+#include "stream_buffer.h"
+
+#define FAKE_MAX_TASKS 8
+
+struct fake_task {
+    const char *name;
+    TaskFunction_t code;
+    void *param;
+    UBaseType_t priority;
+    UBaseType_t affinity;
+    pthread_t thread;
+    pthread_cond_t run; // Signalled when the task is given the CPU
+    bool ready;
+    bool timed; // Blocked with a timeout ending at wake_ms
+    uint32_t wake_ms;
+    bool waiting_notify;
+    SemaphoreHandle_t waiting_sem;
+    uint32_t notified; // Notification value
+    bool pending; // Notification not taken yet
+    uint32_t wakeups;
+};
+
+struct fake_semaphore {
+    bool taken;
+};
+
+struct fake_stream_buffer {
+    uint8_t *data;
+    size_t size;
+    size_t head; // Oldest byte
+    size_t count;
+};
+
+// The task that runs holds the CPU, everyone else waits on the kernel lock
+static pthread_mutex_t kernel = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t yielded = PTHREAD_COND_INITIALIZER; // The running task blocked
+static struct fake_task tasks[FAKE_MAX_TASKS];
+static int task_count;
+static struct fake_task *current; // NULL while the test thread runs
+static bool started;
+
+// Give up the CPU until made ready again, called with the kernel lock held
+static void block(struct fake_task *t) {
+    t->ready = false;
+    current = NULL;
+    pthread_cond_signal(&yielded);
+    while (current != t)
+        pthread_cond_wait(&t->run, &kernel);
+}
+
+static void wake(struct fake_task *t) {
+    t->ready = true;
+    t->timed = false;
+    t->waiting_notify = false;
+    t->waiting_sem = NULL;
+}
+
+static void set_timeout(struct fake_task *t, const TickType_t ticks) {
+    if (ticks != portMAX_DELAY) {
+        t->timed = true;
+        t->wake_ms = fake_now_ms() + ticks;
+    }
+}
+
+static void *task_thread(void *arg) {
+    struct fake_task *t = arg;
+    pthread_mutex_lock(&kernel);
+    while (current != t)
+        pthread_cond_wait(&t->run, &kernel);
+    pthread_mutex_unlock(&kernel);
+    t->code(t->param);
+    // A FreeRTOS task must not return, this one is simply never scheduled again
+    pthread_mutex_lock(&kernel);
+    t->ready = false;
+    current = NULL;
+    pthread_cond_signal(&yielded);
+    pthread_mutex_unlock(&kernel);
+    return NULL;
+}
+
+// Hand the CPU to the ready task of highest priority until none is ready
+static void run_ready(void) {
+    pthread_mutex_lock(&kernel);
+    while (started) {
+        struct fake_task *next = NULL;
+        for (int i = 0; i < task_count; i++) {
+            if (tasks[i].ready && (next == NULL || tasks[i].priority > next->priority))
+                next = &tasks[i];
+        }
+        if (next == NULL)
+            break;
+        next->wakeups++;
+        current = next;
+        pthread_cond_signal(&next->run);
+        while (current != NULL)
+            pthread_cond_wait(&yielded, &kernel);
+    }
+    pthread_mutex_unlock(&kernel);
+}
+
+// One tick: alarms and interrupts of the millisecond, then the timeouts that ended
+static void tick(void) {
+    fake_advance_ms(1);
+    pthread_mutex_lock(&kernel);
+    const uint32_t now = fake_now_ms();
+    for (int i = 0; i < task_count; i++) {
+        struct fake_task *t = &tasks[i];
+        if (!t->ready && t->timed && (int32_t)(now - t->wake_ms) >= 0)
+            wake(t);
+    }
+    pthread_mutex_unlock(&kernel);
+}
+
+void fake_rtos_start(int (*firmware_main)(void), void (*tests)(void)) {
+    firmware_main(); // vTaskStartScheduler() returns here
+    tests();
+}
+
+void fake_rtos_run_ms(const uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        run_ready();
+        tick();
+    }
+    run_ready();
+}
+
+TaskHandle_t fake_rtos_task(const char *name) {
+    for (int i = 0; i < task_count; i++) {
+        if (strcmp(tasks[i].name, name) == 0)
+            return &tasks[i];
+    }
+    return NULL;
+}
+
+uint32_t fake_rtos_wakeups(TaskHandle_t task) {
+    return task->wakeups;
+}
+
+UBaseType_t fake_rtos_affinity(TaskHandle_t task) {
+    return task->affinity;
+}
+
+UBaseType_t fake_rtos_priority(TaskHandle_t task) {
+    return task->priority;
+}
+
+BaseType_t xTaskCreate(const TaskFunction_t code, const char *name, const uint32_t stack_words, void *param,
+    const UBaseType_t priority, TaskHandle_t *created) {
+    (void)stack_words;
+    if (task_count == FAKE_MAX_TASKS)
+        return pdFALSE;
+    struct fake_task *t = &tasks[task_count++];
+    *t = (struct fake_task){ .name = name, .code = code, .param = param, .priority = priority, .ready = true };
+    pthread_cond_init(&t->run, NULL);
+    pthread_create(&t->thread, NULL, task_thread, t);
+    if (created != NULL)
+        *created = t;
+    return pdPASS;
+}
+
+void vTaskCoreAffinitySet(TaskHandle_t task, const UBaseType_t core_mask) {
+    task->affinity = core_mask;
+}
+
+void vTaskStartScheduler(void) {
+    pthread_mutex_lock(&kernel);
+    started = true;
+    pthread_mutex_unlock(&kernel);
+}
+
+void vTaskDelay(const TickType_t ticks) {
+    if (ticks == 0)
+        return;
+    pthread_mutex_lock(&kernel);
+    struct fake_task *t = current;
+    set_timeout(t, ticks);
+    block(t);
+    pthread_mutex_unlock(&kernel);
+}
+
+BaseType_t xTaskNotifyWait(const uint32_t clear_on_entry, const uint32_t clear_on_exit, uint32_t *value,
+    const TickType_t ticks) {
+    pthread_mutex_lock(&kernel);
+    struct fake_task *t = current;
+    if (!t->pending) {
+        t->notified &= ~clear_on_entry;
+        if (ticks > 0) {
+            t->waiting_notify = true;
+            set_timeout(t, ticks);
+            block(t);
+        }
+    }
+    const bool received = t->pending;
+    if (value != NULL)
+        *value = t->notified;
+    if (received) {
+        t->notified &= ~clear_on_exit;
+        t->pending = false;
+    }
+    pthread_mutex_unlock(&kernel);
+    return received ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, const uint32_t value, const eNotifyAction action,
+    BaseType_t *woken) {
+    pthread_mutex_lock(&kernel);
+    switch (action) {
+    case eSetBits:
+        task->notified |= value;
+        break;
+    case eIncrement:
+        task->notified++;
+        break;
+    case eSetValueWithOverwrite:
+        task->notified = value;
+        break;
+    case eNoAction:
+        break;
+    }
+    task->pending = true;
+    if (task->waiting_notify) {
+        wake(task);
+        if (woken != NULL && (current == NULL || task->priority > current->priority))
+            *woken = pdTRUE;
+    }
+    pthread_mutex_unlock(&kernel);
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    pthread_mutex_lock(&kernel);
+    TaskHandle_t t = current;
+    pthread_mutex_unlock(&kernel);
+    return t;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return calloc(1, sizeof(struct fake_semaphore));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, const TickType_t ticks) {
+    pthread_mutex_lock(&kernel);
+    struct fake_task *t = current;
+    const uint32_t deadline = fake_now_ms() + ticks;
+    while (sem->taken && ticks > 0 && t != NULL) {
+        if (ticks != portMAX_DELAY && (int32_t)(fake_now_ms() - deadline) >= 0)
+            break;
+        t->waiting_sem = sem;
+        set_timeout(t, ticks == portMAX_DELAY ? ticks : deadline - fake_now_ms());
+        block(t);
+    }
+    const bool got = !sem->taken;
+    sem->taken = true;
+    pthread_mutex_unlock(&kernel);
+    return got ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    pthread_mutex_lock(&kernel);
+    sem->taken = false;
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].waiting_sem == sem)
+            wake(&tasks[i]);
+    }
+    pthread_mutex_unlock(&kernel);
+    return pdTRUE;
+}
+
+StreamBufferHandle_t xStreamBufferCreate(const size_t size, const size_t trigger_level) {
+    (void)trigger_level;
+    struct fake_stream_buffer *sb = calloc(1, sizeof(*sb));
+    sb->data = malloc(size);
+    sb->size = size;
+    return sb;
+}
+
+size_t xStreamBufferSendFromISR(StreamBufferHandle_t sb, const void *data, const size_t len, BaseType_t *woken) {
+    (void)woken;
+    pthread_mutex_lock(&kernel);
+    size_t n = 0;
+    for (; n < len && sb->count < sb->size; n++, sb->count++)
+        sb->data[(sb->head + sb->count) % sb->size] = ((const uint8_t *)data)[n];
+    pthread_mutex_unlock(&kernel);
+    return n;
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t sb, void *data, const size_t len, const TickType_t ticks) {
+    (void)ticks;
+    pthread_mutex_lock(&kernel);
+    size_t n = 0;
+    for (; n < len && sb->count > 0; n++, sb->count--) {
+        ((uint8_t *)data)[n] = sb->data[sb->head];
+        sb->head = (sb->head + 1) % sb->size;
+    }
+    pthread_mutex_unlock(&kernel);
+    return n;
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t sb) {
+    pthread_mutex_lock(&kernel);
+    const size_t n = sb->count;
+    pthread_mutex_unlock(&kernel);
+    return n;
+}
@@ -0,0 +1,33 @@
+#ifndef FAKE_FREERTOS_CONTROL_H
+#define FAKE_FREERTOS_CONTROL_H
+
+#include <stdint.h>
+// Not the stand-in's headers next to this file when test_rtos is built on the real kernel
+#include <FreeRTOS.h>
+#include <task.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Test-side controls of the FreeRTOS stand-in. Only one task runs at a time,
+// like the POSIX port: the ready task of highest priority runs until it
+// blocks, then the next one. Time does not pass while a task runs; between
+// ticks the test thread plays the interrupts (fake_sdk.h alarms and GPIO
+// edges, fake_uart_receive()). With FREERTOS_KERNEL_PATH the same controls
+// drive the real kernel instead (freertos/rtos_control.c).
+
+// Runs firmware_main(), which creates the tasks and starts the scheduler, then
+// tests(). On the real kernel tests() runs in a task above the firmware's.
+void fake_rtos_start(int (*firmware_main)(void), void (*tests)(void));
+void fake_rtos_run_ms(uint32_t ms); // Ready tasks run until they block, then one tick, ms times
+TaskHandle_t fake_rtos_task(const char *name); // NULL when no task has that name
+uint32_t fake_rtos_wakeups(TaskHandle_t task); // Times the task was given the CPU
+UBaseType_t fake_rtos_affinity(TaskHandle_t task); // vTaskCoreAffinitySet() mask, 0 for any core
+UBaseType_t fake_rtos_priority(TaskHandle_t task);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+#include "fake_sdk.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+
+typedef struct {
+    alarm_id_t id; // 0 when the slot is free
+    uint64_t due_us;
+    alarm_callback_t callback;
+    void *user_data;
+} fake_alarm_t;
+
+typedef struct {
+    bool input; // Level seen by gpio_get() on an input
+    bool output; // Level driven by gpio_put()
+    bool is_output;
+    uint32_t irq_events; // Enabled edge interrupts
+} fake_gpio_t;
+
+#define DR_UNWRITTEN UINT32_MAX // hw.dr when nothing has been written to it
+
+struct uart_inst {
+    uint index;
+    uart_hw_t hw; // Written to transmit, dr is collected into tx
+    uart_hw_t rx_hw; // Read after uart_is_readable(), dr holds the received byte
+    uint8_t fifo[FAKE_UART_FIFO]; // Received, not yet read
+    uint8_t fifo_len;
+    bool staged; // uart_is_readable() moved fifo[0] into rx_hw.dr
+    bool rx_irq; // RX interrupt enabled
+    char tx[FAKE_UART_TX_LEN]; // Transmitted, not yet taken by fake_uart_sent()
+    size_t tx_len;
+};
+
+static uint64_t now_us;
+static fake_alarm_t alarms[FAKE_MAX_ALARMS];
+static alarm_id_t next_alarm_id;
+static fake_gpio_t gpios[NUM_BANK0_GPIOS];
+static gpio_irq_callback_t gpio_callback;
+static struct uart_inst uarts[2] = { { .index = 0, .hw.dr = DR_UNWRITTEN }, { .index = 1, .hw.dr = DR_UNWRITTEN } };
+static irq_handler_t irq_handlers[32];
+static bool irq_enabled[32];
+uart_inst_t *const fake_uart0 = &uarts[0];
+uart_inst_t *const fake_uart1 = &uarts[1];
+
+void fake_sdk_reset(void) {
+    now_us = 0;
+    next_alarm_id = 1;
+    gpio_callback = NULL;
+    for (int i = 0; i < FAKE_MAX_ALARMS; i++)
+        alarms[i].id = 0;
+    for (int i = 0; i < NUM_BANK0_GPIOS; i++)
+        gpios[i] = (fake_gpio_t){ .input = true };
+    for (uint i = 0; i < 2; i++)
+        uarts[i] = (struct uart_inst){ .index = i, .hw.dr = DR_UNWRITTEN };
+    for (int i = 0; i < 32; i++) {
+        irq_handlers[i] = NULL;
+        irq_enabled[i] = false;
+    }
+}
+
+// Earliest alarm due at or before until, NULL when none
+static fake_alarm_t *next_due(const uint64_t until) {
+    fake_alarm_t *first = NULL;
+    for (int i = 0; i < FAKE_MAX_ALARMS; i++) {
+        if (alarms[i].id != 0 && alarms[i].due_us <= until && (first == NULL || alarms[i].due_us < first->due_us))
+            first = &alarms[i];
+    }
+    return first;
+}
+
+void fake_advance_us(const uint64_t us) {
+    const uint64_t until = now_us + us;
+    fake_alarm_t *a;
+    while ((a = next_due(until)) != NULL) {
+        if (a->due_us > now_us)
+            now_us = a->due_us;
+        const alarm_id_t id = a->id;
+        a->id = 0;
+        const int64_t again = a->callback(id, a->user_data);
+        if (again != 0)
+            add_alarm_in_ms((uint32_t)((again < 0 ? -again : again) / 1000), a->callback, a->user_data, true);
+    }
+    now_us = until;
+}
+
+void fake_advance_ms(const uint32_t ms) {
+    fake_advance_us((uint64_t)ms * 1000);
+}
+
+uint32_t fake_now_ms(void) {
+    return (uint32_t)(now_us / 1000);
+}
+
+void fake_gpio_drive(const uint gpio, const bool level) {
+    fake_gpio_t *g = &gpios[gpio];
+    if (g->input == level)
+        return;
+    g->input = level;
+    const uint32_t edge = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if ((g->irq_events & edge) && gpio_callback != NULL)
+        gpio_callback(gpio, edge);
+}
+
+// A byte written straight into the data register is transmitted
+static void collect_dr(uart_inst_t *uart) {
+    if (uart->hw.dr != DR_UNWRITTEN && uart->tx_len < FAKE_UART_TX_LEN)
+        uart->tx[uart->tx_len++] = (char)uart->hw.dr;
+    uart->hw.dr = DR_UNWRITTEN;
+}
+
+static void uart_irq(uart_inst_t *uart) {
+    const uint irq = uart->index ? UART1_IRQ : UART0_IRQ;
+    if (uart->rx_irq && irq_enabled[irq] && irq_handlers[irq] != NULL && (uart->fifo_len > 0 || uart->staged))
+        irq_handlers[irq]();
+}
+
+void fake_uart_receive(uart_inst_t *uart, const uint8_t *data, size_t len) {
+    while (len-- > 0) {
+        if (uart->fifo_len < FAKE_UART_FIFO)
+            uart->fifo[uart->fifo_len++] = *data;
+        else
+            uart->hw.rsr |= UART_UARTRSR_OE_BITS;
+        data++;
+    }
+    uart_irq(uart);
+}
+
+size_t fake_uart_sent(uart_inst_t *uart, char *out, const size_t max) {
+    collect_dr(uart);
+    const size_t n = uart->tx_len < max ? uart->tx_len : max;
+    memcpy(out, uart->tx, n);
+    memmove(uart->tx, uart->tx + n, uart->tx_len - n);
+    uart->tx_len -= n;
+    return n;
+}
+
+size_t fake_uart_fifo_level(uart_inst_t *uart) {
+    return uart->fifo_len + (uart->staged ? 1u : 0u);
+}
+
+bool fake_uart_rx_irq_enabled(uart_inst_t *uart) {
+    return uart->rx_irq;
+}
+
+bool fake_gpio_output(const uint gpio) {
+    return gpios[gpio].output;
+}
+
+bool fake_gpio_is_output(const uint gpio) {
+    return gpios[gpio].is_output;
+}
+
+absolute_time_t get_absolute_time(void) {
+    return now_us;
+}
+
+uint32_t to_ms_since_boot(const absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+uint64_t time_us_64(void) {
+    return now_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)now_us;
+}
+
+void sleep_ms(const uint32_t ms) {
+    fake_advance_ms(ms);
+}
+
+void sleep_us(const uint64_t us) {
+    fake_advance_us(us);
+}
+
+void tight_loop_contents(void) {
+    fake_advance_us(1);
+}
+
+alarm_id_t add_alarm_in_ms(const uint32_t ms, const alarm_callback_t callback, void *user_data, const bool fire_if_past) {
+    (void)fire_if_past;
+    for (int i = 0; i < FAKE_MAX_ALARMS; i++) {
+        if (alarms[i].id == 0) {
+            alarms[i] = (fake_alarm_t){ next_alarm_id++, now_us + (uint64_t)ms * 1000, callback, user_data };
+            return alarms[i].id;
+        }
+    }
+    return -1;
+}
+
+bool cancel_alarm(const alarm_id_t id) {
+    for (int i = 0; i < FAKE_MAX_ALARMS; i++) {
+        if (alarms[i].id == id && id != 0) {
+            alarms[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+int getchar_timeout_us(const uint32_t timeout_us) {
+    (void)timeout_us;
+    return PICO_ERROR_TIMEOUT;
+}
+
+void panic(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    printf("\n");
+    exit(3);
+}
+
+void gpio_init(const uint gpio) {
+    gpios[gpio].is_output = false;
+    gpios[gpio].output = false;
+}
+
+void gpio_set_function(const uint gpio, const enum gpio_function fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_set_dir(const uint gpio, const bool out) {
+    gpios[gpio].is_output = out;
+}
+
+void gpio_pull_up(const uint gpio) {
+    (void)gpio;
+}
+
+bool gpio_get(const uint gpio) {
+    return gpios[gpio].is_output ? gpios[gpio].output : gpios[gpio].input;
+}
+
+void gpio_put(const uint gpio, const bool value) {
+    gpios[gpio].output = value;
+}
+
+void gpio_set_irq_enabled(const uint gpio, const uint32_t events, const bool enabled) {
+    if (enabled)
+        gpios[gpio].irq_events |= events;
+    else
+        gpios[gpio].irq_events &= ~events;
+}
+
+void gpio_set_irq_enabled_with_callback(const uint gpio, const uint32_t events, const bool enabled,
+    const gpio_irq_callback_t callback) {
+    gpio_callback = callback;
+    gpio_set_irq_enabled(gpio, events, enabled);
+}
+
+void gpio_acknowledge_irq(const uint gpio, const uint32_t events) {
+    (void)gpio;
+    (void)events;
+}
+
+void irq_set_exclusive_handler(const uint num, const irq_handler_t handler) {
+    irq_handlers[num] = handler;
+}
+
+void irq_set_enabled(const uint num, const bool enabled) {
+    irq_enabled[num] = enabled;
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+void restore_interrupts(const uint32_t status) {
+    (void)status;
+}
+
+void stdio_init_all(void) {
+}
+
+// Hardware UARTs at the register level modem.c uses: bytes come in through
+// fake_uart_receive(), transmitted bytes collect until fake_uart_sent()
+uint uart_init(uart_inst_t *uart, const uint baud) {
+    (void)uart;
+    return baud;
+}
+
+uint uart_set_baudrate(uart_inst_t *uart, const uint baud) {
+    (void)uart;
+    return baud;
+}
+
+void uart_set_format(uart_inst_t *uart, const uint data_bits, const uint stop_bits, const uart_parity_t parity) {
+    (void)uart;
+    (void)data_bits;
+    (void)stop_bits;
+    (void)parity;
+}
+
+void uart_set_fifo_enabled(uart_inst_t *uart, const bool enabled) {
+    (void)uart;
+    (void)enabled;
+}
+
+void uart_set_hw_flow(uart_inst_t *uart, const bool cts, const bool rts) {
+    (void)uart;
+    (void)cts;
+    (void)rts;
+}
+
+// Enabling the RX interrupt with bytes in the FIFO raises it at once
+void uart_set_irq_enables(uart_inst_t *uart, const bool rx, const bool tx) {
+    (void)tx;
+    const bool was = uart->rx_irq;
+    uart->rx_irq = rx;
+    if (rx && !was)
+        uart_irq(uart);
+}
+
+// The next FIFO byte is put in rx_hw.dr, where the caller reads it after this
+bool uart_is_readable(uart_inst_t *uart) {
+    if (!uart->staged && uart->fifo_len > 0) {
+        uart->rx_hw.dr = uart->fifo[0];
+        memmove(uart->fifo, uart->fifo + 1, --uart->fifo_len);
+        uart->staged = true;
+    }
+    return uart->staged;
+}
+
+bool uart_is_writable(uart_inst_t *uart) {
+    (void)uart;
+    return true;
+}
+
+void uart_putc_raw(uart_inst_t *uart, const char c) {
+    collect_dr(uart);
+    if (uart->tx_len < FAKE_UART_TX_LEN)
+        uart->tx[uart->tx_len++] = c;
+}
+
+uint uart_get_index(uart_inst_t *uart) {
+    return uart->index;
+}
+
+// A byte staged by uart_is_readable() counts as read by the access that
+// follows. Otherwise the access is a write: whatever the previous one put in
+// dr is transmitted first. The receive status reads from either
+uart_hw_t *uart_get_hw(uart_inst_t *uart) {
+    if (uart->staged) {
+        uart->staged = false;
+        uart->rx_hw.rsr = uart->hw.rsr;
+        return &uart->rx_hw;
+    }
+    collect_dr(uart);
+    return &uart->hw;
+}
@@ -0,0 +1,36 @@
+#ifndef FAKE_SDK_H
+#define FAKE_SDK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Test-side controls of the host SDK stand-in: virtual time with alarms, and
+// GPIO inputs that raise the registered edge interrupt like the real pins,
+// and hardware UARTs with an RX FIFO and interrupt.
+
+#define FAKE_MAX_ALARMS 16
+#define FAKE_UART_FIFO 32 // RX FIFO depth of the PL011
+#define FAKE_UART_TX_LEN 1024
+
+void fake_sdk_reset(void); // Time 0, no alarms, every input high (pulled up)
+void fake_advance_us(uint64_t us); // Let time pass, due alarms fire in order
+void fake_advance_ms(uint32_t ms);
+uint32_t fake_now_ms(void);
+void fake_gpio_drive(uint gpio, bool level); // External level on an input, edge interrupt if enabled
+bool fake_gpio_output(uint gpio); // Level last driven by gpio_put()
+bool fake_gpio_is_output(uint gpio);
+void fake_uart_receive(uart_inst_t *uart, const uint8_t *data, size_t len); // Into the RX FIFO (overrun when full), RX interrupt if enabled
+size_t fake_uart_sent(uart_inst_t *uart, char *out, size_t max); // Bytes transmitted since the last call
+size_t fake_uart_fifo_level(uart_inst_t *uart); // Received bytes not yet read
+bool fake_uart_rx_irq_enabled(uart_inst_t *uart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef FAKE_HARDWARE_CLOCKS_H
+#define FAKE_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+enum clock_index { clk_ref = 4, clk_sys = 5, clk_peri = 6 };
+
+uint32_t clock_get_hz(enum clock_index clk); // clk_sys follows pio_model_set_clk_sys()
+
+#endif
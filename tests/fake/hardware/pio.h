@@ -0,0 +1,38 @@
+#ifndef FAKE_HARDWARE_PIO_H
+#define FAKE_HARDWARE_PIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// PIO blocks of the behavioural model (pio_model.h). Only the FIFO registers
+// are memory: DMA reads and writes them like on the chip.
+
+typedef unsigned int uint;
+
+typedef struct {
+    volatile uint32_t txf[4];
+    volatile uint32_t rxf[4];
+} pio_hw_t;
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t fake_pio_hw[2];
+#define pio0 (&fake_pio_hw[0])
+#define pio1 (&fake_pio_hw[1])
+
+// Programs are assembled by the model from their .pio source, by name
+typedef struct {
+    const char *name;
+} pio_program_t;
+
+uint pio_get_index(PIO pio);
+bool pio_can_add_program(PIO pio, const pio_program_t *program);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, uint sm);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_set_clkdiv(PIO pio, uint sm, float div);
+bool pio_interrupt_get(PIO pio, uint irq);
+void pio_interrupt_clear(PIO pio, uint irq);
+
+#endif
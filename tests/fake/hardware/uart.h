@@ -0,0 +1,40 @@
+#ifndef FAKE_HARDWARE_UART_H
+#define FAKE_HARDWARE_UART_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+typedef struct uart_inst uart_inst_t;
+
+extern uart_inst_t *const fake_uart0;
+extern uart_inst_t *const fake_uart1;
+#define uart0 fake_uart0
+#define uart1 fake_uart1
+
+typedef enum { UART_PARITY_NONE, UART_PARITY_EVEN, UART_PARITY_ODD } uart_parity_t;
+
+typedef struct {
+    volatile uint32_t dr;
+    volatile uint32_t rsr;
+} uart_hw_t;
+
+#define UART_UARTDR_FE_BITS 0x100u
+#define UART_UARTDR_PE_BITS 0x200u
+#define UART_UARTDR_BE_BITS 0x400u
+#define UART_UARTRSR_OE_BITS 0x8u
+
+uint uart_init(uart_inst_t *uart, uint baud);
+uint uart_set_baudrate(uart_inst_t *uart, uint baud);
+void uart_set_format(uart_inst_t *uart, uint data_bits, uint stop_bits, uart_parity_t parity);
+void uart_set_fifo_enabled(uart_inst_t *uart, bool enabled);
+void uart_set_hw_flow(uart_inst_t *uart, bool cts, bool rts);
+void uart_set_irq_enables(uart_inst_t *uart, bool rx, bool tx);
+bool uart_is_readable(uart_inst_t *uart);
+bool uart_is_writable(uart_inst_t *uart);
+void uart_putc_raw(uart_inst_t *uart, char c);
+uint uart_get_index(uart_inst_t *uart);
+uart_hw_t *uart_get_hw(uart_inst_t *uart);
+
+#endif
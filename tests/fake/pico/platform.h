@@ -0,0 +1,6 @@
+#ifndef FAKE_PICO_PLATFORM_H
+#define FAKE_PICO_PLATFORM_H
+
+#include "pico/stdlib.h"
+
+#endif
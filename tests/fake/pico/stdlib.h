@@ -0,0 +1,45 @@
+#ifndef FAKE_PICO_STDLIB_H
+#define FAKE_PICO_STDLIB_H
+
+// Host stand-in for the parts of the Pico SDK the portable modules use. Time
+// is virtual (fake_sdk.h), GPIOs, alarms and the hardware UARTs are simulated.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+#define PICO_ERROR_TIMEOUT -1
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define __not_in_flash_func(name) name
+#define __not_in_flash(group)
+
+absolute_time_t get_absolute_time(void);
+uint32_t to_ms_since_boot(absolute_time_t t);
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void tight_loop_contents(void); // Lets one microsecond of virtual time pass
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t id);
+int getchar_timeout_us(uint32_t timeout_us);
+void panic(const char *fmt, ...);
+void stdio_init_all(void);
+
+#include "hardware/gpio.h"
+#include "hardware/uart.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef FAKE_PICO_SYNC_H
+#define FAKE_PICO_SYNC_H
+
+#include <pthread.h>
+
+// Interrupts are plain calls in most host tests; the event queue stress test
+// runs its "interrupt" on a second thread, so the lock is a real mutex
+typedef struct {
+    pthread_mutex_t mutex;
+} critical_section_t;
+
+static inline void critical_section_init(critical_section_t *cs) {
+    pthread_mutex_init(&cs->mutex, NULL);
+}
+
+static inline void critical_section_enter_blocking(critical_section_t *cs) {
+    pthread_mutex_lock(&cs->mutex);
+}
+
+static inline void critical_section_exit(critical_section_t *cs) {
+    pthread_mutex_unlock(&cs->mutex);
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef FAKE_PIO_UART_PIO_H
+#define FAKE_PIO_UART_PIO_H
+
+// Stand-in for the header pioasm generates from pio_uart.pio. The model
+// assembles the programs from the .pio source itself (pio_model.h), so the
+// host tests always run the instructions the firmware ships.
+
+#include "hardware/pio.h"
+
+extern const pio_program_t uart_tx_program;
+extern const pio_program_t uart_rx_program;
+
+void uart_tx_program_init(PIO pio, uint sm, uint offset, uint pin_tx, uint baud);
+void uart_rx_program_init(PIO pio, uint sm, uint offset, uint pin, uint baud);
+
+#endif
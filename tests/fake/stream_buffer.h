@@ -0,0 +1,21 @@
+#ifndef FAKE_STREAM_BUFFER_H
+#define FAKE_STREAM_BUFFER_H
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fake_stream_buffer *StreamBufferHandle_t;
+
+StreamBufferHandle_t xStreamBufferCreate(size_t size, size_t trigger_level);
+size_t xStreamBufferSendFromISR(StreamBufferHandle_t sb, const void *data, size_t len, BaseType_t *woken);
+size_t xStreamBufferReceive(StreamBufferHandle_t sb, void *data, size_t len, TickType_t ticks); // Does not block
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t sb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef FAKE_TASK_H
+#define FAKE_TASK_H
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fake_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *param);
+
+typedef enum { eNoAction, eSetBits, eIncrement, eSetValueWithOverwrite } eNotifyAction;
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_words, void *param,
+    UBaseType_t priority, TaskHandle_t *created);
+void vTaskCoreAffinitySet(TaskHandle_t task, UBaseType_t core_mask);
+void vTaskStartScheduler(void); // Returns on the host, the tasks run from fake_rtos_run_ms()
+void vTaskDelay(TickType_t ticks);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *woken);
+TaskHandle_t xTaskGetCurrentTaskHandle(void); // NULL outside the tasks
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+#include "file_storage.h"
+#include <string.h>
+
+static void storage_read(void *ctx, const uint32_t offset, uint8_t *dst, const size_t len) {
+    file_storage_t *fs = ctx;
+    fseek(fs->file, (long)offset, SEEK_SET);
+    if (fread(dst, 1, len, fs->file) != len)
+        memset(dst, 0xFF, len);
+}
+
+// NOR semantics: the new contents are the AND of the old and the written bytes
+static void write_anded(file_storage_t *fs, const uint32_t offset, const uint8_t *data, const size_t len) {
+    uint8_t old[FQ_PAGE_SIZE];
+    storage_read(fs, offset, old, len);
+    for (size_t i = 0; i < len; i++)
+        old[i] &= data[i];
+    fseek(fs->file, (long)offset, SEEK_SET);
+    fwrite(old, 1, len, fs->file);
+    fflush(fs->file);
+}
+
+static void storage_program(void *ctx, const uint32_t offset, const uint8_t *page) {
+    file_storage_t *fs = ctx;
+    if (!fs->powered)
+        return;
+    fs->programs++;
+    if (fs->programs_left == 0) {
+        // Power fails halfway through the page
+        write_anded(fs, offset, page, fs->torn_bytes);
+        fs->powered = false;
+        return;
+    }
+    if (fs->programs_left > 0)
+        fs->programs_left--;
+    write_anded(fs, offset, page, FQ_PAGE_SIZE);
+}
+
+static void storage_erase(void *ctx, const uint32_t offset) {
+    file_storage_t *fs = ctx;
+    if (!fs->powered)
+        return;
+    uint8_t blank[FQ_SECTOR_SIZE];
+    memset(blank, 0xFF, sizeof(blank));
+    fseek(fs->file, (long)offset, SEEK_SET);
+    fwrite(blank, 1, sizeof(blank), fs->file);
+    fflush(fs->file);
+    fs->erases[offset / FQ_SECTOR_SIZE]++;
+}
+
+bool file_storage_open(file_storage_t *fs, const char *path, const uint32_t sectors, const bool erase) {
+    if (sectors < 2 || sectors > FILE_STORAGE_MAX_SECTORS)
+        return false;
+    memset(fs, 0, sizeof(*fs));
+    fs->file = fopen(path, erase ? "w+b" : "r+b");
+    if (fs->file == NULL)
+        return false;
+    if (erase) {
+        uint8_t blank[FQ_SECTOR_SIZE];
+        memset(blank, 0xFF, sizeof(blank));
+        for (uint32_t s = 0; s < sectors; s++)
+            fwrite(blank, 1, sizeof(blank), fs->file);
+        fflush(fs->file);
+    }
+    fs->storage.read = storage_read;
+    fs->storage.program = storage_program;
+    fs->storage.erase = storage_erase;
+    fs->storage.ctx = fs;
+    fs->storage.sector_count = sectors;
+    fs->programs_left = -1;
+    fs->powered = true;
+    return true;
+}
+
+void file_storage_close(file_storage_t *fs) {
+    if (fs->file != NULL)
+        fclose(fs->file);
+    fs->file = NULL;
+}
+
+void file_storage_power_fail(file_storage_t *fs, const int32_t programs_left, const uint16_t torn_bytes) {
+    fs->programs_left = programs_left;
+    fs->torn_bytes = torn_bytes < FQ_PAGE_SIZE ? torn_bytes : FQ_PAGE_SIZE;
+}
+
+void file_storage_power_on(file_storage_t *fs) {
+    fs->programs_left = -1;
+    fs->powered = true;
+}
+
+uint32_t file_storage_max_erases(const file_storage_t *fs) {
+    uint32_t max = 0;
+    for (uint32_t s = 0; s < fs->storage.sector_count; s++) {
+        if (fs->erases[s] > max)
+            max = fs->erases[s];
+    }
+    return max;
+}
+
+uint32_t file_storage_min_erases(const file_storage_t *fs) {
+    uint32_t min = UINT32_MAX;
+    for (uint32_t s = 0; s < fs->storage.sector_count; s++) {
+        if (fs->erases[s] < min)
+            min = fs->erases[s];
+    }
+    return min;
+}
@@ -0,0 +1,33 @@
+#ifndef FILE_STORAGE_H
+#define FILE_STORAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "flash_queue.h"
+
+// File-backed flash_queue backend for the host tests. The file is the queue
+// region byte for byte and behaves like NOR flash: erase sets a sector to
+// 0xFF, programming can only clear bits. Erases are counted per sector for the
+// wear checks, and a power loss can be scheduled to tear a page program.
+
+#define FILE_STORAGE_MAX_SECTORS 64
+
+typedef struct {
+    fq_storage_t storage; // Handed to flash_queue_mount()
+    FILE *file;
+    uint32_t erases[FILE_STORAGE_MAX_SECTORS]; // Erase count of each sector since open
+    uint32_t programs; // Page programs since open
+    int32_t programs_left; // Programs until the power fails, -1 for never
+    uint16_t torn_bytes; // Bytes of the page that reach the flash when it does
+    bool powered; // False after the power failed, every access is ignored
+} file_storage_t;
+
+bool file_storage_open(file_storage_t *fs, const char *path, uint32_t sectors, bool erase); // Erase creates a blank region
+void file_storage_close(file_storage_t *fs);
+void file_storage_power_fail(file_storage_t *fs, int32_t programs_left, uint16_t torn_bytes); // Schedule a power loss
+void file_storage_power_on(file_storage_t *fs); // Back on after the power loss, the file keeps what was written
+uint32_t file_storage_max_erases(const file_storage_t *fs);
+uint32_t file_storage_min_erases(const file_storage_t *fs);
+
+#endif
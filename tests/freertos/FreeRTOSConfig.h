@@ -0,0 +1,71 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+// Kernel configuration for test_rtos on the real kernel's POSIX port
+// (FREERTOS_KERNEL_PATH set for the host tests). Follows the firmware's
+// FreeRTOSConfig.h where the port allows it.
+
+// Scheduler. Cooperative: a task runs until it blocks, like the stand-in
+// kernel, so no task is switched out while it holds one of the fake SDK's
+// pthread locks
+#define configUSE_PREEMPTION 0
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configUSE_TICKLESS_IDLE 0
+#define configCPU_CLOCK_HZ 133000000
+#define configTICK_RATE_HZ 1000 // The fake SDK clock follows the tick count (freertos/rtos_control.c)
+#define configMAX_PRIORITIES 8
+#define configMINIMAL_STACK_SIZE 4096 // Words, each task is a pthread
+#define configMAX_TASK_NAME_LEN 16
+#define configUSE_16_BIT_TICKS 0
+#define configIDLE_SHOULD_YIELD 1
+
+// The port runs one core: the firmware's affinity masks are recorded by
+// rtos_control.c for the test instead of being applied
+#define configNUMBER_OF_CORES 1
+struct tskTaskControlBlock;
+void vTaskCoreAffinitySet(struct tskTaskControlBlock *task, unsigned long core_mask);
+
+// Synchronisation
+#define configUSE_MUTEXES 1
+#define configUSE_RECURSIVE_MUTEXES 0
+#define configUSE_COUNTING_SEMAPHORES 0
+#define configUSE_TASK_NOTIFICATIONS 1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 1
+#define configQUEUE_REGISTRY_SIZE 0
+#define configUSE_QUEUE_SETS 0
+#define configUSE_TIME_SLICING 0
+#define configUSE_NEWLIB_REENTRANT 0
+#define configENABLE_BACKWARD_COMPATIBILITY 0
+#define configSTREAM_BUFFER_TRIGGER_LEVEL_TEST_MARGIN 1
+
+// Memory (heap_3, the C library's malloc)
+#define configSUPPORT_STATIC_ALLOCATION 0
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configAPPLICATION_ALLOCATED_HEAP 0
+
+// Hooks. Stack overflow checking does not apply, the stacks are the pthreads'
+#define configCHECK_FOR_STACK_OVERFLOW 0
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configUSE_IDLE_HOOK 0
+#define configUSE_TICK_HOOK 0
+
+// Software timers are not used, the SDK alarms drive the button debounce
+#define configUSE_TIMERS 0
+
+#include <assert.h>
+#define configASSERT(x) assert(x)
+
+// Wakeups per task for fake_rtos_wakeups()
+void fake_rtos_switched_in(void);
+#define traceTASK_SWITCHED_IN() fake_rtos_switched_in()
+
+// Optional API functions
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_vTaskDelete 0
+#define INCLUDE_vTaskSuspend 1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_xTaskGetSchedulerState 1
+#define INCLUDE_xTaskGetHandle 1
+#define INCLUDE_uxTaskPriorityGet 1
+
+#endif
@@ -0,0 +1,85 @@
+#include "FreeRTOS.h"
+#include "task.h"
+#include "fake_freertos.h"
+#include "fake_sdk.h"
+
+// The test-side controls of fake_freertos.h on the real kernel's POSIX port.
+// The tests run in a task of their own above the firmware's tasks; letting
+// time pass is a delay of that task, and the fake SDK clock (alarms, GPIO
+// edges, the UART) is brought up to the kernel's tick count afterwards.
+
+#define MAX_TASKS 8
+#define TEST_TASK_STACK 8192 // Words
+#define TEST_TASK_PRIORITY (configMAX_PRIORITIES - 1)
+
+struct task_info {
+    TaskHandle_t task;
+    uint32_t wakeups;
+    UBaseType_t affinity;
+};
+
+static struct task_info tasks[MAX_TASKS];
+static TickType_t synced; // Tick count the fake SDK clock was last brought up to
+
+// Entry of the task, added the first time it is seen
+static struct task_info *task_info(TaskHandle_t task) {
+    for (int i = 0; i < MAX_TASKS; i++) {
+        if (tasks[i].task == task || tasks[i].task == NULL) {
+            tasks[i].task = task;
+            return &tasks[i];
+        }
+    }
+    return NULL;
+}
+
+static void test_task(void *param) {
+    void (*tests)(void) = (void (*)(void))param;
+    synced = xTaskGetTickCount();
+    tests();
+    vTaskEndScheduler();
+}
+
+void fake_rtos_start(int (*firmware_main)(void), void (*tests)(void)) {
+    xTaskCreate(test_task, "test", TEST_TASK_STACK, (void *)tests, TEST_TASK_PRIORITY, NULL);
+    firmware_main(); // Returns once the test task ended the scheduler
+}
+
+void fake_rtos_run_ms(const uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        vTaskDelay(1);
+        const TickType_t now = xTaskGetTickCount();
+        fake_advance_ms(now - synced);
+        synced = now;
+    }
+}
+
+TaskHandle_t fake_rtos_task(const char *name) {
+    return xTaskGetHandle(name);
+}
+
+uint32_t fake_rtos_wakeups(TaskHandle_t task) {
+    const struct task_info *info = task_info(task);
+    return info != NULL ? info->wakeups : 0;
+}
+
+UBaseType_t fake_rtos_affinity(TaskHandle_t task) {
+    const struct task_info *info = task_info(task);
+    return info != NULL ? info->affinity : 0;
+}
+
+UBaseType_t fake_rtos_priority(TaskHandle_t task) {
+    return uxTaskPriorityGet(task);
+}
+
+// traceTASK_SWITCHED_IN, called by the kernel with the new task current
+void fake_rtos_switched_in(void) {
+    struct task_info *info = task_info(xTaskGetCurrentTaskHandle());
+    if (info != NULL)
+        info->wakeups++;
+}
+
+void vTaskCoreAffinitySet(TaskHandle_t task, const UBaseType_t core_mask) {
+    struct task_info *info = task_info(task);
+    if (info != NULL)
+        info->affinity = core_mask;
+}
@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "module_info.h"
+
+// Fuzz target: the DevEui and version parsers of module_info.c on any line,
+// as it comes out of the line assembler (null-terminated, at most LINE_LEN - 1
+// characters). A DevEui that parses must survive formatting and parsing again.
+
+#define LINE_MAX_CHARS 127 // LINE_LEN - 1
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size > LINE_MAX_CHARS)
+        size = LINE_MAX_CHARS;
+    char *line = malloc(size + 1); // Exactly sized, so the sanitizer sees any read past the end
+    memcpy(line, data, size);
+    line[size] = '\0';
+
+    uint64_t dev_eui = 0;
+    if (module_parse_dev_eui(line, &dev_eui)) {
+        char text[MODULE_DEV_EUI_TEXT_LEN];
+        module_format_dev_eui(text, dev_eui);
+        if (strlen(text) != MODULE_DEV_EUI_DIGITS)
+            abort();
+        char again[64];
+        snprintf(again, sizeof(again), "+ID: DevEui, %s", text);
+        uint64_t parsed = 0;
+        if (!module_parse_dev_eui(again, &parsed) || parsed != dev_eui)
+            abort();
+    }
+    uint32_t version = 0;
+    if (module_parse_version(line, &version) && MODULE_VERSION_MAJOR(version) > 255)
+        abort();
+    free(line);
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <stdlib.h>
+#include <string.h>
+#include "downlink.h"
+
+// Fuzz target: module output through the downlink report parser of
+// downlink.c, one byte at a time as it comes off the UART. The first input
+// byte picks the payload buffer size (0-63), which is allocated exactly so
+// the sanitizer sees any write past it. After every byte the length must fit
+// the buffer and the flags must agree with each other and with the event; a
+// Done line starts the next transaction, as the next uplink would.
+
+#define SIZE_MASK 0x3f
+#define KNOWN_FLAGS (DOWNLINK_HAS_PAYLOAD | DOWNLINK_HAS_RSSI | DOWNLINK_HAS_SNR | DOWNLINK_FAILED | \
+    DOWNLINK_OVERFLOW | DOWNLINK_BAD_HEX)
+// Only a new RX field clears anything, and only what belongs to the payload
+#define STICKY_FLAGS (DOWNLINK_HAS_RSSI | DOWNLINK_HAS_SNR | DOWNLINK_FAILED)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size == 0)
+        return 0;
+    const size_t capacity = data[0] & SIZE_MASK;
+    uint8_t *payload = malloc(capacity ? capacity : 1);
+    downlink_t dl;
+    downlink_begin(&dl, payload, capacity);
+
+    for (size_t i = 1; i < size; i++) {
+        const uint8_t before = dl.flags;
+        const downlink_event_t event = downlink_feed(&dl, (char)data[i]);
+        if (dl.len > capacity || dl.payload != payload || dl.capacity != capacity)
+            abort();
+        if (dl.flags & ~KNOWN_FLAGS)
+            abort();
+        if ((before & STICKY_FLAGS) & ~dl.flags)
+            abort();
+        // Bytes are only dropped once the buffer is full
+        if ((dl.flags & DOWNLINK_OVERFLOW) && dl.len != capacity)
+            abort();
+        if (event == DOWNLINK_PAYLOAD && !(dl.flags & DOWNLINK_HAS_PAYLOAD))
+            abort();
+        // Events only come with the end of a line
+        if (event != DOWNLINK_NONE && data[i] != '\n')
+            abort();
+        if (event == DOWNLINK_DONE)
+            downlink_begin(&dl, payload, capacity);
+    }
+    free(payload);
+    return 0;
+}
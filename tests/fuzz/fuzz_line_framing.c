@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <string.h>
+#include "modem.h"
+
+// Fuzz target: arbitrary module output through the line assembler of modem.c,
+// handed over in ring-sized chunks as the UART interrupt does. Every line must
+// be terminated inside line[] and match a reference framing of the input: the
+// bytes up to '\n', without '\r', cut to LINE_LEN - 1. Lines with control or
+// non-ASCII bytes must be counted as garbled.
+
+static const uint8_t *input;
+static size_t input_len;
+
+static void fuzz_write(void *hw, const char *data, size_t len) {
+    (void)hw;
+    (void)data;
+    (void)len;
+}
+
+static void fuzz_poll(void *hw, ring_t *rx, uint32_t *framing_errors) {
+    (void)hw;
+    (void)framing_errors;
+    while (input_len > 0 && ring_count(rx) < RING_SIZE - 1) {
+        ring_put(rx, *input++);
+        input_len--;
+    }
+}
+
+static const modem_port_t fuzz_port = { .write = fuzz_write, .poll = fuzz_poll };
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static modem_t m;
+    modem_init(&m, "fuzz", &fuzz_port, NULL);
+    input = data;
+    input_len = size;
+
+    size_t start = 0; // Reference: where the current line began in data
+    for (;;) {
+        // A full ring without a line ending needs another poll to take in the rest
+        if (!modem_poll_line(&m)) {
+            if (input_len == 0)
+                break;
+            continue;
+        }
+        const uint8_t *end = memchr(data + start, '\n', size - start);
+        if (end == NULL || strnlen(m.line, LINE_LEN) == LINE_LEN)
+            abort();
+        char expected[LINE_LEN];
+        size_t len = 0;
+        bool bad = false;
+        for (const uint8_t *p = data + start; p < end; p++) {
+            if (*p == '\r')
+                continue;
+            if (len == LINE_LEN - 1 || *p < ' ' || *p > '~')
+                bad = true;
+            if (len < LINE_LEN - 1)
+                expected[len++] = (char)*p;
+        }
+        expected[len] = '\0';
+        if (memcmp(m.line, expected, len + 1) != 0)
+            abort();
+        const uint32_t garbled = m.garbled_lines;
+        start = (size_t)(end - data) + 1;
+        if (bad != (garbled > 0))
+            abort();
+        m.garbled_lines = 0;
+    }
+    // Only an unterminated tail may be left
+    if (memchr(data + start, '\n', size - start) != NULL)
+        abort();
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Driver for the fuzz targets where libFuzzer is not available (gcc): runs
+// every file of the corpus directories on the command line, then
+// FUZZ_MUTATIONS mutations of them from a fixed seed, so a failure can be
+// reproduced. Built with ASan and UBSan, a bad access aborts the run.
+
+#define FUZZ_MAX_INPUTS 256
+#define FUZZ_MAX_LEN 1024
+#define FUZZ_MUTATIONS 50000
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static uint8_t *inputs[FUZZ_MAX_INPUTS];
+static size_t input_lens[FUZZ_MAX_INPUTS];
+static int input_count;
+static uint32_t seed = 1;
+
+static uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+// Copy into a buffer of exactly size bytes, so reading past the input is caught
+static void run(const uint8_t *data, const size_t size) {
+    uint8_t *copy = malloc(size ? size : 1);
+    memcpy(copy, data, size);
+    LLVMFuzzerTestOneInput(copy, size);
+    free(copy);
+}
+
+static void load(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL || input_count == FUZZ_MAX_INPUTS)
+        return;
+    uint8_t *data = malloc(FUZZ_MAX_LEN);
+    inputs[input_count] = data;
+    input_lens[input_count++] = fread(data, 1, FUZZ_MAX_LEN, f);
+    fclose(f);
+}
+
+// Bytes the parsers care about, mutations prefer them
+static const uint8_t interesting[] = { '\n', '\r', ',', ':', ' ', '.', '\0', 0x7f, 0xff, '0', '9', 'a', 'F', 'G' };
+
+static size_t mutate(uint8_t *buf, size_t len) {
+    const int steps = 1 + (int)(next_random() % 4);
+    for (int i = 0; i < steps; i++) {
+        const size_t at = len ? next_random() % len : 0;
+        switch (next_random() % 6) {
+            case 0: // Flip a bit
+                if (len)
+                    buf[at] ^= (uint8_t)(1u << (next_random() % 8));
+                break;
+            case 1: // Interesting byte
+                if (len)
+                    buf[at] = interesting[next_random() % sizeof(interesting)];
+                break;
+            case 2: // Insert
+                if (len < FUZZ_MAX_LEN) {
+                    memmove(buf + at + 1, buf + at, len - at);
+                    buf[at] = interesting[next_random() % sizeof(interesting)];
+                    len++;
+                }
+                break;
+            case 3: // Delete a run
+                if (len) {
+                    const size_t n = 1 + next_random() % (len - at);
+                    memmove(buf + at, buf + at + n, len - at - n);
+                    len -= n;
+                }
+                break;
+            case 4: { // Repeat a run, e.g. a long line
+                const size_t n = len ? 1 + next_random() % (len - at) : 0;
+                const size_t times = 1 + next_random() % 16;
+                for (size_t t = 0; t < times && len + n <= FUZZ_MAX_LEN; t++) {
+                    memmove(buf + at + n, buf + at, len - at);
+                    len += n;
+                }
+                break;
+            }
+            default: { // Splice in part of another input
+                const int other = (int)(next_random() % (uint32_t)input_count);
+                const size_t from = input_lens[other] ? next_random() % input_lens[other] : 0;
+                size_t n = input_lens[other] - from;
+                if (at + n > FUZZ_MAX_LEN)
+                    n = FUZZ_MAX_LEN - at;
+                memcpy(buf + at, inputs[other] + from, n);
+                if (at + n > len)
+                    len = at + n;
+                break;
+            }
+        }
+    }
+    return len;
+}
+
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        DIR *dir = opendir(argv[i]);
+        if (dir == NULL) {
+            load(argv[i]);
+            continue;
+        }
+        struct dirent *e;
+        char path[1024];
+        while ((e = readdir(dir)) != NULL) {
+            if (e->d_name[0] == '.')
+                continue;
+            snprintf(path, sizeof(path), "%s/%s", argv[i], e->d_name);
+            load(path);
+        }
+        closedir(dir);
+    }
+    if (input_count == 0) {
+        printf("usage: %s <corpus dir or file>...\n", argv[0]);
+        return 2;
+    }
+    for (int i = 0; i < input_count; i++)
+        run(inputs[i], input_lens[i]);
+
+    static uint8_t buf[FUZZ_MAX_LEN];
+    for (int i = 0; i < FUZZ_MUTATIONS; i++) {
+        const int from = (int)(next_random() % (uint32_t)input_count);
+        memcpy(buf, inputs[from], input_lens[from]);
+        run(buf, mutate(buf, input_lens[from]));
+    }
+    printf("%d corpus inputs, %d mutations\n", input_count, FUZZ_MUTATIONS);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdlib.h>
+#include <string.h>
+#include "modem.h"
+
+// Fuzz target: the identity probe of modem.c with the prefix matchers and
+// parsers behind it, against arbitrary answers. Every command the engine sends
+// releases the next line of the input, the way a module answers. The probe has
+// to end, in PROBE_DONE only with a DevEui that the answer actually carried.
+
+static const uint8_t *input;
+static size_t input_len;
+static size_t released; // Input bytes the "module" has sent so far
+static uint32_t commands;
+
+static void fuzz_write(void *hw, const char *data, size_t len) {
+    (void)hw;
+    (void)data;
+    (void)len;
+    commands++;
+    const uint8_t *end = memchr(input + released, '\n', input_len - released);
+    released = end != NULL ? (size_t)(end - input) + 1 : input_len;
+}
+
+static size_t delivered;
+
+static void fuzz_poll(void *hw, ring_t *rx, uint32_t *framing_errors) {
+    (void)hw;
+    (void)framing_errors;
+    while (delivered < released && ring_count(rx) < RING_SIZE - 1)
+        ring_put(rx, input[delivered++]);
+}
+
+static const modem_port_t fuzz_port = { .write = fuzz_write, .poll = fuzz_poll };
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static modem_t m;
+    modem_init(&m, "fuzz", &fuzz_port, NULL);
+    input = data;
+    input_len = size;
+    released = 0;
+    delivered = 0;
+    commands = 0;
+
+    uint32_t now = 0;
+    modem_probe_start(&m, now);
+    // Each step times out after PROBE_TIMEOUT_MS, so the probe cannot outlast all of them
+    const uint32_t limit = (PROBE_AT_ATTEMPTS + PROBE_STEPS) * PROBE_TIMEOUT_MS;
+    probe_state_t state;
+    while ((state = modem_probe_poll(&m, now)) != PROBE_DONE && state != PROBE_FAILED) {
+        if (now > limit)
+            abort();
+        now += 10;
+    }
+    if (commands > PROBE_AT_ATTEMPTS + PROBE_STEPS - 1)
+        abort();
+    // line[] still holds the answer that completed the probe
+    uint64_t dev_eui = 0;
+    if (state == PROBE_DONE && (commands != m.attempts + PROBE_STEPS - 1u || strstr(m.line, "DevEui") == NULL ||
+            !module_parse_dev_eui(m.line, &dev_eui) || dev_eui != m.info.dev_eui))
+        abort();
+    return 0;
+}
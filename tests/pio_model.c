@@ -0,0 +1,641 @@
+#include "pio_model.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "pio_uart.pio.h"
+
+// Only the instructions and operands pio_uart.pio uses are assembled, anything
+// else stops the test with a message instead of being modelled wrongly. Both
+// programs shift right and use one pin for IN, JMP, OUT and side-set, so the
+// model keeps a single pin per state machine.
+
+#define INSTR_MAX 32 // Instruction memory of one PIO block
+#define LABEL_MAX 16
+#define PROGRAM_MAX 4
+#define SM_COUNT 4
+#define FIFO_DEPTH 8 // Joined FIFO
+
+typedef enum { OP_JMP, OP_WAIT, OP_IN, OP_OUT, OP_PUSH, OP_PULL, OP_SET, OP_IRQ } op_t;
+typedef enum { COND_ALWAYS, COND_NOT_X, COND_X_DEC, COND_PIN } cond_t;
+
+typedef struct {
+    op_t op;
+    cond_t cond; // JMP
+    int arg; // Bit count, SET value, IRQ number or WAIT polarity
+    int target; // JMP destination
+    int delay;
+    int side; // -1 when the instruction has no side-set
+    bool rel; // IRQ n rel
+} instr_t;
+
+typedef struct {
+    char name[32];
+    instr_t code[INSTR_MAX];
+    int len;
+    int wrap_target;
+    int wrap; // Last instruction before wrapping, -1 for the end of the program
+    int side_bits;
+    bool side_opt;
+} program_t;
+
+typedef struct {
+    bool claimed;
+    bool enabled;
+    const program_t *program;
+    uint32_t pin;
+    uint32_t div256; // Clock divider in 1/256, like the 16.8 hardware register
+    double next; // Time of the next cycle
+    int pc;
+    int delay;
+    uint32_t x, isr, osr;
+    uint32_t tx_fifo[FIFO_DEPTH], rx_fifo[FIFO_DEPTH];
+    int tx_len, rx_len;
+    int tx_depth, rx_depth;
+} sm_t;
+
+typedef struct {
+    sm_t sm[SM_COUNT];
+    uint8_t irq;
+    int used; // Instruction memory taken by loaded programs
+} block_t;
+
+typedef struct {
+    bool claimed;
+    bool busy;
+    dma_channel_config config;
+    volatile uint8_t *read;
+    volatile uint8_t *write;
+    uint32_t count;
+    dma_channel_hw_t hw;
+} dma_t;
+
+pio_hw_t fake_pio_hw[2];
+const pio_program_t uart_tx_program = { "uart_tx" };
+const pio_program_t uart_rx_program = { "uart_rx" };
+
+static program_t programs[PROGRAM_MAX];
+static int program_count = -1; // Not assembled yet
+static block_t blocks[2];
+static dma_t dmas[NUM_DMA_CHANNELS];
+static bool pins[PIO_MODEL_PINS];
+static uint32_t clk_sys_hz;
+static double now;
+
+static void model_error(const char *what, const char *detail) {
+    printf("pio_model: %s: %s\n", what, detail);
+    exit(2);
+}
+
+// ---- Assembler for the subset of pioasm syntax pio_uart.pio uses ----
+
+typedef struct {
+    char name[32];
+    int pc;
+} label_t;
+
+static int split(char *line, char *tokens[], const int max) {
+    int n = 0;
+    for (char *p = line; *p != '\0';) {
+        while (*p != '\0' && (isspace((unsigned char)*p) || *p == ','))
+            *p++ = '\0';
+        if (*p == '\0')
+            break;
+        if (n == max)
+            model_error("too many operands", line);
+        tokens[n++] = p;
+        while (*p != '\0' && !isspace((unsigned char)*p) && *p != ',')
+            p++;
+    }
+    return n;
+}
+
+static int number(const char *token) {
+    char *end;
+    const long v = strtol(token, &end, 0);
+    if (*end != '\0')
+        model_error("not a number", token);
+    return (int)v;
+}
+
+// One instruction line; JMP targets are label names resolved once the program ends
+static void assemble(program_t *prog, char *line, char targets[][32]) {
+    char *tokens[8], *ops[8];
+    const int n = split(line, tokens, 8);
+    if (prog->len == INSTR_MAX)
+        model_error("program too long", prog->name);
+    instr_t *in = &prog->code[prog->len];
+    *in = (instr_t){ .side = -1 };
+    int nops = 0;
+    for (int i = 0; i < n; i++) {
+        if (tokens[i][0] == '[')
+            in->delay = number(strtok(tokens[i] + 1, "]"));
+        else if (strcmp(tokens[i], "side") == 0 && i + 1 < n)
+            in->side = number(tokens[++i]);
+        else
+            ops[nops++] = tokens[i];
+    }
+    const int delay_bits = 5 - prog->side_bits - (prog->side_opt ? 1 : 0);
+    if (in->delay >= 1 << delay_bits || (prog->side_bits > 0 && !prog->side_opt && in->side < 0))
+        model_error("bad delay or side-set", ops[0]);
+    targets[prog->len][0] = '\0';
+
+    const char *op = ops[0];
+    if (strcmp(op, "jmp") == 0 && (nops == 2 || nops == 3)) {
+        in->op = OP_JMP;
+        const char *cond = nops == 3 ? ops[1] : "";
+        if (nops == 2)
+            in->cond = COND_ALWAYS;
+        else if (strcmp(cond, "!x") == 0)
+            in->cond = COND_NOT_X;
+        else if (strcmp(cond, "x--") == 0)
+            in->cond = COND_X_DEC;
+        else if (strcmp(cond, "pin") == 0)
+            in->cond = COND_PIN;
+        else
+            model_error("unsupported jmp condition", cond);
+        snprintf(targets[prog->len], 32, "%.31s", ops[nops - 1]);
+    } else if (strcmp(op, "wait") == 0 && nops == 4 && strcmp(ops[2], "pin") == 0 && number(ops[3]) == 0) {
+        in->op = OP_WAIT;
+        in->arg = number(ops[1]);
+    } else if ((strcmp(op, "in") == 0 || strcmp(op, "out") == 0) && nops == 3 && strcmp(ops[1], "pins") == 0) {
+        in->op = op[0] == 'i' ? OP_IN : OP_OUT;
+        in->arg = number(ops[2]);
+        if (in->arg != 1)
+            model_error("only one pin per channel", line);
+    } else if ((strcmp(op, "push") == 0 || strcmp(op, "pull") == 0) &&
+        (nops == 1 || (nops == 2 && strcmp(ops[1], "block") == 0))) {
+        in->op = op[1] == 'u' && op[2] == 's' ? OP_PUSH : OP_PULL;
+    } else if (strcmp(op, "set") == 0 && nops == 3 && strcmp(ops[1], "x") == 0) {
+        in->op = OP_SET;
+        in->arg = number(ops[2]);
+    } else if (strcmp(op, "irq") == 0 && (nops == 2 || (nops == 3 && strcmp(ops[2], "rel") == 0))) {
+        in->op = OP_IRQ;
+        in->arg = number(ops[1]);
+        in->rel = nops == 3;
+    } else {
+        model_error("unsupported instruction", op);
+    }
+    prog->len++;
+}
+
+static void finish_program(program_t *prog, const label_t *labels, const int nlabels, char targets[][32]) {
+    for (int pc = 0; pc < prog->len; pc++) {
+        if (prog->code[pc].op != OP_JMP)
+            continue;
+        int i = 0;
+        while (i < nlabels && strcmp(labels[i].name, targets[pc]) != 0)
+            i++;
+        if (i == nlabels)
+            model_error("unknown label", targets[pc]);
+        prog->code[pc].target = labels[i].pc;
+    }
+    if (prog->wrap < 0)
+        prog->wrap = prog->len - 1;
+}
+
+static void assemble_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+        model_error("cannot open", path);
+    program_count = 0;
+    program_t *prog = NULL;
+    label_t labels[LABEL_MAX];
+    int nlabels = 0;
+    char targets[INSTR_MAX][32];
+    bool in_c_block = false;
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char *p = line;
+        // Comments and the "% c-sdk { ... %}" blocks are not part of the program
+        p[strcspn(p, ";\r\n")] = '\0';
+        if (in_c_block) {
+            in_c_block = strncmp(p, "%}", 2) != 0;
+            continue;
+        }
+        if (p[0] == '%') {
+            in_c_block = true;
+            continue;
+        }
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '\0')
+            continue;
+        if (strncmp(p, ".program", 8) == 0) {
+            if (prog != NULL)
+                finish_program(prog, labels, nlabels, targets);
+            if (program_count == PROGRAM_MAX)
+                model_error("too many programs", path);
+            prog = &programs[program_count++];
+            *prog = (program_t){ .wrap = -1 };
+            sscanf(p + 8, "%31s", prog->name);
+            nlabels = 0;
+            continue;
+        }
+        if (prog == NULL)
+            model_error("instruction outside a program", p);
+        if (strncmp(p, ".side_set", 9) == 0) {
+            char opt[8] = "";
+            sscanf(p + 9, "%d %7s", &prog->side_bits, opt);
+            prog->side_opt = strcmp(opt, "opt") == 0;
+            continue;
+        }
+        if (strcmp(p, ".wrap_target") == 0) {
+            prog->wrap_target = prog->len;
+            continue;
+        }
+        if (strcmp(p, ".wrap") == 0) {
+            prog->wrap = prog->len - 1;
+            continue;
+        }
+        if (p[0] == '.')
+            model_error("unsupported directive", p);
+        char *colon = strchr(p, ':');
+        if (colon != NULL) {
+            *colon = '\0';
+            if (nlabels == LABEL_MAX)
+                model_error("too many labels", p);
+            snprintf(labels[nlabels].name, sizeof(labels[nlabels].name), "%.31s", p);
+            labels[nlabels++].pc = prog->len;
+            p = colon + 1;
+            while (isspace((unsigned char)*p))
+                p++;
+            if (*p == '\0')
+                continue;
+        }
+        assemble(prog, p, targets);
+    }
+    if (prog != NULL)
+        finish_program(prog, labels, nlabels, targets);
+    fclose(f);
+}
+
+static const program_t *find_program(const pio_program_t *program) {
+    if (program_count < 0)
+        assemble_file(PIO_UART_SOURCE);
+    for (int i = 0; i < program_count; i++) {
+        if (strcmp(programs[i].name, program->name) == 0)
+            return &programs[i];
+    }
+    model_error("program not in " PIO_UART_SOURCE, program->name);
+    return NULL;
+}
+
+// ---- State machines ----
+
+static block_t *block_of(const PIO pio) {
+    return &blocks[pio_get_index(pio)];
+}
+
+static double period(const sm_t *sm) {
+    return sm->div256 / 256.0 / clk_sys_hz;
+}
+
+// One PIO clock cycle of a state machine
+static void step(sm_t *sm, const int index, block_t *block) {
+    if (sm->delay > 0) {
+        sm->delay--;
+        return;
+    }
+    const program_t *prog = sm->program;
+    const instr_t *in = &prog->code[sm->pc];
+    // Side-set takes effect when the instruction starts, even if it then stalls
+    if (in->side >= 0)
+        pins[sm->pin] = in->side != 0;
+    int next = sm->pc == prog->wrap ? prog->wrap_target : sm->pc + 1;
+    switch (in->op) {
+    case OP_JMP: {
+        bool take = true;
+        if (in->cond == COND_NOT_X)
+            take = sm->x == 0;
+        else if (in->cond == COND_X_DEC)
+            take = sm->x-- != 0;
+        else if (in->cond == COND_PIN)
+            take = pins[sm->pin];
+        if (take)
+            next = in->target;
+        break;
+    }
+    case OP_WAIT:
+        if (pins[sm->pin] != (in->arg != 0))
+            return; // Stall, the delay only starts once the wait is over
+        break;
+    case OP_IN:
+        sm->isr = (sm->isr >> 1) | (uint32_t)pins[sm->pin] << 31;
+        break;
+    case OP_OUT:
+        pins[sm->pin] = sm->osr & 1;
+        sm->osr >>= 1;
+        break;
+    case OP_PUSH:
+        if (sm->rx_len == sm->rx_depth)
+            return;
+        sm->rx_fifo[sm->rx_len++] = sm->isr;
+        sm->isr = 0;
+        break;
+    case OP_PULL:
+        if (sm->tx_len == 0)
+            return;
+        sm->osr = sm->tx_fifo[0];
+        memmove(sm->tx_fifo, &sm->tx_fifo[1], (size_t)--sm->tx_len * sizeof(sm->tx_fifo[0]));
+        break;
+    case OP_SET:
+        sm->x = (uint32_t)in->arg;
+        break;
+    case OP_IRQ:
+        block->irq |= 1u << (in->rel ? (in->arg & 4) | ((in->arg + index) & 3) : in->arg);
+        break;
+    }
+    sm->pc = next;
+    sm->delay = in->delay;
+}
+
+// ---- DMA ----
+
+static bool dreq_ready(const uint dreq) {
+    if (dreq == DREQ_FORCE)
+        return true;
+    const sm_t *sm = &blocks[dreq / 8].sm[dreq % 4];
+    return dreq % 8 < 4 ? sm->tx_len < sm->tx_depth : sm->rx_len > 0;
+}
+
+// A byte read from an RX FIFO register pops the FIFO
+static uint8_t dma_read_byte(const volatile uint8_t *p) {
+    for (int b = 0; b < 2; b++) {
+        for (int s = 0; s < SM_COUNT; s++) {
+            const volatile uint8_t *reg = (const volatile uint8_t *)&fake_pio_hw[b].rxf[s];
+            sm_t *sm = &blocks[b].sm[s];
+            if (p >= reg && p < reg + 4 && sm->rx_len > 0) {
+                fake_pio_hw[b].rxf[s] = sm->rx_fifo[0];
+                memmove(sm->rx_fifo, &sm->rx_fifo[1], (size_t)--sm->rx_len * sizeof(sm->rx_fifo[0]));
+            }
+        }
+    }
+    return *p;
+}
+
+// A byte written to a TX FIFO register pushes it, replicated across the word as on the bus
+static void dma_write_byte(volatile uint8_t *p, const uint8_t v) {
+    for (int b = 0; b < 2; b++) {
+        for (int s = 0; s < SM_COUNT; s++) {
+            volatile uint8_t *reg = (volatile uint8_t *)&fake_pio_hw[b].txf[s];
+            sm_t *sm = &blocks[b].sm[s];
+            if (p >= reg && p < reg + 4) {
+                if (sm->tx_len < sm->tx_depth)
+                    sm->tx_fifo[sm->tx_len++] = v * 0x01010101u;
+                return;
+            }
+        }
+    }
+    *p = v;
+}
+
+static void service_dma(void) {
+    for (int i = 0; i < NUM_DMA_CHANNELS; i++) {
+        dma_t *d = &dmas[i];
+        while (d->busy && dreq_ready(d->config.dreq)) {
+            dma_write_byte(d->write, dma_read_byte(d->read));
+            if (d->config.read_increment)
+                d->read++;
+            if (d->config.write_increment) {
+                uintptr_t a = (uintptr_t)d->write;
+                const uintptr_t mask = d->config.ring_sel && d->config.ring_bits ? (1u << d->config.ring_bits) - 1 : UINTPTR_MAX;
+                a = (a & ~mask) | ((a + 1) & mask);
+                d->write = (volatile uint8_t *)a;
+            }
+            d->hw.read_addr = (uint32_t)(uintptr_t)d->read;
+            d->hw.write_addr = (uint32_t)(uintptr_t)d->write;
+            d->hw.transfer_count = --d->count;
+            d->busy = d->count > 0;
+        }
+    }
+}
+
+// ---- Test controls ----
+
+void pio_model_reset(const uint32_t clk_hz) {
+    memset(blocks, 0, sizeof(blocks));
+    memset(dmas, 0, sizeof(dmas));
+    memset(fake_pio_hw, 0, sizeof(fake_pio_hw));
+    for (int i = 0; i < PIO_MODEL_PINS; i++)
+        pins[i] = true;
+    clk_sys_hz = clk_hz;
+    now = 0;
+}
+
+void pio_model_set_clk_sys(const uint32_t hz) {
+    clk_sys_hz = hz;
+}
+
+void pio_model_run(const double seconds) {
+    const double end = now + seconds;
+    for (;;) {
+        sm_t *first = NULL;
+        int first_index = 0;
+        block_t *first_block = NULL;
+        for (int b = 0; b < 2; b++) {
+            for (int s = 0; s < SM_COUNT; s++) {
+                sm_t *sm = &blocks[b].sm[s];
+                if (sm->enabled && sm->next <= end && (first == NULL || sm->next < first->next)) {
+                    first = sm;
+                    first_index = s;
+                    first_block = &blocks[b];
+                }
+            }
+        }
+        if (first == NULL)
+            break;
+        now = first->next;
+        step(first, first_index, first_block);
+        first->next += period(first);
+        service_dma();
+    }
+    now = end;
+}
+
+double pio_model_now(void) {
+    return now;
+}
+
+void pio_model_drive(const uint32_t pin, const bool level) {
+    pins[pin] = level;
+}
+
+bool pio_model_pin(const uint32_t pin) {
+    return pins[pin];
+}
+
+// ---- SDK functions used by pio_uart.c ----
+
+uint32_t clock_get_hz(const enum clock_index clk) {
+    (void)clk;
+    return clk_sys_hz;
+}
+
+uint pio_get_index(const PIO pio) {
+    return pio == pio1 ? 1 : 0;
+}
+
+bool pio_can_add_program(const PIO pio, const pio_program_t *program) {
+    return block_of(pio)->used + find_program(program)->len <= INSTR_MAX;
+}
+
+uint pio_add_program(const PIO pio, const pio_program_t *program) {
+    block_t *block = block_of(pio);
+    const uint offset = (uint)block->used;
+    block->used += find_program(program)->len;
+    return offset;
+}
+
+int pio_claim_unused_sm(const PIO pio, const bool required) {
+    block_t *block = block_of(pio);
+    for (int s = 0; s < SM_COUNT; s++) {
+        if (!block->sm[s].claimed) {
+            block->sm[s].claimed = true;
+            return s;
+        }
+    }
+    if (required)
+        model_error("pio_claim_unused_sm", "no free state machine");
+    return -1;
+}
+
+void pio_sm_unclaim(const PIO pio, const uint sm) {
+    block_of(pio)->sm[sm].claimed = false;
+}
+
+uint pio_get_dreq(const PIO pio, const uint sm, const bool is_tx) {
+    return pio_get_index(pio) * 8 + (is_tx ? 0 : 4) + sm;
+}
+
+void pio_sm_set_enabled(const PIO pio, const uint sm, const bool enabled) {
+    sm_t *s = &block_of(pio)->sm[sm];
+    if (enabled && !s->enabled)
+        s->next = now + period(s);
+    s->enabled = enabled;
+}
+
+// 16 integer and 8 fractional bits, as the SDK converts the float
+void pio_sm_set_clkdiv(const PIO pio, const uint sm, const float div) {
+    const uint32_t whole = (uint32_t)div;
+    block_of(pio)->sm[sm].div256 = whole * 256 + (uint32_t)((div - (float)whole) * 256);
+}
+
+bool pio_interrupt_get(const PIO pio, const uint irq) {
+    return (block_of(pio)->irq >> irq) & 1;
+}
+
+void pio_interrupt_clear(const PIO pio, const uint irq) {
+    block_of(pio)->irq &= (uint8_t)~(1u << irq);
+}
+
+static void sm_init(const PIO pio, const uint index, const pio_program_t *program, const uint pin, const uint baud,
+    const bool tx) {
+    sm_t *sm = &block_of(pio)->sm[index];
+    sm->program = find_program(program);
+    sm->pin = pin;
+    sm->pc = 0;
+    sm->delay = 0;
+    sm->x = sm->isr = sm->osr = 0;
+    sm->tx_len = sm->rx_len = 0;
+    sm->tx_depth = tx ? FIFO_DEPTH : 0;
+    sm->rx_depth = tx ? 0 : FIFO_DEPTH;
+    pio_sm_set_clkdiv(pio, index, (float)clock_get_hz(clk_sys) / (8 * baud));
+    sm->enabled = false;
+    pio_sm_set_enabled(pio, index, true);
+}
+
+void uart_tx_program_init(const PIO pio, const uint sm, const uint offset, const uint pin_tx, const uint baud) {
+    (void)offset;
+    pins[pin_tx] = true; // Idle high before the state machine takes the pin
+    sm_init(pio, sm, &uart_tx_program, pin_tx, baud, true);
+}
+
+void uart_rx_program_init(const PIO pio, const uint sm, const uint offset, const uint pin, const uint baud) {
+    (void)offset;
+    sm_init(pio, sm, &uart_rx_program, pin, baud, false);
+}
+
+int dma_claim_unused_channel(const bool required) {
+    for (int i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (!dmas[i].claimed) {
+            dmas[i].claimed = true;
+            return i;
+        }
+    }
+    if (required)
+        model_error("dma_claim_unused_channel", "no free channel");
+    return -1;
+}
+
+void dma_channel_unclaim(const uint channel) {
+    dmas[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(const uint channel) {
+    (void)channel;
+    return (dma_channel_config){ .size = DMA_SIZE_32, .read_increment = true, .dreq = DREQ_FORCE };
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, const enum dma_channel_transfer_size size) {
+    if (size != DMA_SIZE_8)
+        model_error("dma", "only byte transfers are modelled");
+    c->size = size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, const bool incr) {
+    c->read_increment = incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, const bool incr) {
+    c->write_increment = incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, const uint dreq) {
+    c->dreq = dreq;
+}
+
+void channel_config_set_ring(dma_channel_config *c, const bool write, const uint size_bits) {
+    c->ring_sel = write;
+    c->ring_bits = size_bits;
+}
+
+void dma_channel_configure(const uint channel, const dma_channel_config *config, volatile void *write_addr,
+    const volatile void *read_addr, const uint32_t transfer_count, const bool trigger) {
+    dma_t *d = &dmas[channel];
+    d->config = *config;
+    d->write = write_addr;
+    d->read = (volatile uint8_t *)read_addr;
+    d->count = transfer_count;
+    d->hw.write_addr = (uint32_t)(uintptr_t)write_addr;
+    d->hw.read_addr = (uint32_t)(uintptr_t)read_addr;
+    d->hw.transfer_count = transfer_count;
+    d->busy = trigger && transfer_count > 0;
+    service_dma();
+}
+
+dma_channel_hw_t *dma_channel_hw_addr(const uint channel) {
+    return &dmas[channel].hw;
+}
+
+bool dma_channel_is_busy(const uint channel) {
+    return dmas[channel].busy;
+}
+
+void dma_channel_wait_for_finish_blocking(const uint channel) {
+    while (dmas[channel].busy)
+        pio_model_run(1e-6);
+}
+
+void dma_channel_transfer_from_buffer_now(const uint channel, const volatile void *read_addr, const uint32_t transfer_count) {
+    dma_t *d = &dmas[channel];
+    d->read = (volatile uint8_t *)read_addr;
+    d->count = transfer_count;
+    d->hw.read_addr = (uint32_t)(uintptr_t)read_addr;
+    d->hw.transfer_count = transfer_count;
+    d->busy = transfer_count > 0;
+    service_dma();
+}
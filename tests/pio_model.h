@@ -0,0 +1,27 @@
+#ifndef PIO_MODEL_H
+#define PIO_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Behavioural model of the RP2040 PIO blocks and DMA, enough to run
+// pio_uart.c on the host. The programs are assembled from pio_uart.pio at
+// startup and executed cycle by cycle: side-set, delays, stalls on WAIT and
+// on empty or full FIFOs, the sticky IRQ flags, and the 16.8 fixed-point
+// clock divider. DMA moves bytes between memory and the FIFO registers when
+// their DREQ allows, with write address wrapping like the real ring mode.
+//
+// Time is continuous (seconds) and separate from the fake_sdk clock. Pins are
+// shared: a TX state machine on pin N drives what an RX state machine on pin N
+// samples, so two channels with crossed pins talk to each other.
+
+#define PIO_MODEL_PINS 30
+
+void pio_model_reset(uint32_t clk_sys_hz); // Everything unclaimed and idle, pins high
+void pio_model_set_clk_sys(uint32_t hz); // clock_get_hz(clk_sys) from now on; dividers keep their value
+void pio_model_run(double seconds); // Let the state machines and DMA run
+double pio_model_now(void);
+void pio_model_drive(uint32_t pin, bool level); // External level on a pin, until something else drives it
+bool pio_model_pin(uint32_t pin);
+
+#endif
@@ -0,0 +1,142 @@
+#include "sim_module.h"
+#include <stdio.h>
+#include <string.h>
+#include "fake_sdk.h"
+
+static bool booted(const sim_module_t *s) {
+    return !s->in_reset && time_us_64() >= s->up_at_us;
+}
+
+// Bytes go out back to back at the line rate, never before start_us
+static void emit(sim_module_t *s, const char *text, const uint64_t start_us) {
+    uint64_t t = start_us > s->line_free_us ? start_us : s->line_free_us;
+    for (; *text != '\0' && s->out_len < SIM_OUT_LEN; text++) {
+        t += SIM_BYTE_US;
+        s->out[s->out_len] = (uint8_t)*text;
+        s->out_due_us[s->out_len++] = t;
+    }
+    s->line_free_us = t;
+}
+
+static void answer(sim_module_t *s, const uint64_t at_us) {
+    const char *cmd = s->cmd;
+    char text[SIM_CMD_LEN + 64];
+    if (s->fault == SIM_GARBLING) {
+        emit(s, "\xff+A\x80T\x1f\x02\r\n", at_us);
+        return;
+    }
+    if (strcmp(cmd, "AT") == 0)
+        emit(s, "+AT: OK\r\n", at_us);
+    else if (strcmp(cmd, "AT+VER") == 0)
+        emit(s, "+VER: 4.0.11\r\n", at_us);
+    else if (strcmp(cmd, "AT+ID=DevEui") == 0) {
+        const uint64_t e = s->dev_eui;
+        snprintf(text, sizeof(text), "+ID: DevEui, %02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X\r\n",
+            (unsigned)(e >> 56) & 0xFF, (unsigned)(e >> 48) & 0xFF, (unsigned)(e >> 40) & 0xFF,
+            (unsigned)(e >> 32) & 0xFF, (unsigned)(e >> 24) & 0xFF, (unsigned)(e >> 16) & 0xFF,
+            (unsigned)(e >> 8) & 0xFF, (unsigned)e & 0xFF);
+        emit(s, text, at_us);
+    }
+    else if (strncmp(cmd, "AT+MSGHEX=", 10) == 0) {
+        s->uplinks++;
+        if (!s->joined) {
+            emit(s, "+MSGHEX: Please join network first\r\n+MSGHEX: Done\r\n", at_us);
+            return;
+        }
+        emit(s, "+MSGHEX: Start\r\n+MSGHEX: FPENDING\r\n", at_us);
+        const uint64_t done_us = at_us + (uint64_t)s->uplink_ms * 1000;
+        if (s->downlink != NULL) {
+            snprintf(text, sizeof(text), "+MSGHEX: PORT: 1; RX: \"%s\"\r\n+MSGHEX: RXWIN1, RSSI -106, SNR 4.5\r\n",
+                s->downlink);
+            emit(s, text, done_us);
+        }
+        emit(s, "+MSGHEX: Done\r\n", done_us);
+    }
+    else if (strcmp(cmd, "AT+RESET") == 0) {
+        emit(s, "+RESET: OK\r\n", at_us);
+        s->up_at_us = s->line_free_us + (uint64_t)s->boot_ms * 1000;
+        if (s->banner)
+            emit(s, "+AT: LoRaWAN modem is ready\r\n", s->up_at_us);
+    }
+    else
+        emit(s, "+AT: ERROR(-1)\r\n", at_us);
+}
+
+static void sim_write(void *hw, const char *data, const size_t len) {
+    sim_module_t *s = hw;
+    // The command has arrived once its last byte is through the wire
+    const uint64_t arrived_us = time_us_64() + (uint64_t)len * SIM_BYTE_US;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == '\r')
+            continue;
+        if (data[i] != '\n') {
+            if (s->cmd_len < SIM_CMD_LEN - 1)
+                s->cmd[s->cmd_len++] = data[i];
+            continue;
+        }
+        s->cmd[s->cmd_len] = '\0';
+        s->cmd_len = 0;
+        if (s->fault == SIM_ABSENT || !booted(s))
+            continue;
+        s->commands++;
+        memcpy(s->last_cmd, s->cmd, sizeof(s->cmd));
+        if (s->fault != SIM_WEDGED)
+            answer(s, arrived_us + SIM_REPLY_US);
+    }
+}
+
+static void sim_poll(void *hw, ring_t *rx, uint32_t *framing_errors) {
+    sim_module_t *s = hw;
+    const uint64_t now = time_us_64();
+    uint16_t n = 0;
+    while (n < s->out_len && s->out_due_us[n] <= now)
+        ring_put(rx, s->out[n++]);
+    memmove(s->out, &s->out[n], s->out_len - n);
+    memmove(s->out_due_us, &s->out_due_us[n], (s->out_len - n) * sizeof(s->out_due_us[0]));
+    s->out_len -= n;
+    // A framing error every 2 ms of line noise
+    if (s->fault == SIM_BREAKS && now - s->noise_us >= 2000) {
+        (*framing_errors)++;
+        s->noise_us = now;
+    }
+}
+
+const modem_port_t sim_module_port = { .write = sim_write, .poll = sim_poll };
+
+void sim_module_init(sim_module_t *s, const uint64_t dev_eui) {
+    memset(s, 0, sizeof(*s));
+    s->dev_eui = dev_eui;
+    s->fault = SIM_HEALTHY;
+    s->boot_ms = 150;
+    s->banner = true;
+    s->joined = true;
+    s->uplink_ms = 2500;
+}
+
+void sim_module_attach(sim_module_t *s, modem_t *m, const char *name) {
+    modem_init(m, name, &sim_module_port, s);
+}
+
+void sim_module_reset(sim_module_t *s, const bool asserted) {
+    if (asserted) {
+        // Whatever it was sending is cut off
+        s->in_reset = true;
+        s->out_len = 0;
+        s->cmd_len = 0;
+        s->line_free_us = time_us_64();
+        return;
+    }
+    if (!s->in_reset)
+        return;
+    s->in_reset = false;
+    s->resets++;
+    if (s->fault != SIM_ABSENT && s->resets_to_heal != 0 && s->resets >= s->resets_to_heal)
+        s->fault = SIM_HEALTHY;
+    s->up_at_us = time_us_64() + (uint64_t)s->boot_ms * 1000;
+    if (s->banner && s->fault != SIM_ABSENT)
+        emit(s, "+AT: LoRaWAN modem is ready\r\n", s->up_at_us);
+}
+
+void sim_module_say(sim_module_t *s, const char *text, const uint32_t delay_ms) {
+    emit(s, text, time_us_64() + (uint64_t)delay_ms * 1000);
+}
@@ -0,0 +1,72 @@
+#ifndef SIM_MODULE_H
+#define SIM_MODULE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "modem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Simulated LoRa-E5 behind a polled modem_port_t, on the virtual clock of
+// fake_sdk.h. Answers leave at 9600 baud (about a millisecond per byte) after
+// a short processing delay, so probe and uplink timing match the real module.
+// Faults can be injected: no module at all, a wedged AT parser, garbled
+// answers or line breaks; a reset (sim_module_reset) clears them after
+// resets_to_heal resets.
+
+#define SIM_BYTE_US 1042 // 10 bits at 9600 baud
+#define SIM_REPLY_US 3000 // Processing delay before an answer starts
+#define SIM_OUT_LEN 512
+#define SIM_CMD_LEN 160
+
+typedef enum {
+    SIM_HEALTHY,
+    SIM_ABSENT, // Nothing connected, never answers
+    SIM_WEDGED, // Powered but the AT parser hangs, until reset
+    SIM_GARBLING, // Answers arrive as noise, until reset
+    SIM_BREAKS // Line noise shows up as framing errors, until reset
+} sim_fault_t;
+
+typedef struct {
+    // Behaviour, set after sim_module_init()
+    uint64_t dev_eui;
+    sim_fault_t fault;
+    uint8_t resets_to_heal; // Resets until a fault clears, 0 for never
+    uint32_t boot_ms; // Reset to ready
+    bool banner; // Prints "+AT: LoRaWAN modem is ready" after booting
+    bool joined; // Uplinks fail with "Please join network first" otherwise
+    uint32_t uplink_ms; // "+MSGHEX: Start" to "Done", both receive windows
+    const char *downlink; // Hex payload in answer to uplinks, NULL for none
+
+    // Wire state
+    char cmd[SIM_CMD_LEN]; // Command being received
+    uint16_t cmd_len;
+    uint8_t out[SIM_OUT_LEN]; // Bytes on their way to the board
+    uint64_t out_due_us[SIM_OUT_LEN];
+    uint16_t out_len;
+    uint64_t line_free_us; // End of the last byte scheduled
+    uint64_t up_at_us; // End of the boot after a reset
+    uint64_t noise_us; // Last framing error injected
+    bool in_reset;
+
+    // Statistics
+    uint32_t commands;
+    uint32_t uplinks; // AT+MSGHEX received
+    uint32_t resets;
+    char last_cmd[SIM_CMD_LEN];
+} sim_module_t;
+
+extern const modem_port_t sim_module_port; // hw is the sim_module_t
+
+void sim_module_init(sim_module_t *s, uint64_t dev_eui); // Healthy, booted, joined
+void sim_module_attach(sim_module_t *s, modem_t *m, const char *name); // modem_init() on the simulated port
+void sim_module_reset(sim_module_t *s, bool asserted); // Reset line
+void sim_module_say(sim_module_t *s, const char *text, uint32_t delay_ms); // Unsolicited output
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
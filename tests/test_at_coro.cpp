@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <cstring>
+#include "at_coro.h"
+#include "at_coro.hpp"
+#include "check.h"
+#include "fake_sdk.h"
+#include "sim_module.h"
+
+// The coroutine AT layer (at_coro.cpp) against the simulated module: the
+// identity flow, coroutine frame sizes against the static pool, the module
+// claimed only while the flow runs, and lines nobody waits for reaching the
+// unsolicited handler instead of being lost.
+
+#define DEV_EUI 0x2CF7F1203230A570ull
+
+static sim_module_t sim;
+static modem_t m;
+static char dev_eui_line[LINE_LEN];
+static int unsolicited;
+static char unsolicited_line[LINE_LEN];
+
+// main.c prints the converted DevEui
+extern "C" void convert_and_print(const char *line) {
+    std::snprintf(dev_eui_line, sizeof(dev_eui_line), "%s", line);
+}
+
+static void on_unsolicited(modem_t *from) {
+    CHECK(from == &m);
+    unsolicited++;
+    std::snprintf(unsolicited_line, sizeof(unsolicited_line), "%s", from->line);
+}
+
+static void setup() {
+    fake_sdk_reset();
+    fake_advance_ms(1000);
+    sim_module_init(&sim, DEV_EUI);
+    sim_module_attach(&sim, &m, "sim");
+    dev_eui_line[0] = '\0';
+    unsolicited = 0;
+}
+
+// Poll once per millisecond like the reactor until the flow is no longer waiting, milliseconds taken
+static uint32_t run_flow() {
+    const uint32_t start = fake_now_ms();
+    bool busy = true;
+    while (busy && fake_now_ms() - start < 10000) {
+        fake_advance_ms(1);
+        busy = at_coro_poll(nullptr);
+    }
+    return fake_now_ms() - start;
+}
+
+static void test_identity() {
+    setup();
+    CHECK(at_coro_start());
+    CHECK(m.claimed);
+    CHECK(!at_coro_start()); // Already running
+    const uint32_t ms = run_flow();
+    CHECK(!m.claimed);
+    CHECK(std::strstr(dev_eui_line, "2C:F7:F1:20:32:30:A5:70") != nullptr);
+    CHECK_EQ(sim.commands, 3);
+    const at::frame_stats &s = at::stats();
+    std::printf("  flow took %u ms, coroutine frame %u of %u bytes\n", (unsigned)ms, (unsigned)s.largest,
+        (unsigned)at::frame_size);
+    CHECK(s.largest <= at::frame_size);
+    CHECK_EQ(s.failures, 0);
+    CHECK_EQ(s.in_use, 0);
+    CHECK_EQ(s.high_water, 1);
+}
+
+// The module is only taken when nobody else has it
+static void test_busy_module() {
+    setup();
+    modem_probe_start(&m, fake_now_ms());
+    CHECK(!at_coro_start());
+    CHECK(!m.claimed);
+    probe_state_t state;
+    do {
+        fake_advance_ms(1);
+        state = modem_probe_poll(&m, fake_now_ms());
+    } while (state != PROBE_DONE && state != PROBE_FAILED);
+    CHECK_EQ(state, PROBE_DONE);
+    m.state = PROBE_IDLE;
+
+    m.claimed = true; // Recovery resetting the module
+    CHECK(!at_coro_start());
+    m.claimed = false;
+    CHECK(at_coro_start());
+    run_flow();
+    CHECK(!m.claimed);
+}
+
+// No module: every AT times out, the flow gives up and lets go of the module
+static void test_absent() {
+    setup();
+    sim.fault = SIM_ABSENT;
+    CHECK(at_coro_start());
+    const uint32_t ms = run_flow();
+    CHECK(ms >= PROBE_AT_ATTEMPTS * PROBE_TIMEOUT_MS);
+    CHECK(ms <= PROBE_AT_ATTEMPTS * PROBE_TIMEOUT_MS + 10);
+    CHECK_EQ(sim.commands, 0); // Never heard
+    CHECK(!m.claimed);
+    CHECK(dev_eui_line[0] == '\0');
+    CHECK_EQ(at::stats().in_use, 0);
+}
+
+// A line already received when the flow starts is not an answer to it
+static void test_leftover_line() {
+    setup();
+    sim_module_say(&sim, "+MSG: late report\r\n", 0);
+    fake_advance_ms(50);
+    CHECK(at_coro_start());
+    CHECK_EQ(unsolicited, 1);
+    CHECK(std::strcmp(unsolicited_line, "+MSG: late report") == 0);
+    run_flow();
+    CHECK(dev_eui_line[0] != '\0');
+}
+
+// Between flows the layer leaves the module's lines to the event loop
+static void test_idle_leaves_lines() {
+    setup();
+    sim_module_say(&sim, "+AT: LoRaWAN modem is ready\r\n", 0);
+    fake_advance_ms(50);
+    CHECK(!at_coro_poll(nullptr));
+    CHECK_EQ(unsolicited, 0);
+    CHECK(modem_poll_line(&m));
+    CHECK(std::strcmp(m.line, "+AT: LoRaWAN modem is ready") == 0);
+}
+
+int main() {
+    at_coro_init(&m, on_unsolicited);
+    RUN(test_identity);
+    RUN(test_busy_module);
+    RUN(test_absent);
+    RUN(test_leftover_line);
+    RUN(test_idle_leaves_lines);
+    return check_result();
+}
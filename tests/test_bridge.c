@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "bridge.h"
+#include "check.h"
+
+// The bridge pump (bridge.c) between two pseudo-terminals: the slave side of
+// one stands in for the terminal on the USB host, the other for the module.
+// Bytes have to arrive complete and in order both ways, and a side that stops
+// reading has to stall the writer on the other side instead of losing data.
+
+#define DATA_LEN (512 * 1024) // More than the pty buffers on both sides of the bridge hold
+#define QUIET_MS 100 // Nothing moved for this long: stalled or done
+
+typedef struct {
+    int master; // Bridge end
+    int slave; // Test end
+} pty_t;
+
+static pty_t host, module;
+static bridge_port_t host_port, module_port;
+static bridge_t bridge;
+static uint8_t sent[2][DATA_LEN];
+static uint8_t got[2][DATA_LEN];
+
+static size_t fd_read(void *ctx, uint8_t *buf, const size_t max) {
+    const ssize_t n = read(*(const int *)ctx, buf, max);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static size_t fd_write(void *ctx, const uint8_t *data, const size_t len) {
+    const ssize_t n = write(*(const int *)ctx, data, len);
+    return n > 0 ? (size_t)n : 0;
+}
+
+// Raw and non-blocking on both ends, so bytes pass unchanged and nothing waits
+static bool pty_open(pty_t *p) {
+    p->master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (p->master < 0 || grantpt(p->master) != 0 || unlockpt(p->master) != 0)
+        return false;
+    p->slave = open(ptsname(p->master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (p->slave < 0)
+        return false;
+    struct termios t;
+    tcgetattr(p->slave, &t);
+    cfmakeraw(&t);
+    return tcsetattr(p->slave, TCSANOW, &t) == 0;
+}
+
+static void pty_close(pty_t *p) {
+    close(p->slave);
+    close(p->master);
+}
+
+static void setup(void) {
+    CHECK(pty_open(&host));
+    CHECK(pty_open(&module));
+    host_port = (bridge_port_t){ .read = fd_read, .write = fd_write, .dropped = NULL, .ctx = &host.master };
+    module_port = (bridge_port_t){ .read = fd_read, .write = fd_write, .dropped = NULL, .ctx = &module.master };
+    bridge_init(&bridge, &host_port, &module_port);
+    for (int d = 0; d < 2; d++) {
+        for (int i = 0; i < DATA_LEN; i++)
+            sent[d][i] = (uint8_t)rand();
+        memset(got[d], 0, DATA_LEN);
+    }
+}
+
+static void teardown(void) {
+    pty_close(&host);
+    pty_close(&module);
+}
+
+// Test ends of a direction: written into from, read out of to
+typedef struct {
+    int from;
+    int to;
+    size_t written;
+    size_t received;
+    bool reading;
+} stream_t;
+
+static bool step(stream_t *s, const int d) {
+    bool moved = false;
+    if (s->written < DATA_LEN) {
+        const ssize_t n = write(s->from, &sent[d][s->written], DATA_LEN - s->written);
+        if (n > 0) {
+            s->written += (size_t)n;
+            moved = true;
+        }
+    }
+    if (s->reading && s->received < DATA_LEN) {
+        const ssize_t n = read(s->to, &got[d][s->received], DATA_LEN - s->received);
+        if (n > 0) {
+            s->received += (size_t)n;
+            moved = true;
+        }
+    }
+    return moved;
+}
+
+// Pump until nothing has moved for QUIET_MS. The pty layer passes bytes on
+// asynchronously, so a quiet moment waits in poll() rather than giving up
+static void run(stream_t streams[2]) {
+    int quiet_ms = 0;
+    while (quiet_ms < QUIET_MS) {
+        bool moved = bridge_pump(&bridge);
+        for (int d = 0; d < 2; d++)
+            moved |= step(&streams[d], d);
+        if (moved) {
+            quiet_ms = 0;
+            continue;
+        }
+        struct pollfd fds[] = { { host.master, POLLIN, 0 }, { module.master, POLLIN, 0 } };
+        poll(fds, 2, 1);
+        quiet_ms++;
+    }
+}
+
+// Both directions at once, everything arrives unchanged
+static void test_both_ways(void) {
+    setup();
+    stream_t streams[2] = {
+        [BRIDGE_A_TO_B] = { .from = host.slave, .to = module.slave, .reading = true },
+        [BRIDGE_B_TO_A] = { .from = module.slave, .to = host.slave, .reading = true },
+    };
+    run(streams);
+    for (int d = 0; d < 2; d++) {
+        CHECK_EQ(streams[d].received, DATA_LEN);
+        CHECK(memcmp(got[d], sent[d], DATA_LEN) == 0);
+        CHECK_EQ(bridge.dir[d].bytes, DATA_LEN);
+        CHECK_EQ(bridge_dropped(&bridge.dir[d]), 0);
+    }
+    teardown();
+}
+
+// The module end stops reading: the bridge's ring and the pty buffers fill up
+// and then the host can write no more. Once the module reads again, every
+// byte the host got rid of arrives, in order
+static void test_backpressure(void) {
+    setup();
+    stream_t streams[2] = {
+        [BRIDGE_A_TO_B] = { .from = host.slave, .to = module.slave, .reading = false },
+        [BRIDGE_B_TO_A] = { .from = module.slave, .to = host.slave, .written = DATA_LEN, .received = DATA_LEN },
+    };
+    run(streams);
+    const size_t stalled_at = streams[BRIDGE_A_TO_B].written;
+    CHECK(stalled_at > RING_SIZE);
+    CHECK(stalled_at < DATA_LEN);
+    CHECK(write(host.slave, sent[0], 1) < 0); // Host is held off
+    CHECK(bridge.dir[BRIDGE_A_TO_B].bytes < stalled_at);
+
+    streams[BRIDGE_A_TO_B].reading = true;
+    run(streams);
+    CHECK_EQ(streams[BRIDGE_A_TO_B].received, DATA_LEN);
+    CHECK(memcmp(got[0], sent[0], DATA_LEN) == 0);
+    CHECK_EQ(bridge.dir[BRIDGE_A_TO_B].bytes, DATA_LEN);
+    teardown();
+}
+
+int main(void) {
+    srand(1);
+    RUN(test_both_ways);
+    RUN(test_backpressure);
+    return check_result();
+}
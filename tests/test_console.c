@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "check.h"
+#include "console.h"
+
+// The console (console.c) fed character by character as the terminal types:
+// line endings, editing, the echo, AT lines handed on, and the command table
+// with its argument checks. Its printf output is captured through a temporary
+// file standing in for stdout.
+
+#define OUT_LEN 1024
+
+static console_t console;
+static char out[OUT_LEN]; // Console output of the last type()
+static char at_line[CONSOLE_LINE_LEN];
+static int at_count;
+static int run_count;
+static int run_argc;
+static char run_args[CONSOLE_MAX_ARGS][CONSOLE_LINE_LEN];
+static int executed; // Lines console_feed() reported as executed
+
+static void on_at(const char *line, void *ctx) {
+    CHECK(ctx == &console);
+    at_count++;
+    snprintf(at_line, sizeof(at_line), "%s", line);
+}
+
+static void cmd_record(const int argc, char *argv[], void *ctx) {
+    CHECK(ctx == &console);
+    run_count++;
+    run_argc = argc;
+    for (int i = 0; i < argc; i++)
+        snprintf(run_args[i], sizeof(run_args[i]), "%s", argv[i]);
+    printf("ran\r\n");
+}
+
+static const console_command_t commands[] = {
+    { "stats", "", "Counters", cmd_record, 0, 0 },
+    { "config", "[module <n>]", "Show or change settings", cmd_record, 0, 2 },
+    { "uplink", "<hex payload>", "Queue an uplink", cmd_record, 1, 1 },
+};
+
+static void setup(void) {
+    console_init(&console, commands, sizeof(commands) / sizeof(commands[0]), on_at, &console);
+    at_count = 0;
+    run_count = 0;
+    run_argc = 0;
+    at_line[0] = '\0';
+}
+
+// Feed the characters with stdout going to a file, what was printed ends up in out
+static void type(const char *text, const size_t len) {
+    fflush(stdout);
+    const int saved = dup(STDOUT_FILENO);
+    FILE *capture = tmpfile();
+    dup2(fileno(capture), STDOUT_FILENO);
+    executed = 0;
+    for (size_t i = 0; i < len; i++)
+        executed += console_feed(&console, text[i]);
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    rewind(capture);
+    const size_t n = fread(out, 1, OUT_LEN - 1, capture);
+    out[n] = '\0';
+    fclose(capture);
+}
+
+static void type_str(const char *text) {
+    type(text, strlen(text));
+}
+
+// CR, LF and CRLF each end one line; the LF of a CRLF is not an empty second line
+static void test_line_endings(void) {
+    setup();
+    type_str("stats\r\nstats\rstats\n");
+    CHECK_EQ(executed, 3);
+    CHECK_EQ(run_count, 3);
+    type_str("\r\n\n");
+    CHECK_EQ(executed, 2); // Empty lines are executed, and do nothing
+    CHECK_EQ(run_count, 3);
+}
+
+// Lines starting with AT in either case go to the module unchanged, leading blanks aside
+static void test_at_lines(void) {
+    setup();
+    type_str("AT+ID=DevEui\r");
+    CHECK_EQ(at_count, 1);
+    CHECK(strcmp(at_line, "AT+ID=DevEui") == 0);
+    type_str("  at+ver  two words\r");
+    CHECK_EQ(at_count, 2);
+    CHECK(strcmp(at_line, "at+ver  two words") == 0);
+    CHECK_EQ(run_count, 0);
+}
+
+// Names match without regard to case, arguments are split on blanks
+static void test_commands(void) {
+    setup();
+    type_str("CONFIG module\t 1 \r");
+    CHECK_EQ(run_count, 1);
+    CHECK_EQ(run_argc, 3);
+    CHECK(strcmp(run_args[0], "CONFIG") == 0);
+    CHECK(strcmp(run_args[1], "module") == 0);
+    CHECK(strcmp(run_args[2], "1") == 0);
+    CHECK(strstr(out, "ran\r\n") != NULL);
+}
+
+// Wrong argument counts and unknown names are reported, nothing runs
+static void test_argument_checks(void) {
+    setup();
+    type_str("uplink\r");
+    CHECK(strstr(out, "Usage: uplink <hex payload>\r\n") != NULL);
+    type_str("stats now\r");
+    CHECK(strstr(out, "Usage: stats \r\n") != NULL);
+    type_str("config a b c d e f\r");
+    CHECK(strstr(out, "Too many arguments\r\n") != NULL);
+    type_str("reboot\r");
+    CHECK(strstr(out, "Unknown command reboot, try help\r\n") != NULL);
+    CHECK_EQ(run_count, 0);
+}
+
+static void test_help(void) {
+    setup();
+    type_str("help\r");
+    CHECK(strstr(out, "AT...") != NULL);
+    CHECK(strstr(out, "config [module <n>]") != NULL);
+    CHECK(strstr(out, "Queue an uplink") != NULL);
+    CHECK_EQ(run_count, 0);
+}
+
+// Typed characters are echoed, backspace and DEL take one back, other control characters are ignored
+static void test_editing(void) {
+    setup();
+    type_str("statx\b\x01s\x7F");
+    CHECK(strcmp(out, "statx\b \bs\b \b") == 0);
+    type_str("s\r");
+    CHECK_EQ(run_count, 1);
+    CHECK(strcmp(run_args[0], "stats") == 0);
+    type_str("\b\b\r"); // Nothing to take back
+    CHECK(strcmp(out, "\r\n") == 0);
+}
+
+static void test_no_echo(void) {
+    setup();
+    console.echo = false;
+    type_str("stats\b\bts\r");
+    CHECK(strcmp(out, "ran\r\n") == 0);
+    CHECK_EQ(run_count, 1);
+}
+
+// A line longer than the buffer is dropped whole, the next one is fine
+static void test_overflow(void) {
+    setup();
+    char line[CONSOLE_LINE_LEN + 20];
+    memset(line, 'x', sizeof(line));
+    memcpy(line, "AT+", 3);
+    line[sizeof(line) - 1] = '\r';
+    type(line, sizeof(line));
+    CHECK(strstr(out, "Line too long\r\n") != NULL);
+    CHECK_EQ(executed, 0);
+    CHECK_EQ(at_count, 0);
+    type_str("AT\r");
+    CHECK_EQ(at_count, 1);
+    CHECK(strcmp(at_line, "AT") == 0);
+}
+
+int main(void) {
+    RUN(test_line_endings);
+    RUN(test_at_lines);
+    RUN(test_commands);
+    RUN(test_argument_checks);
+    RUN(test_help);
+    RUN(test_editing);
+    RUN(test_no_echo);
+    RUN(test_overflow);
+    return check_result();
+}
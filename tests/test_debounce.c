@@ -0,0 +1,159 @@
+#include "check.h"
+#include "debounce.h"
+#include "fake_sdk.h"
+
+// debounce.c against bounce traces on a simulated pin: the level changes go
+// through the edge interrupt and the alarms of the fake SDK, as on the board.
+
+#define PIN 9 // SW_0
+#define MAX_ACTIONS 16
+
+static button_action_t actions[MAX_ACTIONS];
+static uint32_t action_ms[MAX_ACTIONS];
+static int count;
+
+static void handler(const uint gpio, const button_action_t action) {
+    CHECK_EQ(gpio, PIN);
+    if (count < MAX_ACTIONS) {
+        actions[count] = action;
+        action_ms[count] = fake_now_ms();
+    }
+    count++;
+}
+
+// Released and quiet for long enough that nothing is pending
+static void idle(void) {
+    fake_gpio_drive(PIN, true);
+    fake_advance_ms(2000);
+    count = 0;
+}
+
+// Contact bounce: the level flips every step_us for flips times, then settles on level
+static void bounce(const bool level, const int flips, const uint32_t step_us) {
+    for (int i = 0; i < flips; i++) {
+        fake_gpio_drive(PIN, (i % 2 == 0) == level);
+        fake_advance_us(step_us);
+    }
+    fake_gpio_drive(PIN, level);
+}
+
+static void press(void) {
+    bounce(false, 7, 300);
+}
+
+static void release(void) {
+    bounce(true, 5, 500);
+}
+
+// One short press with bouncing on both edges: release right away, the press
+// once the double-press window is over
+static void test_single_press(void) {
+    idle();
+    const uint32_t start = fake_now_ms();
+    press();
+    fake_advance_ms(100);
+    CHECK_EQ(count, 0);
+    release();
+    fake_advance_ms(DEBOUNCE_MS + 5);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(actions[0], BUTTON_RELEASE);
+    const uint32_t released = action_ms[0];
+    fake_advance_ms(DOUBLE_PRESS_MS);
+    CHECK_EQ(count, 2);
+    CHECK_EQ(actions[1], BUTTON_PRESS);
+    CHECK_EQ(action_ms[1], released + DOUBLE_PRESS_MS);
+    CHECK(action_ms[1] - start < 100 + 2 * DEBOUNCE_MS + DOUBLE_PRESS_MS + 10);
+}
+
+// Two quick presses give a double press and no single press before it
+static void test_double_press(void) {
+    idle();
+    press();
+    fake_advance_ms(80);
+    release();
+    fake_advance_ms(150);
+    press();
+    fake_advance_ms(DEBOUNCE_MS + 5);
+    CHECK_EQ(count, 2);
+    CHECK_EQ(actions[0], BUTTON_RELEASE);
+    CHECK_EQ(actions[1], BUTTON_DOUBLE_PRESS);
+    fake_advance_ms(LONG_PRESS_MS + 100);
+    release();
+    fake_advance_ms(2000);
+    // The second release does not start another single press, nor the held second press a long one
+    CHECK_EQ(count, 3);
+    CHECK_EQ(actions[2], BUTTON_RELEASE);
+}
+
+// A second press after the window is a new single press
+static void test_slow_second_press(void) {
+    idle();
+    press();
+    fake_advance_ms(80);
+    release();
+    fake_advance_ms(DOUBLE_PRESS_MS + 100);
+    press();
+    fake_advance_ms(80);
+    release();
+    fake_advance_ms(DOUBLE_PRESS_MS + 100);
+    CHECK_EQ(count, 4);
+    CHECK_EQ(actions[1], BUTTON_PRESS);
+    CHECK_EQ(actions[3], BUTTON_PRESS);
+}
+
+// Held: the long press comes while still held and replaces the press; a quick
+// press after it is not the second half of a double
+static void test_long_press(void) {
+    idle();
+    press();
+    fake_advance_ms(LONG_PRESS_MS + DEBOUNCE_MS + 5);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(actions[0], BUTTON_LONG_PRESS);
+    release();
+    fake_advance_ms(100);
+    press();
+    fake_advance_ms(80);
+    release();
+    fake_advance_ms(DOUBLE_PRESS_MS + 100);
+    CHECK_EQ(count, 4);
+    CHECK_EQ(actions[1], BUTTON_RELEASE);
+    CHECK_EQ(actions[2], BUTTON_RELEASE);
+    CHECK_EQ(actions[3], BUTTON_PRESS);
+}
+
+// Spikes shorter than the debounce time that settle back high are ignored
+static void test_glitch(void) {
+    idle();
+    for (int i = 0; i < 20; i++) {
+        bounce(true, 3, 200);
+        fake_advance_ms(DEBOUNCE_MS + 1);
+    }
+    fake_advance_ms(1000);
+    CHECK_EQ(count, 0);
+}
+
+// Bouncing for longer than DEBOUNCE_MS is sampled again once it settles
+static void test_long_bounce(void) {
+    idle();
+    bounce(false, 60, 500); // 30 ms of chatter
+    fake_advance_ms(LONG_PRESS_MS + 100);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(actions[0], BUTTON_LONG_PRESS);
+    release();
+    fake_advance_ms(DOUBLE_PRESS_MS + 100);
+    CHECK_EQ(count, 2);
+    CHECK_EQ(actions[1], BUTTON_RELEASE);
+}
+
+int main(void) {
+    fake_sdk_reset();
+    debounce_init(handler);
+    CHECK(debounce_add(PIN));
+    RUN(test_single_press);
+    RUN(test_double_press);
+    RUN(test_slow_second_press);
+    RUN(test_long_press);
+    RUN(test_glitch);
+    RUN(test_long_bounce);
+    return check_result();
+}
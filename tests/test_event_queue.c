@@ -0,0 +1,287 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "check.h"
+#include "event_queue.h"
+
+// Event queue under interrupt storms: delivery order, coalescing, eviction,
+// the drop accounting, and a producer thread standing in for the interrupt
+// handlers while the main thread drains, with the cost per event.
+
+#define STORM_MS 1000
+#define STALL_MS 20 // Main loop busy, e.g. a flash sector erase
+#define LINES_PER_MS 4 // One unsolicited line per module and millisecond
+#define BOUNCES_PER_MS 50 // Raw button edges, far more than a real contact
+#define DRAIN_PER_MS 8 // Events the main loop handles per millisecond
+#define THREAD_EVENTS 2000000
+#define THREAD_AHEAD 34 // Producer runs at most this many events ahead, enough to overflow now and then
+
+static event_queue_t q;
+
+// Events stored = delivered + still pending + evicted; adds that returned false were never stored
+typedef struct {
+    uint32_t accepted; // event_queue_add() returned true
+    uint32_t rejected; // ... false
+    uint32_t delivered;
+} tally_t;
+
+static void add(tally_t *t, const event_type type, const int32_t data) {
+    const event_t e = { .type = type, .data = data };
+    if (event_queue_add(&q, &e))
+        t->accepted++;
+    else
+        t->rejected++;
+}
+
+static void check_tally(const tally_t *t) {
+    const uint32_t evicted = q.dropped - t->rejected;
+    CHECK_EQ(t->accepted - q.coalesced, t->delivered + q.pending + evicted);
+    CHECK(q.high_water <= EVENT_QUEUE_LEN);
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Highest priority first, FIFO within a priority
+static void test_order(void) {
+    event_queue_init(&q);
+    event_queue_configure(&q, EVENT_USER, EVENT_PRIO_HIGH, false);
+    event_queue_configure(&q, EVENT_CONSOLE, EVENT_PRIO_LOW, false);
+    const event_t in[] = { { EVENT_CONSOLE, 1 }, { EVENT_UART_LINE, 2 }, { EVENT_USER, 3 }, { EVENT_UART_LINE, 4 },
+        { EVENT_USER, 5 } };
+    for (size_t i = 0; i < sizeof(in) / sizeof(in[0]); i++)
+        CHECK(event_queue_add(&q, &in[i]));
+    const int32_t expected[] = { 3, 5, 2, 4, 1 };
+    event_t e;
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        CHECK(event_queue_remove(&q, &e));
+        CHECK_EQ(e.data, expected[i]);
+    }
+    CHECK(!event_queue_remove(&q, &e));
+}
+
+// A coalescing type keeps one pending event per data value
+static void test_coalescing(void) {
+    event_queue_init(&q);
+    event_queue_configure(&q, EVENT_BUTTON, EVENT_PRIO_NORMAL, true);
+    tally_t t = { 0 };
+    for (int i = 0; i < 100; i++)
+        add(&t, EVENT_BUTTON, i % 2);
+    CHECK_EQ(q.pending, 2);
+    CHECK_EQ(q.coalesced, 98);
+    event_t e;
+    CHECK(event_queue_remove(&q, &e) && e.data == 0);
+    t.delivered++;
+    add(&t, EVENT_BUTTON, 0); // No longer pending, stored again behind the 1
+    CHECK(event_queue_remove(&q, &e) && e.data == 1);
+    CHECK(event_queue_remove(&q, &e) && e.data == 0);
+    t.delivered += 2;
+    CHECK_EQ(q.dropped, 0);
+    check_tally(&t);
+}
+
+// When full, a new event evicts the newest one of a lower priority, never an equal or higher one
+static void test_eviction(void) {
+    event_queue_init(&q);
+    event_queue_configure(&q, EVENT_USER, EVENT_PRIO_HIGH, false);
+    event_queue_configure(&q, EVENT_CONSOLE, EVENT_PRIO_LOW, false);
+    tally_t t = { 0 };
+    for (int i = 0; i < EVENT_QUEUE_LEN; i++)
+        add(&t, EVENT_CONSOLE, i);
+    add(&t, EVENT_CONSOLE, 99);
+    CHECK_EQ(t.rejected, 1);
+    add(&t, EVENT_USER, 100);
+    add(&t, EVENT_UART_LINE, 101);
+    CHECK_EQ(t.rejected, 1);
+    CHECK_EQ(q.dropped, 3);
+    event_t e;
+    CHECK(event_queue_remove(&q, &e) && e.data == 100);
+    CHECK(event_queue_remove(&q, &e) && e.data == 101);
+    t.delivered += 2;
+    // The two oldest low-priority events survived, the newest ones went
+    for (int i = 0; i < EVENT_QUEUE_LEN - 2; i++) {
+        CHECK(event_queue_remove(&q, &e) && e.data == i);
+        t.delivered++;
+    }
+    check_tally(&t);
+
+    // Full of high-priority events: nothing lower can get in
+    for (int i = 0; i < EVENT_QUEUE_LEN; i++)
+        add(&t, EVENT_USER, i);
+    add(&t, EVENT_UART_LINE, 0);
+    add(&t, EVENT_USER, 0);
+    CHECK_EQ(t.rejected, 3);
+    check_tally(&t);
+}
+
+// Firmware configuration under a storm: bouncing raw button states, lines from
+// every module, console typing, a high-priority timer; the main loop drains a
+// fixed number per millisecond and stalls now and then
+static void test_storm(void) {
+    event_queue_init(&q);
+    event_queue_configure(&q, EVENT_BUTTON, EVENT_PRIO_NORMAL, true);
+    event_queue_configure(&q, EVENT_CONSOLE, EVENT_PRIO_LOW, true);
+    event_queue_configure(&q, EVENT_TIMER, EVENT_PRIO_HIGH, false);
+    tally_t t = { 0 };
+    uint32_t timers_sent = 0, timers_seen = 0, lines_seen = 0, worst_wait_ms = 0;
+    for (uint32_t ms = 0; ms < STORM_MS; ms++) {
+        for (int i = 0; i < BOUNCES_PER_MS; i++)
+            add(&t, EVENT_BUTTON, i % 2);
+        for (int m = 0; m < LINES_PER_MS; m++)
+            add(&t, EVENT_UART_LINE, m);
+        add(&t, EVENT_CONSOLE, 0);
+        if (ms % 10 == 0) {
+            add(&t, EVENT_TIMER, (int32_t)ms);
+            timers_sent++;
+        }
+        if (ms % 250 >= 250 - STALL_MS)
+            continue;
+        event_t e;
+        for (int i = 0; i < DRAIN_PER_MS && event_queue_remove(&q, &e); i++) {
+            t.delivered++;
+            if (e.type == EVENT_TIMER) {
+                timers_seen++;
+                if (ms - (uint32_t)e.data > worst_wait_ms)
+                    worst_wait_ms = ms - (uint32_t)e.data;
+            }
+            lines_seen += e.type == EVENT_UART_LINE;
+        }
+    }
+    event_t e;
+    while (event_queue_remove(&q, &e)) {
+        t.delivered++;
+        timers_seen += e.type == EVENT_TIMER;
+        lines_seen += e.type == EVENT_UART_LINE;
+    }
+    printf("  %u events offered, %u delivered, %u coalesced, %u dropped, high water %u\n",
+        (unsigned)(t.accepted + t.rejected), (unsigned)t.delivered, (unsigned)q.coalesced, (unsigned)q.dropped,
+        (unsigned)q.high_water);
+    printf("  timers %u/%u, longest wait %u ms; lines %u/%u\n", (unsigned)timers_seen, (unsigned)timers_sent,
+        (unsigned)worst_wait_ms, (unsigned)lines_seen, (unsigned)(STORM_MS * LINES_PER_MS));
+    CHECK_EQ(timers_seen, timers_sent); // High priority survives every stall
+    CHECK(worst_wait_ms <= STALL_MS); // and is handled as soon as the loop runs again
+    CHECK(q.dropped > 0); // The stalls did overflow the queue
+    CHECK_EQ(q.high_water, EVENT_QUEUE_LEN);
+    check_tally(&t);
+}
+
+typedef struct {
+    uint32_t sent[EVENT_TYPE_COUNT];
+    tally_t tally;
+    atomic_uint ordered_taken; // Timer and line events the consumer has seen or lost
+    atomic_bool done;
+} producer_t;
+
+// Interrupt handlers on another core: sequence numbers per type in data. The
+// producer is paced by the consumer so that both keep taking the lock, instead
+// of one thread filling the queue while the other is not scheduled.
+static void *producer(void *arg) {
+    producer_t *p = arg;
+    uint32_t ordered = 0;
+    for (uint32_t i = 0; i < THREAD_EVENTS; i++) {
+        const event_type type = i % 5 == 0 ? EVENT_TIMER : i % 5 == 1 ? EVENT_BUTTON : EVENT_UART_LINE;
+        if (type != EVENT_BUTTON) {
+            while (ordered - atomic_load(&p->ordered_taken) >= THREAD_AHEAD && !atomic_load(&p->done))
+                sched_yield();
+            ordered++;
+        }
+        const int32_t data = type == EVENT_BUTTON ? (int32_t)(i & 2) : (int32_t)p->sent[type]++;
+        const event_t e = { .type = type, .data = data };
+        if (event_queue_add(&q, &e))
+            p->tally.accepted++;
+        else
+            p->tally.rejected++;
+    }
+    atomic_store(&p->done, true);
+    return NULL;
+}
+
+// Producer and consumer really run at once: the lock keeps the lists intact,
+// each type still arrives in order, and the counters add up
+static void test_threads(void) {
+    event_queue_init(&q);
+    event_queue_configure(&q, EVENT_BUTTON, EVENT_PRIO_NORMAL, true);
+    event_queue_configure(&q, EVENT_TIMER, EVENT_PRIO_HIGH, false);
+    static producer_t p;
+    pthread_t thread;
+    const double start = seconds();
+    CHECK(pthread_create(&thread, NULL, producer, &p) == 0);
+    int32_t last[EVENT_TYPE_COUNT] = { -1, -1, -1, -1, -1 };
+    bool in_order = true;
+    uint32_t delivered = 0;
+    uint32_t dropped_seen = 0;
+    for (;;) {
+        const bool finished = atomic_load(&p.done);
+        event_t e;
+        while (event_queue_remove(&q, &e)) {
+            delivered++;
+            if (e.type != EVENT_BUTTON) {
+                in_order &= e.data > last[e.type];
+                last[e.type] = e.data;
+                atomic_fetch_add(&p.ordered_taken, 1);
+            }
+        }
+        // Lost events will never come, let the producer go on (buttons are never dropped here)
+        critical_section_enter_blocking(&q.lock);
+        const uint32_t dropped = q.dropped;
+        critical_section_exit(&q.lock);
+        atomic_fetch_add(&p.ordered_taken, dropped - dropped_seen);
+        dropped_seen = dropped;
+        if (finished)
+            break;
+        sched_yield(); // Queue empty, on a single core the producer needs the CPU
+    }
+    pthread_join(thread, NULL);
+    const double elapsed = seconds() - start;
+    p.tally.delivered = delivered;
+    printf("  %u events through two threads in %.0f ms (%.0f ns each), %u dropped, %u coalesced\n",
+        (unsigned)THREAD_EVENTS, elapsed * 1e3, elapsed * 1e9 / THREAD_EVENTS, (unsigned)q.dropped,
+        (unsigned)q.coalesced);
+    CHECK(in_order);
+    CHECK(delivered > THREAD_EVENTS / 2);
+    CHECK_EQ(q.pending, 0);
+    check_tally(&p.tally);
+}
+
+// Cost of the queue itself on the host: add/remove pairs, and an add that
+// scans a full priority list for a duplicate
+static void test_throughput(void) {
+    event_queue_init(&q);
+    event_queue_configure(&q, EVENT_BUTTON, EVENT_PRIO_NORMAL, true);
+    const uint32_t n = 5000000;
+    event_t e = { EVENT_UART_LINE, 0 };
+    double start = seconds();
+    for (uint32_t i = 0; i < n; i++) {
+        e.data = (int32_t)i;
+        event_queue_add(&q, &e);
+        event_queue_remove(&q, &e);
+    }
+    const double pair_ns = (seconds() - start) * 1e9 / n;
+
+    for (int i = 0; i < EVENT_QUEUE_LEN - 1; i++) {
+        const event_t line = { EVENT_UART_LINE, i };
+        event_queue_add(&q, &line);
+    }
+    const event_t button = { EVENT_BUTTON, 1 };
+    event_queue_add(&q, &button);
+    start = seconds();
+    for (uint32_t i = 0; i < n; i++)
+        event_queue_add(&q, &button); // Found at the end of the list, coalesced
+    const double scan_ns = (seconds() - start) * 1e9 / n;
+    printf("  add+remove %.1f ns, coalescing add over a full list %.1f ns\n", pair_ns, scan_ns);
+    CHECK_EQ(q.coalesced, n);
+}
+
+int main(void) {
+    RUN(test_order);
+    RUN(test_coalescing);
+    RUN(test_eviction);
+    RUN(test_storm);
+    RUN(test_threads);
+    RUN(test_throughput);
+    return check_result();
+}
@@ -0,0 +1,265 @@
+#include <string.h>
+#include <time.h>
+#include "check.h"
+#include "file_storage.h"
+#include "flash_queue.h"
+
+// Store-and-forward queue on the file backend: ordering, power loss, wear
+// levelling over many laps of the ring, and append/drain throughput.
+// Usage: test_flash_queue <scratch file>
+
+#define SECTORS 16 // Same region size as the firmware (FLASH_STORAGE_SECTORS)
+#define ENDURANCE_LAPS 40
+
+static const char *path;
+static file_storage_t fs;
+static flash_queue_t q;
+
+typedef struct {
+    uint32_t count;
+    uint32_t next; // Counter expected in the next record
+    bool in_order;
+    uint32_t refuse_after; // Handler fails once this many records were taken
+} drain_log_t;
+
+// Records carry a 32-bit counter followed by filler derived from it
+static size_t make_record(uint8_t *buf, const uint32_t n) {
+    const size_t len = 4 + n % (FQ_PAYLOAD_MAX - 3);
+    memcpy(buf, &n, 4);
+    for (size_t i = 4; i < len; i++)
+        buf[i] = (uint8_t)(n * 31 + i);
+    return len;
+}
+
+static bool record_handler(const uint8_t *payload, const size_t len, void *ctx) {
+    drain_log_t *log = ctx;
+    if (log->count == log->refuse_after)
+        return false;
+    uint8_t expected[FQ_PAYLOAD_MAX];
+    uint32_t n;
+    memcpy(&n, payload, 4);
+    if (n != log->next || len != make_record(expected, n) || memcmp(payload, expected, len) != 0)
+        log->in_order = false;
+    log->next = n + 1;
+    log->count++;
+    return true;
+}
+
+static drain_log_t drain_all(const uint32_t first) {
+    drain_log_t log = { .count = 0, .next = first, .in_order = true, .refuse_after = UINT32_MAX };
+    flash_queue_drain(&q, record_handler, &log, SIZE_MAX);
+    return log;
+}
+
+static void append_records(const uint32_t first, const uint32_t count) {
+    uint8_t buf[FQ_PAYLOAD_MAX];
+    for (uint32_t n = first; n < first + count; n++)
+        CHECK(flash_queue_append(&q, buf, make_record(buf, n)));
+}
+
+static void fresh_queue(void) {
+    file_storage_close(&fs);
+    CHECK(file_storage_open(&fs, path, SECTORS, true));
+    flash_queue_mount(&q, &fs.storage);
+}
+
+// Power cycle: everything in RAM is lost, the queue is rebuilt from the file
+static void remount(void) {
+    file_storage_close(&fs);
+    CHECK(file_storage_open(&fs, path, SECTORS, false));
+    flash_queue_mount(&q, &fs.storage);
+}
+
+static void test_order(void) {
+    fresh_queue();
+    CHECK(!flash_queue_append(&q, (const uint8_t *)"", FQ_PAYLOAD_MAX + 1));
+    append_records(0, 10);
+    CHECK_EQ(q.pending, 10);
+    const drain_log_t log = drain_all(0);
+    CHECK_EQ(log.count, 10);
+    CHECK(log.in_order);
+    CHECK_EQ(q.pending, 0);
+}
+
+static void test_failed_send_keeps_record(void) {
+    fresh_queue();
+    append_records(0, 5);
+    drain_log_t log = { .count = 0, .next = 0, .in_order = true, .refuse_after = 2 };
+    CHECK_EQ(flash_queue_drain(&q, record_handler, &log, SIZE_MAX), 2);
+    CHECK_EQ(q.pending, 3);
+    log = drain_all(2);
+    CHECK_EQ(log.count, 3);
+    CHECK(log.in_order);
+}
+
+// The uplink sender peeks at the oldest record and pops it once the module reported it sent
+static void test_peek_pop(void) {
+    fresh_queue();
+    uint8_t payload[FQ_PAYLOAD_MAX], expected[FQ_PAYLOAD_MAX];
+    size_t len;
+    CHECK(!flash_queue_peek(&q, payload, &len));
+    append_records(0, 2);
+    CHECK(flash_queue_peek(&q, payload, &len));
+    CHECK(flash_queue_peek(&q, payload, &len));
+    CHECK_EQ(len, make_record(expected, 0));
+    CHECK(memcmp(payload, expected, len) == 0);
+    flash_queue_pop(&q);
+    CHECK(flash_queue_peek(&q, payload, &len));
+    CHECK_EQ(len, make_record(expected, 1));
+    flash_queue_pop(&q);
+    CHECK_EQ(q.pending, 0);
+    flash_queue_pop(&q);
+    CHECK_EQ(q.pending, 0);
+}
+
+static void test_remount(void) {
+    fresh_queue();
+    append_records(0, 7);
+    drain_log_t log = { .count = 0, .next = 0, .in_order = true, .refuse_after = UINT32_MAX };
+    flash_queue_drain(&q, record_handler, &log, 3);
+    remount();
+    CHECK_EQ(q.pending, 4);
+    CHECK_EQ(q.next_seq, 7);
+    CHECK_EQ(q.corrupted, 0);
+    append_records(7, 2);
+    log = drain_all(3);
+    CHECK_EQ(log.count, 6);
+    CHECK(log.in_order);
+}
+
+// Power fails while a record is programmed: the torn slot fails its CRC and
+// the records before it survive
+static void test_torn_append(void) {
+    fresh_queue();
+    // The torn record starts the second page, so the bytes that reach the flash are its own
+    append_records(0, FQ_PAGE_SIZE / FQ_SLOT_SIZE);
+    file_storage_power_fail(&fs, 0, FQ_HEADER_SIZE + 4);
+    uint8_t buf[FQ_PAYLOAD_MAX];
+    flash_queue_append(&q, buf, make_record(buf, 4));
+    file_storage_power_on(&fs);
+    remount();
+    CHECK_EQ(q.pending, 4);
+    CHECK_EQ(q.corrupted, 1);
+    // The torn slot cannot be programmed again and is stepped over
+    append_records(4, 2);
+    const drain_log_t log = drain_all(0);
+    CHECK_EQ(log.count, 6);
+    CHECK(log.in_order);
+}
+
+// Power fails while a sent record is marked consumed: it is sent again after
+// the restart (at least once delivery), never lost
+static void test_torn_consume(void) {
+    fresh_queue();
+    append_records(0, 2);
+    file_storage_power_fail(&fs, 0, 0);
+    drain_log_t log = { .count = 0, .next = 0, .in_order = true, .refuse_after = UINT32_MAX };
+    flash_queue_drain(&q, record_handler, &log, 1);
+    file_storage_power_on(&fs);
+    remount();
+    CHECK_EQ(q.pending, 2);
+    log = drain_all(0);
+    CHECK_EQ(log.count, 2);
+    CHECK(log.in_order);
+}
+
+// With the ring full the oldest sector is given up, new records are never refused
+static void test_full_ring(void) {
+    fresh_queue();
+    const uint32_t total = q.slot_count + 100;
+    append_records(0, total);
+    CHECK_EQ(q.pending + q.dropped, total);
+    CHECK(q.dropped >= 100);
+    CHECK(q.dropped <= 100 + FQ_SLOTS_PER_SECTOR);
+    const drain_log_t log = drain_all(q.dropped);
+    CHECK_EQ(log.count, total - q.dropped);
+    CHECK(log.in_order);
+}
+
+static void test_format(void) {
+    fresh_queue();
+    append_records(0, 20);
+    flash_queue_format(&q);
+    CHECK_EQ(q.pending, 0);
+    CHECK_EQ(q.next_seq, 0);
+    CHECK_EQ(q.head, 0);
+    append_records(0, 3);
+    // Sequence numbers continue from the same point after a restart
+    const uint32_t seq = q.next_seq;
+    remount();
+    CHECK_EQ(q.next_seq, seq);
+    CHECK_EQ(q.pending, 3);
+    const drain_log_t log = drain_all(0);
+    CHECK_EQ(log.count, 3);
+    CHECK(log.in_order);
+}
+
+// Many laps of the ring with the idle-time pre-erase: every sector is erased
+// once per lap and nothing is lost or duplicated
+static void test_endurance(void) {
+    fresh_queue();
+    const uint32_t total = q.slot_count * ENDURANCE_LAPS;
+    uint32_t appended = 0;
+    drain_log_t log = { .count = 0, .next = 0, .in_order = true, .refuse_after = UINT32_MAX };
+    uint32_t batch = 1;
+    while (appended < total) {
+        // Bursts of varying size while offline, drained when the network is back
+        batch = batch * 7 % 97 + 1;
+        const uint32_t n = batch < total - appended ? batch : total - appended;
+        append_records(appended, n);
+        appended += n;
+        flash_queue_drain(&q, record_handler, &log, SIZE_MAX);
+        flash_queue_maintain(&q);
+    }
+    CHECK_EQ(log.count, total);
+    CHECK(log.in_order);
+    CHECK_EQ(q.dropped, 0);
+    CHECK_EQ(q.corrupted, 0);
+    const uint32_t max = file_storage_max_erases(&fs), min = file_storage_min_erases(&fs);
+    printf("  %u records, %u laps: erases per sector %u-%u, %u program operations\n", (unsigned)total,
+        (unsigned)ENDURANCE_LAPS, (unsigned)min, (unsigned)max, (unsigned)fs.programs);
+    CHECK(max - min <= 1);
+    CHECK(max <= ENDURANCE_LAPS + 1);
+}
+
+static double seconds(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Host figures, the flash itself is far slower: they show the cost of the
+// queue logic and the number of storage operations per record
+static void test_throughput(void) {
+    fresh_queue();
+    const uint32_t count = q.slot_count / 2;
+    const double start = seconds();
+    append_records(0, count);
+    const double appended = seconds();
+    const drain_log_t log = drain_all(0);
+    const double drained = seconds();
+    CHECK_EQ(log.count, count);
+    printf("  append %.0f records/s, drain %.0f records/s, %.2f programs per record\n",
+        count / (appended - start), count / (drained - appended), (double)fs.programs / count);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        printf("Usage: %s <scratch file>\n", argv[0]);
+        return 2;
+    }
+    path = argv[1];
+    RUN(test_order);
+    RUN(test_failed_send_keeps_record);
+    RUN(test_peek_pop);
+    RUN(test_remount);
+    RUN(test_torn_append);
+    RUN(test_torn_consume);
+    RUN(test_full_ring);
+    RUN(test_format);
+    RUN(test_endurance);
+    RUN(test_throughput);
+    file_storage_close(&fs);
+    remove(path);
+    return check_result();
+}
@@ -0,0 +1,142 @@
+#include <string.h>
+#include "check.h"
+#include "governor.h"
+
+// The clk_sys governor policy (governor.c) driven with busy/idle traces once a
+// millisecond, as the reactor poller in main.c does, with a clock switch that
+// can be made to fail. The energy figures are checked against hand-computed
+// values from GOVERNOR_CURRENT_UA at GOVERNOR_SUPPLY_MV.
+
+// nJ per ms at each level: uA * mV / 1000
+#define FULL_NJ_MS 82500ull // 25 mA
+#define MID_NJ_MS 39600ull // 12 mA
+#define LOW_NJ_MS 26400ull // 8 mA
+
+static governor_t governor;
+static uint32_t now_ms;
+static bool clock_fails;
+static uint32_t switch_attempts;
+
+static void setup(void) {
+    now_ms = 0;
+    clock_fails = false;
+    switch_attempts = 0;
+    governor_init(&governor, now_ms);
+}
+
+// govern_clock() in main.c, with sysclk_set_khz() failing while clock_fails is set
+static void govern(const bool busy) {
+    const uint8_t level = governor_update(&governor, busy, now_ms);
+    if (level != governor.level) {
+        switch_attempts++;
+        if (!clock_fails)
+            governor_set_level(&governor, level);
+    }
+}
+
+// ms milliseconds of the same load, one update per millisecond
+static void run(const uint32_t ms, const bool busy) {
+    for (uint32_t i = 0; i < ms; i++) {
+        now_ms++;
+        govern(busy);
+    }
+}
+
+// Full speed for GOVERNOR_HOLD_MS after the burst, then one level down per
+// GOVERNOR_STEP_MS until the slowest; a burst goes straight back to full speed
+static void test_levels(void) {
+    setup();
+    run(100, true);
+    CHECK_EQ(governor.level, 0);
+    run(GOVERNOR_HOLD_MS - 1, false);
+    CHECK_EQ(governor.level, 0);
+    run(1, false);
+    CHECK_EQ(governor.level, 1);
+    CHECK_EQ(governor_khz(governor.level), 48000);
+    run(GOVERNOR_STEP_MS - 1, false);
+    CHECK_EQ(governor.level, 1);
+    run(1, false);
+    CHECK_EQ(governor.level, 2);
+    run(10 * GOVERNOR_STEP_MS, false);
+    CHECK_EQ(governor.level, GOVERNOR_LEVELS - 1);
+    CHECK_EQ(governor.changes, 2);
+    run(1, true);
+    CHECK_EQ(governor.level, 0);
+    CHECK_EQ(governor.changes, 3);
+    CHECK_EQ(switch_attempts, 3);
+}
+
+// A millisecond is charged to the level that ran through it
+static void test_time_per_level(void) {
+    setup();
+    run(100, true);
+    run(900, false);
+    CHECK_EQ(governor.time_ms[0], 100 + GOVERNOR_HOLD_MS);
+    CHECK_EQ(governor.time_ms[1], GOVERNOR_STEP_MS);
+    CHECK_EQ(governor.time_ms[2], 1000 - 100 - GOVERNOR_HOLD_MS - GOVERNOR_STEP_MS);
+}
+
+// One burst of 100 ms from full speed: 8250 uJ. A second one of 50 ms from the
+// slowest level spends its first millisecond there before the clock is raised:
+// 26.4 uJ + 49 * 82.5 uJ, so (8250 + 4068.9) / 2 = 6159 uJ per transaction
+static void test_energy(void) {
+    setup();
+    CHECK_EQ(governor_energy_per_transaction_uj(&governor), 0);
+    run(100, true);
+    governor_transaction_done(&governor);
+    CHECK_EQ(governor.busy_energy_nj, 100 * FULL_NJ_MS);
+    CHECK_EQ(governor_energy_per_transaction_uj(&governor), 8250);
+    run(900, false);
+    CHECK_EQ(governor.energy_nj, 300 * FULL_NJ_MS + 500 * MID_NJ_MS + 200 * LOW_NJ_MS);
+    CHECK_EQ(governor.busy_energy_nj, 100 * FULL_NJ_MS);
+
+    run(50, true);
+    governor_transaction_done(&governor);
+    CHECK_EQ(governor.busy_energy_nj, 100 * FULL_NJ_MS + LOW_NJ_MS + 49 * FULL_NJ_MS);
+    CHECK_EQ(governor_energy_per_transaction_uj(&governor), 6159);
+}
+
+// While the clock cannot be switched the governor stays at the level the chip
+// runs at: time and energy go to full speed, the change is proposed again on
+// every update, and once a switch works it goes straight to the level due by then
+static void test_failed_switch(void) {
+    setup();
+    run(100, true);
+    clock_fails = true;
+    run(900, false);
+    CHECK_EQ(governor.level, 0);
+    CHECK_EQ(governor.changes, 0);
+    CHECK_EQ(switch_attempts, 900 - GOVERNOR_HOLD_MS + 1);
+    CHECK_EQ(governor.time_ms[0], 1000);
+    CHECK_EQ(governor.time_ms[1], 0);
+    CHECK_EQ(governor.energy_nj, 1000 * FULL_NJ_MS);
+
+    clock_fails = false;
+    run(1, false);
+    CHECK_EQ(governor.level, 2);
+    CHECK_EQ(governor.changes, 1);
+    run(100, false);
+    CHECK_EQ(governor.time_ms[0], 1001);
+    CHECK_EQ(governor.time_ms[2], 100);
+    CHECK_EQ(governor.energy_nj, 1001 * FULL_NJ_MS + 100 * LOW_NJ_MS);
+}
+
+// Updates need not come every millisecond: a long gap is charged at once
+static void test_sparse_updates(void) {
+    setup();
+    now_ms = 2000;
+    govern(false);
+    CHECK_EQ(governor.level, 2);
+    CHECK_EQ(governor.time_ms[0], 2000);
+    CHECK_EQ(governor.energy_nj, 2000 * FULL_NJ_MS);
+    CHECK_EQ(governor_khz(GOVERNOR_LEVELS + 5), 24000);
+}
+
+int main(void) {
+    RUN(test_levels);
+    RUN(test_time_per_level);
+    RUN(test_energy);
+    RUN(test_failed_switch);
+    RUN(test_sparse_updates);
+    return check_result();
+}
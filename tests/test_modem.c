@@ -0,0 +1,170 @@
+#include <string.h>
+#include "check.h"
+#include "fake_sdk.h"
+#include "modem.h"
+#include "sim_module.h"
+
+// Probe and uplink engines of modem.c against the simulated module. Both are
+// advanced once per millisecond of virtual time, the way poll_modems() does,
+// and no call may let time pass: nothing blocks.
+
+#define DEV_EUI 0x2CF7F1203230A570ull
+#define MSGHEX "AT+MSGHEX=\"0102A0\"\r\n"
+
+static sim_module_t sim;
+static modem_t m;
+static uint8_t downlink[16];
+
+static void setup(void) {
+    fake_sdk_reset();
+    fake_advance_ms(1000);
+    sim_module_init(&sim, DEV_EUI);
+    sim_module_attach(&sim, &m, "sim");
+}
+
+// Poll once per millisecond until the probe ends, milliseconds taken
+static uint32_t run_probe(void) {
+    const uint32_t start = fake_now_ms();
+    modem_probe_start(&m, start);
+    probe_state_t state;
+    do {
+        fake_advance_ms(1);
+        const uint64_t before = time_us_64();
+        state = modem_probe_poll(&m, fake_now_ms());
+        CHECK(time_us_64() == before);
+    } while (state != PROBE_DONE && state != PROBE_FAILED && fake_now_ms() - start < 10000);
+    return fake_now_ms() - start;
+}
+
+static uint32_t run_uplink(uplink_state_t *result) {
+    const uint32_t start = fake_now_ms();
+    modem_uplink_start(&m, MSGHEX, downlink, sizeof(downlink), start);
+    CHECK(modem_busy(&m));
+    uplink_state_t state;
+    do {
+        fake_advance_ms(1);
+        const uint64_t before = time_us_64();
+        state = modem_uplink_poll(&m, fake_now_ms());
+        CHECK(time_us_64() == before);
+    } while (state == UPLINK_SENDING && fake_now_ms() - start < 20000);
+    *result = state;
+    m.uplink = UPLINK_IDLE;
+    return fake_now_ms() - start;
+}
+
+static void test_probe(void) {
+    setup();
+    const uint32_t ms = run_probe();
+    CHECK_EQ(m.state, PROBE_DONE);
+    CHECK(m.info.dev_eui == DEV_EUI);
+    CHECK_EQ(m.info.version, MODULE_VERSION(4, 0, 11));
+    CHECK_EQ(m.timeouts, 0);
+    // Three commands and answers at 9600 baud
+    CHECK(ms > 60 && ms < 150);
+}
+
+static void test_probe_absent(void) {
+    setup();
+    sim.fault = SIM_ABSENT;
+    const uint32_t ms = run_probe();
+    CHECK_EQ(m.state, PROBE_FAILED);
+    CHECK_EQ(m.failed_step, PROBE_CONNECT);
+    CHECK_EQ(m.timeouts, PROBE_AT_ATTEMPTS);
+    CHECK(ms >= PROBE_AT_ATTEMPTS * PROBE_TIMEOUT_MS && ms <= PROBE_AT_ATTEMPTS * PROBE_TIMEOUT_MS + 5);
+}
+
+static void test_uplink(void) {
+    setup();
+    uplink_state_t result;
+    const uint32_t ms = run_uplink(&result);
+    CHECK_EQ(result, UPLINK_SENT);
+    CHECK(strcmp(sim.last_cmd, "AT+MSGHEX=\"0102A0\"") == 0);
+    CHECK(!(m.dl.flags & DOWNLINK_HAS_PAYLOAD));
+    CHECK(ms >= sim.uplink_ms && ms < sim.uplink_ms + 100);
+    CHECK(!modem_busy(&m));
+}
+
+static void test_uplink_downlink(void) {
+    setup();
+    sim.downlink = "C0FFEE";
+    uplink_state_t result;
+    run_uplink(&result);
+    CHECK_EQ(result, UPLINK_SENT);
+    CHECK(m.dl.flags & DOWNLINK_HAS_PAYLOAD);
+    CHECK_EQ(m.dl.len, 3);
+    CHECK(memcmp(downlink, "\xC0\xFF\xEE", 3) == 0);
+    CHECK_EQ(m.dl.rssi, -106);
+}
+
+static void test_uplink_not_joined(void) {
+    setup();
+    sim.joined = false;
+    uplink_state_t result;
+    const uint32_t ms = run_uplink(&result);
+    CHECK_EQ(result, UPLINK_FAILED);
+    CHECK_EQ(m.timeouts, 0);
+    CHECK(ms < 100);
+}
+
+// No answer: the uplink fails after UPLINK_TIMEOUT_MS and the timeout is
+// counted for the recovery, while the caller kept polling every millisecond
+static void test_uplink_timeout(void) {
+    setup();
+    sim.fault = SIM_WEDGED;
+    uplink_state_t result;
+    const uint32_t ms = run_uplink(&result);
+    CHECK_EQ(result, UPLINK_FAILED);
+    CHECK_EQ(m.timeouts, 1);
+    CHECK_EQ(ms, UPLINK_TIMEOUT_MS);
+}
+
+// Each report restarts the wait, so a slow network is not a timeout
+static void test_uplink_slow_network(void) {
+    setup();
+    sim.uplink_ms = UPLINK_TIMEOUT_MS + 2000;
+    uplink_state_t result;
+    run_uplink(&result);
+    CHECK_EQ(result, UPLINK_FAILED);
+    setup();
+    sim.uplink_ms = UPLINK_TIMEOUT_MS - 500;
+    run_uplink(&result);
+    CHECK_EQ(result, UPLINK_SENT);
+}
+
+// The probe engine leaves the module alone while an uplink is in flight
+static void test_probe_ignores_uplink(void) {
+    setup();
+    modem_uplink_start(&m, MSGHEX, downlink, sizeof(downlink), fake_now_ms());
+    for (int i = 0; i < 100; i++) {
+        fake_advance_ms(1);
+        CHECK_EQ(modem_probe_poll(&m, fake_now_ms()), PROBE_IDLE);
+    }
+    uplink_state_t state;
+    do {
+        fake_advance_ms(1);
+        state = modem_uplink_poll(&m, fake_now_ms());
+    } while (state == UPLINK_SENDING);
+    CHECK_EQ(state, UPLINK_SENT);
+}
+
+static void test_uplink_abort(void) {
+    setup();
+    modem_uplink_start(&m, MSGHEX, downlink, sizeof(downlink), fake_now_ms());
+    fake_advance_ms(10);
+    modem_uplink_abort(&m);
+    CHECK(!modem_busy(&m));
+    CHECK_EQ(modem_uplink_poll(&m, fake_now_ms()), UPLINK_FAILED);
+}
+
+int main(void) {
+    RUN(test_probe);
+    RUN(test_probe_absent);
+    RUN(test_uplink);
+    RUN(test_uplink_downlink);
+    RUN(test_uplink_not_joined);
+    RUN(test_uplink_timeout);
+    RUN(test_uplink_slow_network);
+    RUN(test_probe_ignores_uplink);
+    RUN(test_uplink_abort);
+    return check_result();
+}
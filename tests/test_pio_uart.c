@@ -0,0 +1,269 @@
+#include <string.h>
+#include "check.h"
+#include "fake_sdk.h"
+#include "modem.h"
+#include "pio_model.h"
+#include "pio_uart.h"
+
+// pio_uart.c on the PIO/DMA model, running the programs of pio_uart.pio:
+// framing on the wire in both directions, line errors reaching the modem's
+// counter, clock tolerance, retuning after a clk_sys change, and the DMA ring.
+
+#define BAUD 9600
+#define CLK_SYS 125000000
+#define BIT (1.0 / BAUD)
+
+static pio_uart_t a, b, c;
+static uint8_t rx_data[1024];
+static size_t rx_len;
+static uint32_t rx_errors;
+static uint32_t rx_overruns;
+
+static void reset(void) {
+    fake_sdk_reset();
+    pio_model_reset(CLK_SYS);
+    rx_len = 0;
+    rx_errors = 0;
+    rx_overruns = 0;
+}
+
+// Everything the channel's DMA wrote since the last poll
+static void receive(pio_uart_t *ch) {
+    ring_t ring;
+    ring_init(&ring);
+    pio_uart_port.poll(ch, &ring, &rx_errors);
+    rx_overruns += ring.overruns;
+    uint8_t byte;
+    while (ring_get(&ring, &byte) && rx_len < sizeof(rx_data))
+        rx_data[rx_len++] = byte;
+}
+
+// Reference transmitter on an input pin, baud may be off by some percent
+static void send_frame(const uint32_t pin, const uint8_t byte, const double baud, const bool good_stop) {
+    pio_model_drive(pin, false);
+    pio_model_run(1 / baud);
+    for (int i = 0; i < 8; i++) {
+        pio_model_drive(pin, (byte >> i) & 1);
+        pio_model_run(1 / baud);
+    }
+    pio_model_drive(pin, good_stop);
+    pio_model_run(1 / baud);
+    if (!good_stop) {
+        pio_model_drive(pin, true);
+        pio_model_run(1 / baud);
+    }
+}
+
+static void send_string(const uint32_t pin, const char *s, const double baud) {
+    while (*s != '\0')
+        send_frame(pin, (uint8_t)*s++, baud, true);
+}
+
+// Reference receiver on an output pin: waits up to timeout for a start bit,
+// samples mid-bit, false when no frame started or the stop bit was low
+static bool sample_frame(const uint32_t pin, uint8_t *byte, const double timeout) {
+    const double step = BIT / 16;
+    for (double waited = 0; pio_model_pin(pin); waited += step) {
+        if (waited > timeout)
+            return false;
+        pio_model_run(step);
+    }
+    pio_model_run(BIT * 1.5);
+    *byte = 0;
+    for (int i = 0; i < 8; i++) {
+        *byte |= (uint8_t)(pio_model_pin(pin) << i);
+        pio_model_run(BIT);
+    }
+    const bool stop = pio_model_pin(pin);
+    pio_model_run(BIT / 2);
+    return stop;
+}
+
+// Two PIO blocks hold four channels (eight state machines); a fifth is refused
+static void test_claims(void) {
+    reset();
+    static pio_uart_t channels[5];
+    for (int i = 0; i < 4; i++)
+        CHECK(pio_uart_init(&channels[i], 2 * i + 2, 2 * i + 3, BAUD));
+    CHECK(channels[0].pio != channels[3].pio);
+    CHECK(!pio_uart_init(&channels[4], 20, 21, BAUD));
+}
+
+// TX output against the reference receiver: start bit, LSB first, stop bit, idle high
+static void test_tx_framing(void) {
+    reset();
+    CHECK(pio_uart_init(&c, 4, 5, BAUD));
+    CHECK(pio_model_pin(4));
+    const char out[] = "U\xA5\x01\x80";
+    pio_uart_port.write(&c, out, 4);
+    for (int i = 0; i < 4; i++) {
+        uint8_t byte = 0;
+        CHECK(sample_frame(4, &byte, 2 * BIT));
+        CHECK_EQ(byte, (uint8_t)out[i]);
+    }
+    pio_model_run(20 * BIT);
+    CHECK(pio_model_pin(4));
+}
+
+// Channels with crossed pins, both directions at once, past the end of the RX ring
+static void test_loopback(void) {
+    reset();
+    CHECK(pio_uart_init(&a, 2, 3, BAUD));
+    CHECK(pio_uart_init(&b, 3, 2, BAUD));
+    char out[512];
+    for (size_t i = 0; i < sizeof(out); i++)
+        out[i] = (char)(i * 7 + i / 256);
+    for (size_t i = 0; i < sizeof(out); i += 64) {
+        pio_uart_port.write(&a, &out[i], 64); // Waits for the previous chunk to leave the DMA
+        pio_uart_port.write(&b, "OK\r\n", 4);
+        receive(&b);
+    }
+    pio_model_run(80 * 10 * BIT); // Last chunk and what was still in the FIFO
+    receive(&b);
+    CHECK_EQ(rx_len, sizeof(out));
+    CHECK(memcmp(rx_data, out, sizeof(out)) == 0);
+    CHECK_EQ(rx_errors, 0);
+
+    rx_len = 0;
+    receive(&a);
+    CHECK_EQ(rx_len, 4 * 8);
+    CHECK(memcmp(rx_data, "OK\r\nOK\r\n", 8) == 0);
+    CHECK_EQ(a.framing_errors + b.framing_errors, 0);
+}
+
+// A bad stop bit drops the byte and counts in the modem, where recovery looks
+static void test_framing_error_reaches_modem(void) {
+    reset();
+    CHECK(pio_uart_init(&c, 4, 5, BAUD));
+    modem_t m;
+    modem_init(&m, "pio", &pio_uart_port, &c);
+    send_frame(5, 'A', BAUD, false);
+    send_string(5, "OK\r\n", BAUD);
+    pio_model_run(2 * BIT);
+    CHECK(modem_poll_line(&m));
+    CHECK(strcmp(m.line, "OK") == 0);
+    CHECK_EQ(m.framing_errors, 1);
+    CHECK_EQ(c.framing_errors, 1);
+}
+
+// A break (line held low) is one framing error, the next bytes come through intact
+static void test_break(void) {
+    reset();
+    CHECK(pio_uart_init(&c, 4, 5, BAUD));
+    modem_t m;
+    modem_init(&m, "pio", &pio_uart_port, &c);
+    pio_model_drive(5, false);
+    pio_model_run(0.02);
+    pio_model_drive(5, true);
+    pio_model_run(2 * BIT);
+    send_string(5, "OK\r\n", BAUD);
+    pio_model_run(2 * BIT);
+    CHECK(modem_poll_line(&m));
+    CHECK(strcmp(m.line, "OK") == 0);
+    CHECK_EQ(m.framing_errors, 1);
+    CHECK_EQ(m.garbled_lines, 0);
+}
+
+// Back-to-back frames from a transmitter whose clock is off by error, true when all arrived intact
+static bool clean_at(const double error) {
+    reset();
+    CHECK(pio_uart_init(&c, 4, 5, BAUD));
+    uint8_t out[64];
+    for (size_t i = 0; i < sizeof(out); i++) {
+        out[i] = (uint8_t)(i * 37 + 11);
+        send_frame(5, out[i], BAUD * (1 + error), true);
+    }
+    pio_model_run(2 * BIT);
+    receive(&c);
+    return rx_len == sizeof(out) && memcmp(rx_data, out, sizeof(out)) == 0 && rx_errors == 0;
+}
+
+// The receiver samples mid-bit and checks the stop bit 9.5 bits after the start
+// edge. A slow transmitter gets the most slack; a fast one gets less, because
+// back to back frames start before the program is waiting again and the lag
+// adds up over the burst. The LoRa-E5 is within 1 %.
+static void test_baud_tolerance(void) {
+    double slow = 0, fast = 0;
+    while (slow < 0.2 && clean_at(-(slow + 0.005)))
+        slow += 0.005;
+    while (fast < 0.2 && clean_at(fast + 0.005))
+        fast += 0.005;
+    printf("  clean from %.1f %% to +%.1f %% transmitter clock error\n", -slow * 100, fast * 100);
+    CHECK(slow >= 0.03);
+    CHECK(fast >= 0.02);
+    CHECK(!clean_at(0.08));
+    CHECK(!clean_at(-0.08));
+}
+
+// The dividers are set from clk_sys: after the clock changes the bytes are
+// garbage until pio_uart_retune() recomputes them
+static void test_retune(void) {
+    reset();
+    CHECK(pio_uart_init(&c, 4, 5, BAUD));
+    pio_model_set_clk_sys(48000000);
+    send_string(5, "OK\r\n", BAUD);
+    pio_model_run(2 * BIT);
+    receive(&c);
+    CHECK(rx_len != 4 || memcmp(rx_data, "OK\r\n", 4) != 0);
+
+    pio_uart_retune(&c);
+    rx_len = 0;
+    pio_model_run(20 * BIT);
+    receive(&c);
+    rx_len = 0;
+    send_string(5, "OK\r\n", BAUD);
+    pio_model_run(2 * BIT);
+    receive(&c);
+    CHECK_EQ(rx_len, 4);
+    CHECK(memcmp(rx_data, "OK\r\n", 4) == 0);
+}
+
+// Up to PIO_UART_RX_LEN - 1 bytes may arrive between polls (the modem ring
+// holds no more), across the wrap of the ring
+static void test_ring_wrap(void) {
+    reset();
+    CHECK(pio_uart_init(&c, 4, 5, BAUD));
+    uint8_t out[3 * (PIO_UART_RX_LEN - 1)];
+    for (size_t i = 0; i < sizeof(out); i++) {
+        out[i] = (uint8_t)(i ^ 0x5A);
+        send_frame(5, out[i], BAUD, true);
+        if ((i + 1) % (PIO_UART_RX_LEN - 1) == 0)
+            receive(&c);
+    }
+    CHECK_EQ(rx_len, sizeof(out));
+    CHECK(memcmp(rx_data, out, sizeof(out)) == 0);
+    CHECK_EQ(rx_overruns, 0);
+}
+
+// Polling stalls for more than a lap of the ring: what arrived meanwhile is
+// counted as overrun instead of handed on, and the next bytes come through
+static void test_ring_lap(void) {
+    reset();
+    CHECK(pio_uart_init(&c, 4, 5, BAUD));
+    const size_t stalled = PIO_UART_RX_LEN + 10;
+    for (size_t i = 0; i < stalled; i++)
+        send_frame(5, (uint8_t)('A' + i % 26), BAUD, true);
+    receive(&c);
+    CHECK_EQ(rx_len, 0);
+    CHECK_EQ(rx_overruns, stalled);
+    CHECK_EQ(c.overruns, stalled);
+
+    send_string(5, "OK\r\n", BAUD);
+    receive(&c);
+    CHECK_EQ(rx_len, 4);
+    CHECK(memcmp(rx_data, "OK\r\n", 4) == 0);
+    CHECK_EQ(rx_overruns, stalled);
+}
+
+int main(void) {
+    RUN(test_claims);
+    RUN(test_tx_framing);
+    RUN(test_loopback);
+    RUN(test_framing_error_reaches_modem);
+    RUN(test_break);
+    RUN(test_baud_tolerance);
+    RUN(test_retune);
+    RUN(test_ring_wrap);
+    RUN(test_ring_lap);
+    return check_result();
+}
@@ -0,0 +1,88 @@
+#include <string.h>
+#include "check.h"
+#include "pool.h"
+
+// pool.c: every block handed out once, release in any order, exhaustion and
+// high-water counters, and no block overlapping another.
+
+#define COUNT 4
+
+typedef struct {
+    char text[40];
+    uint8_t tag;
+} record_t;
+
+POOL_STORAGE(storage, record_t, COUNT);
+
+static void test_alloc_all(void) {
+    pool_t p;
+    pool_init(&p, "records", storage, sizeof(storage[0]), COUNT);
+    record_t *r[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        r[i] = pool_alloc(&p);
+        CHECK(r[i] != NULL);
+        memset(r[i], i + 1, sizeof(*r[i]));
+    }
+    CHECK(r[0] == &storage[0].object); // First block first
+    for (int i = 0; i < COUNT; i++)
+        CHECK_EQ(r[i]->tag, i + 1); // Writing one block left the others alone
+    CHECK(pool_alloc(&p) == NULL);
+    CHECK(pool_alloc(&p) == NULL);
+    CHECK_EQ(p.exhausted, 2);
+    CHECK_EQ(p.in_use, COUNT);
+    CHECK_EQ(p.high_water, COUNT);
+}
+
+// Released blocks come back last in, first out; the high-water mark stays
+static void test_free_reuse(void) {
+    pool_t p;
+    pool_init(&p, "records", storage, sizeof(storage[0]), COUNT);
+    record_t *a = pool_alloc(&p);
+    record_t *b = pool_alloc(&p);
+    record_t *c = pool_alloc(&p);
+    pool_free(&p, b);
+    pool_free(&p, a);
+    CHECK_EQ(p.in_use, 1);
+    CHECK(pool_alloc(&p) == a);
+    CHECK(pool_alloc(&p) == b);
+    pool_free(&p, NULL);
+    CHECK_EQ(p.in_use, 3);
+    CHECK_EQ(p.high_water, 3);
+    pool_free(&p, a);
+    pool_free(&p, b);
+    pool_free(&p, c);
+    CHECK_EQ(p.in_use, 0);
+    CHECK_EQ(p.high_water, 3);
+    CHECK_EQ(p.exhausted, 0);
+}
+
+// Many cycles of partial use never lose or duplicate a block
+static void test_churn(void) {
+    pool_t p;
+    pool_init(&p, "records", storage, sizeof(storage[0]), COUNT);
+    record_t *held[COUNT] = { 0 };
+    unsigned seed = 1;
+    for (int i = 0; i < 10000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const int slot = (int)((seed >> 16) % COUNT);
+        if (held[slot] == NULL) {
+            held[slot] = pool_alloc(&p);
+            CHECK(held[slot] != NULL);
+        } else {
+            pool_free(&p, held[slot]);
+            held[slot] = NULL;
+        }
+        for (int j = 0; j < COUNT; j++) {
+            for (int k = j + 1; k < COUNT; k++)
+                CHECK(held[j] == NULL || held[j] != held[k]);
+        }
+    }
+    CHECK_EQ(p.exhausted, 0);
+}
+
+int main(void) {
+    RUN(test_alloc_all);
+    RUN(test_free_reuse);
+    RUN(test_churn);
+    return check_result();
+}
@@ -0,0 +1,198 @@
+#include <string.h>
+#include "check.h"
+#include "power.h"
+
+// The dormant-mode sequencing of power.c on a model chip behind power_ops_t:
+// going dormant runs everything from the crystal and leaves the UART dividers
+// wrong, the wake-up takes a while to restore them, and the timer stands still
+// in between as it does on the RP2040.
+
+#define QUIET_MS 5000
+#define SYS_HZ 125000000
+#define XOSC_HZ 12000000
+#define RESTORE_US 1800 // PLL lock and UART setup on wake-up
+#define SW_0 9
+#define UART1_RX 5
+
+typedef struct {
+    uint64_t now_us;
+    uint32_t sys_hz;
+    uint32_t uart_baud[POWER_UARTS]; // As the UARTs currently run, 0 when disabled
+    uint32_t restore_us; // Time the next restore takes
+    // What the sequencing did
+    char trace[16];
+    int steps;
+    uint32_t pins[POWER_MAX_WAKE_PINS];
+    size_t pin_count;
+} chip_t;
+
+static chip_t chip;
+static power_t power;
+
+static void step(const char what) {
+    if (chip.steps < (int)sizeof(chip.trace) - 1)
+        chip.trace[chip.steps++] = what;
+}
+
+static void chip_save(void *ctx, power_state_t *state) {
+    chip_t *c = ctx;
+    step('s');
+    state->sys_hz = c->sys_hz;
+    memcpy(state->uart_baud, c->uart_baud, sizeof(state->uart_baud));
+}
+
+// The UART dividers stay as they were for clk_peri at sys_hz
+static void chip_dormant(void *ctx, const uint32_t *wake_pins, const size_t count) {
+    chip_t *c = ctx;
+    step('d');
+    memcpy(c->pins, wake_pins, count * sizeof(*wake_pins));
+    c->pin_count = count;
+    for (int i = 0; i < POWER_UARTS; i++)
+        c->uart_baud[i] = (uint32_t)((uint64_t)c->uart_baud[i] * XOSC_HZ / c->sys_hz);
+    c->sys_hz = XOSC_HZ;
+}
+
+static void chip_restore(void *ctx, const power_state_t *state) {
+    chip_t *c = ctx;
+    step('r');
+    c->now_us += c->restore_us;
+    c->sys_hz = state->sys_hz;
+    memcpy(c->uart_baud, state->uart_baud, sizeof(c->uart_baud));
+}
+
+static uint64_t chip_now_us(void *ctx) {
+    return ((chip_t *)ctx)->now_us;
+}
+
+static const power_ops_t ops = {
+    .save = chip_save,
+    .dormant = chip_dormant,
+    .restore = chip_restore,
+    .now_us = chip_now_us,
+    .ctx = &chip
+};
+
+static void setup(void) {
+    memset(&chip, 0, sizeof(chip));
+    chip.now_us = 1000000;
+    chip.sys_hz = SYS_HZ;
+    chip.uart_baud[0] = 115200; // stdio
+    chip.uart_baud[1] = 9600; // Module
+    chip.restore_us = RESTORE_US;
+    power_init(&power, &ops, QUIET_MS);
+    CHECK(power_add_wake_pin(&power, SW_0));
+    CHECK(power_add_wake_pin(&power, UART1_RX));
+}
+
+static void advance_ms(const uint32_t ms) {
+    chip.now_us += (uint64_t)ms * 1000;
+}
+
+// Not before the quiet period is over, and any activity starts it again
+static void test_quiet_period(void) {
+    setup();
+    advance_ms(QUIET_MS - 1);
+    CHECK(!power_idle(&power, false));
+    power_activity(&power);
+    advance_ms(QUIET_MS - 1);
+    CHECK(!power_idle(&power, false));
+    CHECK_EQ(chip.steps, 0);
+    advance_ms(1);
+    CHECK(power_idle(&power, false));
+    CHECK_EQ(power.sleeps, 1);
+}
+
+// Save, sleep on the wake pins, restore: clocks and both UARTs are back as they were
+static void test_sleep_restores(void) {
+    setup();
+    advance_ms(QUIET_MS);
+    CHECK(power_idle(&power, false));
+    CHECK(strcmp(chip.trace, "sdr") == 0);
+    CHECK_EQ(chip.pin_count, 2);
+    CHECK_EQ(chip.pins[0], SW_0);
+    CHECK_EQ(chip.pins[1], UART1_RX);
+    CHECK_EQ(chip.sys_hz, SYS_HZ);
+    CHECK_EQ(chip.uart_baud[0], 115200);
+    CHECK_EQ(chip.uart_baud[1], 9600);
+}
+
+// A UART that was off before sleeping stays off
+static void test_disabled_uart(void) {
+    setup();
+    chip.uart_baud[0] = 0;
+    advance_ms(QUIET_MS);
+    CHECK(power_idle(&power, false));
+    CHECK_EQ(chip.uart_baud[0], 0);
+    CHECK_EQ(power.saved.uart_baud[0], 0);
+    CHECK_EQ(chip.uart_baud[1], 9600);
+}
+
+// Wake-to-ready is the time the restore took, the worst one is kept, and the
+// quiet period starts over once ready
+static void test_wake_latency(void) {
+    setup();
+    advance_ms(QUIET_MS);
+    CHECK(power_idle(&power, false));
+    CHECK_EQ(power.last_wake_us, RESTORE_US);
+    CHECK_EQ(power.max_wake_us, RESTORE_US);
+
+    CHECK(!power_idle(&power, false));
+    advance_ms(QUIET_MS);
+    chip.restore_us = 700;
+    CHECK(power_idle(&power, false));
+    CHECK_EQ(power.sleeps, 2);
+    CHECK_EQ(power.last_wake_us, 700);
+    CHECK_EQ(power.max_wake_us, RESTORE_US);
+}
+
+// An uplink that failed waits 30 s for its retry, much longer than the quiet
+// period. The idle handler in main.c reports it as waiting, so the chip stays
+// awake until the retry has gone out and only sleeps a quiet period after that
+#define RETRY_MS 30000
+
+static void test_waiting_keeps_awake(void) {
+    setup();
+    uint32_t pending = 1;
+    uint32_t retried_at = 0;
+    for (uint32_t ms = 1; ms <= RETRY_MS + 2 * QUIET_MS && chip.steps == 0; ms++) {
+        advance_ms(1);
+        if (pending > 0 && ms == RETRY_MS) {
+            pending--;
+            retried_at = ms;
+        }
+        power_idle(&power, pending > 0);
+    }
+    CHECK_EQ(retried_at, RETRY_MS);
+    CHECK_EQ(power.sleeps, 1);
+    // The quiet period runs from the last millisecond the retry was still waiting
+    CHECK_EQ(chip.now_us, 1000000 + (uint64_t)(RETRY_MS - 1 + QUIET_MS) * 1000 + RESTORE_US);
+
+    // A module response in flight past the quiet period, the same
+    advance_ms(QUIET_MS + 100);
+    CHECK(!power_idle(&power, true));
+    advance_ms(QUIET_MS - 1);
+    CHECK(!power_idle(&power, false));
+    advance_ms(1);
+    CHECK(power_idle(&power, false));
+    CHECK_EQ(power.sleeps, 2);
+}
+
+static void test_wake_pin_limit(void) {
+    setup();
+    for (uint32_t pin = 0; pin < POWER_MAX_WAKE_PINS - 2; pin++)
+        CHECK(power_add_wake_pin(&power, 10 + pin));
+    CHECK(!power_add_wake_pin(&power, 20));
+    advance_ms(QUIET_MS);
+    CHECK(power_idle(&power, false));
+    CHECK_EQ(chip.pin_count, POWER_MAX_WAKE_PINS);
+}
+
+int main(void) {
+    RUN(test_quiet_period);
+    RUN(test_sleep_restores);
+    RUN(test_disabled_uart);
+    RUN(test_wake_latency);
+    RUN(test_waiting_keeps_awake);
+    RUN(test_wake_pin_limit);
+    return check_result();
+}
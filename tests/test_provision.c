@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include "check.h"
+#include "fake_sdk.h"
+#include "provision.h"
+#include "sim_module.h"
+
+// Production-line provisioning (provision.c) on simulated modules driven the
+// way poll_modems() in main.c does. Boards are plugged in and pulled out by
+// switching the simulated module between absent and a fresh healthy one:
+// attach is seen from a ping answer or the boot banner, the probe follows,
+// and a board that stops answering pings is counted as removed.
+
+#define SLOTS 2
+#define DEV_EUI 0x2CF7F12032300000ull
+#define PRESENCE_PIN 14
+#define SWAP_MS 2000 // Operator takes a board out and puts the next one in
+#define BANNER_LEN 29 // "+AT: LoRaWAN modem is ready\r\n"
+
+static sim_module_t sims[SLOTS];
+static modem_t modems[SLOTS];
+static int probes_started[SLOTS];
+static uint64_t next_dev_eui;
+
+static void setup(void) {
+    static const char *const names[SLOTS] = { "uart1", "uart0" };
+    fake_sdk_reset();
+    fake_advance_ms(1000);
+    next_dev_eui = DEV_EUI;
+    for (int i = 0; i < SLOTS; i++) {
+        sim_module_init(&sims[i], 0);
+        sims[i].fault = SIM_ABSENT;
+        sim_module_attach(&sims[i], &modems[i], names[i]);
+        probes_started[i] = 0;
+    }
+    provision_init(modems, SLOTS);
+    provision_enable(true, fake_now_ms());
+}
+
+// A new board in slot i: powered up now, ready boot_ms later
+static void plug(const int i, const bool banner, const uint32_t boot_ms) {
+    sim_module_init(&sims[i], next_dev_eui++);
+    sims[i].banner = banner;
+    sims[i].boot_ms = boot_ms;
+    sim_module_reset(&sims[i], true);
+    sim_module_reset(&sims[i], false);
+    sims[i].resets = 0;
+}
+
+static void unplug(const int i) {
+    sims[i].fault = SIM_ABSENT;
+    sims[i].out_len = 0;
+}
+
+// One pass of the module poller, as in main.c
+static void poll_all(const uint32_t now) {
+    provision_poll(now);
+    for (int i = 0; i < SLOTS; i++) {
+        modem_t *m = &modems[i];
+        const bool was_idle = m->state == PROBE_IDLE;
+        const probe_state_t state = modem_probe_poll(m, now);
+        if (state == PROBE_DONE || state == PROBE_FAILED) {
+            provision_probe_finished(i, now);
+            m->state = PROBE_IDLE;
+        }
+        else if (state == PROBE_IDLE) {
+            while (modem_poll_line(m))
+                provision_line(i, m->line, now);
+        }
+        if (was_idle && m->state != PROBE_IDLE)
+            probes_started[i]++;
+    }
+}
+
+static void run_ms(const uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        fake_advance_ms(1);
+        poll_all(fake_now_ms());
+    }
+}
+
+// Until slot i is in state, false after timeout_ms
+static bool run_until(const int i, const provision_state_t state, const uint32_t timeout_ms) {
+    const uint32_t start = fake_now_ms();
+    while (fake_now_ms() - start < timeout_ms) {
+        fake_advance_ms(1);
+        poll_all(fake_now_ms());
+        if (provision_slot_state(i) == state)
+            return true;
+    }
+    return false;
+}
+
+// Nothing attached: the slots are pinged and stay waiting
+static void test_empty(void) {
+    setup();
+    run_ms(3 * PROVISION_PING_MS);
+    for (int i = 0; i < SLOTS; i++) {
+        CHECK_EQ(provision_slot_state(i), PROVISION_WAITING);
+        CHECK_EQ(probes_started[i], 0);
+    }
+    CHECK_EQ(provision_stats()->devices, 0);
+}
+
+// A board without a banner is found by its answer to the next ping
+static void test_attach_by_ping(void) {
+    setup();
+    run_ms(10);
+    plug(0, false, 100);
+    const uint32_t plugged = fake_now_ms();
+    CHECK(run_until(0, PROVISION_PROBING, 2 * PROVISION_PING_MS + 200));
+    const uint32_t found_ms = fake_now_ms() - plugged;
+    // The first ping after the boot, then "AT\r\n" out and "+AT: OK\r\n" back
+    CHECK(found_ms >= 100 && found_ms <= 100 + PROVISION_PING_MS + 20);
+    CHECK(run_until(0, PROVISION_PRESENT, 1000));
+    CHECK(modems[0].info.dev_eui == DEV_EUI);
+    CHECK_EQ(provision_stats()->devices, 1);
+    CHECK_EQ(probes_started[0], 1);
+    CHECK_EQ(provision_slot_state(1), PROVISION_WAITING);
+}
+
+// A board with a banner is found as soon as the banner line is in, even when
+// it takes longer to boot than the ping period
+static void test_attach_by_banner(void) {
+    setup();
+    run_ms(10);
+    plug(1, true, 3 * PROVISION_PING_MS);
+    const uint32_t plugged = fake_now_ms();
+    CHECK(run_until(1, PROVISION_PROBING, 2000));
+    const uint32_t found_ms = fake_now_ms() - plugged;
+    const uint32_t banner_ms = 3 * PROVISION_PING_MS + BANNER_LEN * SIM_BYTE_US / 1000;
+    // Unless a ping went out just before the banner, whose answer is then waited for
+    CHECK(found_ms >= banner_ms && found_ms <= banner_ms + PROVISION_ANSWER_MS);
+    CHECK(run_until(1, PROVISION_PRESENT, 1000));
+    CHECK(modems[1].info.dev_eui == DEV_EUI);
+    CHECK_EQ(provision_stats()->failures, 0);
+}
+
+// A present board answers every ping; once it is gone it is counted as removed
+// after PROVISION_DETACH_MISSES unanswered pings, and the slot takes the next one
+static void test_detach_and_reattach(void) {
+    setup();
+    plug(0, true, 150);
+    CHECK(run_until(0, PROVISION_PRESENT, 2000));
+    run_ms(10 * PROVISION_PING_MS);
+    CHECK_EQ(provision_slot_state(0), PROVISION_PRESENT);
+    CHECK_EQ(probes_started[0], 1);
+
+    unplug(0);
+    const uint32_t pulled = fake_now_ms();
+    CHECK(run_until(0, PROVISION_WAITING, 2000));
+    const uint32_t detach_ms = fake_now_ms() - pulled;
+    CHECK(detach_ms > PROVISION_DETACH_MISSES * PROVISION_PING_MS);
+    CHECK(detach_ms <= (PROVISION_DETACH_MISSES + 1) * PROVISION_PING_MS + 1);
+
+    plug(0, true, 150);
+    CHECK(run_until(0, PROVISION_PRESENT, 2000));
+    CHECK(modems[0].info.dev_eui == DEV_EUI + 1);
+    CHECK_EQ(probes_started[0], 2);
+    CHECK_EQ(provision_stats()->devices, 2);
+}
+
+// With a presence switch the slot follows the pin instead of pinging
+static void test_presence_pin(void) {
+    setup();
+    provision_set_presence_pin(0, PRESENCE_PIN);
+    plug(0, false, 100);
+    run_ms(2000);
+    CHECK_EQ(provision_slot_state(0), PROVISION_WAITING);
+    CHECK_EQ(sims[0].commands, 0);
+    fake_gpio_drive(PRESENCE_PIN, false);
+    CHECK(run_until(0, PROVISION_PROBING, 2));
+    CHECK(run_until(0, PROVISION_PRESENT, 1000));
+    fake_gpio_drive(PRESENCE_PIN, true);
+    CHECK(run_until(0, PROVISION_WAITING, 2));
+}
+
+// A shift at the jig: both slots, a new board SWAP_MS after the previous one
+// was removed. Reports devices per hour and the average time of each probe step
+static void test_throughput(void) {
+    setup();
+    const int boards = 10;
+    int plugged = 0;
+    for (int i = 0; i < SLOTS; i++, plugged++)
+        plug(i, true, 150);
+    bool gone[SLOTS] = { false, false };
+    uint32_t pulled_at[SLOTS] = { 0, 0 };
+    while (provision_stats()->devices < (uint32_t)boards && fake_now_ms() < 600000) {
+        run_ms(1);
+        for (int i = 0; i < SLOTS; i++) {
+            if (!gone[i] && provision_slot_state(i) == PROVISION_PRESENT) {
+                unplug(i);
+                gone[i] = true;
+                pulled_at[i] = fake_now_ms();
+            }
+            else if (gone[i] && fake_now_ms() - pulled_at[i] >= SWAP_MS && plugged < boards) {
+                plug(i, true, 150);
+                gone[i] = false;
+                plugged++;
+            }
+        }
+    }
+    const provision_stats_t *stats = provision_stats();
+    CHECK_EQ(stats->devices, boards);
+    CHECK_EQ(stats->failures, 0);
+    const uint32_t elapsed_ms = fake_now_ms() - stats->started_ms;
+    const uint32_t per_hour = (uint32_t)((uint64_t)stats->devices * 3600000 / elapsed_ms);
+    uint32_t avg_ms[PROBE_STEPS];
+    for (int s = 0; s < PROBE_STEPS; s++) {
+        avg_ms[s] = (uint32_t)(stats->step_total_ms[s] / stats->devices);
+        // A command and its answer at 9600 baud
+        CHECK(avg_ms[s] >= 10 && avg_ms[s] <= 60);
+    }
+    printf("  %u devices in %u ms on %d slots, %u devices/hour, avg AT %u, VER %u, DevEui %u ms\n",
+        (unsigned)stats->devices, (unsigned)elapsed_ms, SLOTS, (unsigned)per_hour, (unsigned)avg_ms[0],
+        (unsigned)avg_ms[1], (unsigned)avg_ms[2]);
+    // Swap time dominates: per slot a swap between boards, each board boots,
+    // sends its banner and is probed in well under half a second
+    const uint32_t per_slot = boards / SLOTS;
+    CHECK(elapsed_ms >= (per_slot - 1) * SWAP_MS);
+    CHECK(elapsed_ms <= (per_slot - 1) * SWAP_MS + per_slot * 500);
+}
+
+int main(void) {
+    RUN(test_empty);
+    RUN(test_attach_by_ping);
+    RUN(test_attach_by_banner);
+    RUN(test_detach_and_reattach);
+    RUN(test_presence_pin);
+    RUN(test_throughput);
+    return check_result();
+}
@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+#include "fake_sdk.h"
+#include "recovery.h"
+#include "sim_module.h"
+
+// Fault recovery (recovery.c) on every module of a multi-module board: the
+// simulated modules are wedged, garble their answers, see line breaks or are
+// dead, and are driven the way poll_modems() in main.c does, one recovery_t
+// per module with the simulator's reset line behind recovery_ops_t. Each
+// scenario reports its time to recovery.
+
+#define MODULES 3
+#define DEV_EUI 0x2CF7F1203230A570ull
+#define RUN_MS 20000
+#define NO_RESULT (-1)
+
+static sim_module_t sims[MODULES];
+static modem_t modems[MODULES];
+static recovery_t recovery[MODULES];
+static recovery_ops_t ops[MODULES];
+static int result[MODULES]; // Probe state the module finished with, NO_RESULT while running
+static recovery_event_t last_event[MODULES]; // Latest event other than RECOVERY_NONE
+static uint32_t ttr_total;
+static int ttr_count;
+
+static void sim_reset(void *ctx, const bool asserted) {
+    sim_module_reset(ctx, asserted);
+}
+
+static void setup(void) {
+    static const char *const names[MODULES] = { "uart1", "pio-a", "pio-b" };
+    fake_sdk_reset();
+    fake_advance_ms(1000);
+    for (int i = 0; i < MODULES; i++) {
+        sim_module_init(&sims[i], DEV_EUI + (uint64_t)i);
+        sims[i].resets_to_heal = 1;
+        sim_module_attach(&sims[i], &modems[i], names[i]);
+        ops[i] = (recovery_ops_t){ .reset = sim_reset, .ctx = &sims[i] };
+        recovery_init(&recovery[i], &modems[i], &ops[i]);
+        result[i] = NO_RESULT;
+        last_event[i] = RECOVERY_NONE;
+    }
+}
+
+static void note(const int i, const recovery_event_t event) {
+    if (event != RECOVERY_NONE)
+        last_event[i] = event;
+}
+
+// One pass of the module poller, as in main.c
+static void poll_all(const uint32_t now) {
+    for (int i = 0; i < MODULES; i++) {
+        modem_t *m = &modems[i];
+        note(i, recovery_poll(&recovery[i], now));
+        if (recovery_busy(&recovery[i]))
+            continue;
+        const probe_state_t state = modem_probe_poll(m, now);
+        if (state == PROBE_DONE || state == PROBE_FAILED) {
+            const recovery_event_t event = recovery_probe_finished(&recovery[i], now);
+            note(i, event);
+            m->state = PROBE_IDLE;
+            if (event != RECOVERY_RETRY)
+                result[i] = state;
+        }
+        else if (!modem_busy(m) && !m->claimed) {
+            while (modem_poll_line(m)) {}
+        }
+    }
+}
+
+// Until every module in mask has a result, milliseconds taken
+static uint32_t run(const unsigned mask) {
+    const uint32_t start = fake_now_ms();
+    while (fake_now_ms() - start < RUN_MS) {
+        poll_all(fake_now_ms());
+        bool all = true;
+        for (int i = 0; i < MODULES; i++)
+            all &= !(mask & (1u << i)) || result[i] != NO_RESULT;
+        if (all)
+            break;
+        fake_advance_ms(1);
+    }
+    return fake_now_ms() - start;
+}
+
+static void probe_all(void) {
+    for (int i = 0; i < MODULES; i++)
+        modem_probe_start(&modems[i], fake_now_ms());
+}
+
+// Module i came back with its identity after resets resets, the others were left alone
+static void check_recovered(const int i, const recovery_fault_t fault, const uint8_t resets) {
+    const recovery_t *r = &recovery[i];
+    CHECK_EQ(result[i], PROBE_DONE);
+    CHECK(modems[i].info.dev_eui == DEV_EUI + (uint64_t)i);
+    CHECK_EQ(last_event[i], RECOVERY_DONE);
+    CHECK_EQ(r->fault, fault);
+    CHECK_EQ(r->recoveries, 1);
+    CHECK_EQ(r->resets, resets);
+    CHECK_EQ(sims[i].resets, resets);
+    CHECK(!modems[i].claimed);
+    // Reset pulses, boots and the probe, with a ping period of slack per boot
+    const uint32_t boots = resets * (RECOVERY_RESET_MS + sims[i].boot_ms + RECOVERY_PING_MS);
+    CHECK(r->last_ms >= resets * (RECOVERY_RESET_MS + sims[i].boot_ms));
+    CHECK(r->last_ms <= boots + (resets - 1u) * RECOVERY_BOOT_MS + 200);
+    printf("  %s: recovered from %s in %u ms with %u resets\n", modems[i].name, recovery_fault_name(r->fault),
+        (unsigned)r->last_ms, (unsigned)r->resets);
+    ttr_total += r->last_ms;
+    ttr_count++;
+    for (int j = 0; j < MODULES; j++) {
+        if (j != i) {
+            CHECK_EQ(recovery[j].recoveries, 0);
+            CHECK_EQ(sims[j].resets, 0);
+        }
+    }
+}
+
+static void test_healthy(void) {
+    setup();
+    probe_all();
+    run(0x7);
+    for (int i = 0; i < MODULES; i++) {
+        CHECK_EQ(result[i], PROBE_DONE);
+        CHECK_EQ(last_event[i], RECOVERY_NONE);
+        CHECK_EQ(sims[i].resets, 0);
+    }
+}
+
+// A module that stops answering in the middle of the probe is reset and probed
+// again, the probes on the other modules go on
+static void wedged(const int i, const bool banner, const uint32_t boot_ms, const uint8_t resets) {
+    setup();
+    sims[i].fault = SIM_WEDGED;
+    sims[i].banner = banner;
+    sims[i].boot_ms = boot_ms;
+    sims[i].resets_to_heal = resets;
+    probe_all();
+    run(0x7);
+    check_recovered(i, RECOVERY_FAULT_TIMEOUT, resets);
+    for (int j = 0; j < MODULES; j++)
+        CHECK_EQ(result[j], PROBE_DONE);
+}
+
+static void test_wedged(void) {
+    for (int i = 0; i < MODULES; i++)
+        wedged(i, true, 150, 1);
+}
+
+// Without a banner the recovery pings until the module answers
+static void test_wedged_no_banner(void) {
+    wedged(1, false, 150, 1);
+}
+
+static void test_slow_boot(void) {
+    wedged(2, true, 600, 1);
+}
+
+static void test_two_resets(void) {
+    wedged(0, true, 150, 2);
+}
+
+static void test_garbled_answers(void) {
+    setup();
+    sims[1].fault = SIM_GARBLING;
+    probe_all();
+    run(0x7);
+    check_recovered(1, RECOVERY_FAULT_GARBLED, 1);
+}
+
+// Noise while nobody talks to the module: the recovery starts its own probe
+static void test_garbled_idle(void) {
+    setup();
+    for (int i = 0; i < 3; i++)
+        sim_module_say(&sims[2], "\xfe\x80 garbage\r\n", 30 * (uint32_t)i);
+    run(1u << 2);
+    check_recovered(2, RECOVERY_FAULT_GARBLED, 1);
+}
+
+static void test_line_breaks(void) {
+    setup();
+    sims[0].fault = SIM_BREAKS;
+    run(1u << 0);
+    check_recovered(0, RECOVERY_FAULT_FRAMING, 1);
+}
+
+// Two modules fail at once and are recovered side by side
+static void test_two_modules(void) {
+    setup();
+    sims[0].fault = SIM_WEDGED;
+    sims[2].fault = SIM_GARBLING;
+    probe_all();
+    run(0x7);
+    for (int i = 0; i < MODULES; i++)
+        CHECK_EQ(result[i], PROBE_DONE);
+    CHECK_EQ(recovery[0].recoveries, 1);
+    CHECK_EQ(recovery[0].fault, RECOVERY_FAULT_TIMEOUT);
+    CHECK_EQ(recovery[1].recoveries, 0);
+    CHECK_EQ(recovery[2].recoveries, 1);
+    CHECK_EQ(recovery[2].fault, RECOVERY_FAULT_GARBLED);
+    CHECK_EQ(sims[1].resets, 0);
+}
+
+// A module that never comes back is given up after RECOVERY_MAX_RESETS, its
+// probe fails and the module is free again
+static void test_dead(void) {
+    setup();
+    sims[1].fault = SIM_WEDGED;
+    sims[1].resets_to_heal = 0;
+    sims[1].banner = false;
+    probe_all();
+    run(0x7);
+    CHECK_EQ(result[1], PROBE_FAILED);
+    CHECK_EQ(last_event[1], RECOVERY_GAVE_UP);
+    CHECK_EQ(recovery[1].failures, 1);
+    CHECK_EQ(recovery[1].recoveries, 0);
+    CHECK_EQ(sims[1].resets, RECOVERY_MAX_RESETS);
+    CHECK(!modems[1].claimed);
+    CHECK_EQ(result[0], PROBE_DONE);
+    CHECK_EQ(result[2], PROBE_DONE);
+}
+
+// Forced from the console on one module
+static void test_requested(void) {
+    setup();
+    recovery_request(&recovery[1]);
+    run(1u << 1);
+    check_recovered(1, RECOVERY_FAULT_REQUESTED, 1);
+}
+
+int main(void) {
+    RUN(test_healthy);
+    RUN(test_wedged);
+    RUN(test_wedged_no_banner);
+    RUN(test_slow_boot);
+    RUN(test_two_resets);
+    RUN(test_garbled_answers);
+    RUN(test_garbled_idle);
+    RUN(test_line_breaks);
+    RUN(test_two_modules);
+    RUN(test_dead);
+    RUN(test_requested);
+    if (ttr_count > 0)
+        printf("Mean time to recovery %u ms over %d recoveries\n", (unsigned)(ttr_total / ttr_count), ttr_count);
+    return check_result();
+}
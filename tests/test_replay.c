@@ -0,0 +1,175 @@
+#include <string.h>
+#include "capture.h"
+#include "check.h"
+#include "fake_sdk.h"
+#include "modem.h"
+#include "replay.h"
+
+// Capture playback (replay.c): responses wait for the commands they answer
+// and for their recorded gaps, scaled by the speed, and the identity probe
+// run against a replayed conversation takes the captured time.
+
+#define MS 1000ull
+#define RESPONSE_MS 80 // Module answer time in the probe conversation
+
+static uint8_t log_buf[512];
+static capture_t capture;
+static replay_t replay;
+static ring_t rx;
+
+// Records at the given times in ms, TX for commands and RX for what the module sent
+static void record(const uint8_t direction, const uint32_t at_ms, const char *text) {
+    CHECK(capture_add(&capture, direction, at_ms * MS, (const uint8_t *)text, strlen(text)));
+}
+
+// The firmware sends "AT" at 0, the module answers at 20 ms and reports
+// something on its own 500 ms after that; "AT+VER" at 1000 ms is answered 15 ms later
+static void conversation(const uint32_t speed_pct) {
+    capture_init(&capture, log_buf, sizeof(log_buf));
+    capture_start(&capture, 0);
+    record(CAPTURE_TX, 0, "AT\r\n");
+    record(CAPTURE_RX, 20, "+AT: OK\r\n");
+    record(CAPTURE_RX, 520, "+EVENT\r\n");
+    record(CAPTURE_TX, 1000, "AT+VER\r\n");
+    record(CAPTURE_RX, 1015, "+VER: 4.0.11\r\n");
+    replay_init(&replay, capture.buf, capture.len, speed_pct);
+    ring_init(&rx);
+}
+
+// Bytes released by now_ms
+static size_t poll_at(const uint64_t now_ms) {
+    return replay_poll(&replay, &rx, now_ms * MS);
+}
+
+static void test_realtime(void) {
+    conversation(REPLAY_REALTIME);
+    CHECK_EQ(poll_at(0), 0);
+    replay_write(&replay, 4); // "AT" at 5 ms, the answer is due 20 ms later
+    CHECK_EQ(poll_at(5), 0);
+    CHECK_EQ(poll_at(24), 0);
+    CHECK_EQ(poll_at(25), strlen("+AT: OK\r\n"));
+    CHECK_EQ(poll_at(524), 0);
+    CHECK_EQ(poll_at(525), strlen("+EVENT\r\n"));
+    replay_write(&replay, 8);
+    CHECK_EQ(poll_at(900), 0);
+    CHECK_EQ(poll_at(914), 0);
+    CHECK_EQ(poll_at(915), strlen("+VER: 4.0.11\r\n"));
+    CHECK(replay_done(&replay));
+}
+
+// The gaps are divided by the speed: ten times as fast, then half as fast
+static void test_speed(void) {
+    conversation(10 * REPLAY_REALTIME);
+    replay_write(&replay, 4);
+    CHECK_EQ(poll_at(0), 0);
+    CHECK_EQ(poll_at(2), strlen("+AT: OK\r\n"));
+    CHECK_EQ(poll_at(51), 0);
+    CHECK_EQ(poll_at(52), strlen("+EVENT\r\n"));
+
+    conversation(REPLAY_REALTIME / 2);
+    replay_write(&replay, 4);
+    CHECK_EQ(poll_at(0), 0);
+    CHECK_EQ(poll_at(39), 0);
+    CHECK_EQ(poll_at(40), strlen("+AT: OK\r\n"));
+    CHECK_EQ(poll_at(1039), 0);
+    CHECK_EQ(poll_at(1040), strlen("+EVENT\r\n"));
+}
+
+// Without delays whatever the firmware has asked for goes at once
+static void test_no_delay(void) {
+    conversation(REPLAY_NO_DELAY);
+    replay_write(&replay, 4);
+    CHECK_EQ(poll_at(0), strlen("+AT: OK\r\n") + strlen("+EVENT\r\n"));
+    replay_write(&replay, 8);
+    CHECK_EQ(poll_at(0), strlen("+VER: 4.0.11\r\n"));
+    CHECK(replay_done(&replay));
+}
+
+// However much time passes, a response never runs ahead of its command
+static void test_waits_for_command(void) {
+    conversation(REPLAY_REALTIME);
+    CHECK_EQ(poll_at(10000), 0);
+    replay_write(&replay, 2); // Half of "AT\r\n"
+    CHECK_EQ(poll_at(20000), 0);
+    replay_write(&replay, 2);
+    CHECK_EQ(poll_at(20000), 0);
+    CHECK_EQ(poll_at(20019), 0);
+    CHECK_EQ(poll_at(20020), strlen("+AT: OK\r\n"));
+}
+
+// A record the ring cannot take at once is finished at the next poll, without waiting again
+static void test_full_ring(void) {
+    char line[RING_SIZE + 100];
+    memset(line, 'x', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    capture_init(&capture, log_buf, sizeof(log_buf));
+    capture_start(&capture, 0);
+    record(CAPTURE_RX, 100, line);
+    replay_init(&replay, capture.buf, capture.len, REPLAY_REALTIME);
+    ring_init(&rx);
+    CHECK_EQ(poll_at(0), 0);
+    CHECK_EQ(poll_at(99), 0);
+    CHECK_EQ(poll_at(100), RING_SIZE - 1);
+    uint8_t byte;
+    while (ring_get(&rx, &byte)) {}
+    CHECK_EQ(poll_at(100), sizeof(line) - RING_SIZE);
+    CHECK(replay_done(&replay));
+}
+
+// Replay port for the module driver, on the fake SDK's clock
+static void port_write(void *hw, const char *data, const size_t len) {
+    (void)data;
+    replay_write(hw, len);
+}
+
+static void port_poll(void *hw, ring_t *ring, uint32_t *framing_errors) {
+    (void)framing_errors;
+    replay_poll(hw, ring, time_us_64());
+}
+
+static const modem_port_t replay_port = { .write = port_write, .poll = port_poll };
+
+// The probe against a captured conversation, milliseconds it took
+static uint32_t probe(const uint32_t speed_pct) {
+    capture_init(&capture, log_buf, sizeof(log_buf));
+    capture_start(&capture, 0);
+    static const char *const exchange[] = {
+        "AT\r\n", "+AT: OK\r\n",
+        "AT+VER\r\n", "+VER: 4.0.11\r\n",
+        "AT+ID=DevEui\r\n", "+ID: DevEui, 2C:F7:F1:20:32:30:A5:70\r\n",
+    };
+    for (int i = 0; i < 6; i += 2) {
+        record(CAPTURE_TX, (uint32_t)i * 1000, exchange[i]);
+        record(CAPTURE_RX, (uint32_t)i * 1000 + RESPONSE_MS, exchange[i + 1]);
+    }
+    fake_sdk_reset();
+    replay_init(&replay, capture.buf, capture.len, speed_pct);
+    static modem_t m;
+    modem_init(&m, "replay", &replay_port, &replay);
+    modem_probe_start(&m, fake_now_ms());
+    const uint32_t start = fake_now_ms();
+    while (modem_probe_poll(&m, fake_now_ms()) != PROBE_DONE && fake_now_ms() - start < 10000)
+        fake_advance_ms(1);
+    CHECK_EQ(m.state, PROBE_DONE);
+    CHECK(m.info.dev_eui == 0x2CF7F1203230A570ull);
+    return fake_now_ms() - start;
+}
+
+// The gaps between the commands are the firmware's own and are not replayed
+static void test_probe(void) {
+    const uint32_t realtime = probe(REPLAY_REALTIME);
+    CHECK(realtime >= 3 * RESPONSE_MS && realtime <= 3 * RESPONSE_MS + 3);
+    const uint32_t fast = probe(4 * REPLAY_REALTIME);
+    CHECK(fast >= 3 * RESPONSE_MS / 4 && fast <= 3 * RESPONSE_MS / 4 + 3);
+    CHECK(probe(REPLAY_NO_DELAY) <= 3);
+}
+
+int main(void) {
+    RUN(test_realtime);
+    RUN(test_speed);
+    RUN(test_no_delay);
+    RUN(test_waits_for_command);
+    RUN(test_full_ring);
+    RUN(test_probe);
+    return check_result();
+}
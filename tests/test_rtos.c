@@ -0,0 +1,124 @@
+#include <string.h>
+#include "check.h"
+#include "debounce.h"
+#include "fake_freertos.h"
+#include "fake_sdk.h"
+#include "file_storage.h"
+#include "flash_storage.h"
+#include "sim_module.h"
+
+// The tasks of rtos_main.c on the FreeRTOS stand-in (fake/fake_freertos.c),
+// or on the real kernel when built with FREERTOS_KERNEL_PATH, with the module on uart1: its bytes come in through the UART interrupt,
+// which fills the stream buffer and notifies the modem task, and the button
+// press arrives as a task notification from the debounce alarm.
+
+#define SW_0 9
+#define DEV_EUI 0x2CF7F1203230A570ull
+#define IDLE_POLL_MS 10 // rtos_main.c
+
+int rtos_main(void); // rtos_main.c main(), renamed for the host build
+
+static sim_module_t sim;
+static file_storage_t storage;
+static TaskHandle_t modem_task, background_task;
+
+// main.c takes the uplink queue from the flash backend
+const fq_storage_t *flash_storage_get(void) {
+    return &storage.storage;
+}
+
+// One millisecond on the board: the tasks run, then the module and uart1 exchange bytes
+static void run(const uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        fake_rtos_run_ms(1);
+        char out[64];
+        size_t n;
+        while ((n = fake_uart_sent(uart1, out, sizeof(out))) > 0)
+            sim_module_port.write(&sim, out, n);
+        ring_t rx;
+        ring_init(&rx);
+        uint32_t errors = 0;
+        sim_module_port.poll(&sim, &rx, &errors);
+        uint8_t byte;
+        while (ring_get(&rx, &byte))
+            fake_uart_receive(uart1, &byte, 1);
+    }
+}
+
+static void click(void) {
+    fake_gpio_drive(SW_0, false);
+    run(80);
+    fake_gpio_drive(SW_0, true);
+}
+
+// The modem task gets its own core and the higher priority
+static void test_tasks(void) {
+    CHECK(modem_task != NULL);
+    CHECK(background_task != NULL);
+    CHECK_EQ(fake_rtos_affinity(modem_task), 1u << 1);
+    CHECK_EQ(fake_rtos_affinity(background_task), 1u << 0);
+    CHECK(fake_rtos_priority(modem_task) > fake_rtos_priority(background_task));
+}
+
+// With nothing to do both tasks sleep between their periods
+static void test_idle(void) {
+    run(100);
+    const uint32_t modem_before = fake_rtos_wakeups(modem_task);
+    const uint32_t background_before = fake_rtos_wakeups(background_task);
+    run(1000);
+    const uint32_t modem = fake_rtos_wakeups(modem_task) - modem_before;
+    const uint32_t background = fake_rtos_wakeups(background_task) - background_before;
+    CHECK(modem >= 1000 / IDLE_POLL_MS - 10 && modem <= 1000 / IDLE_POLL_MS + 10);
+    CHECK(background >= 90 && background <= 110);
+}
+
+// Each byte from the UART interrupt wakes the modem task right away instead
+// of at its next poll
+static void test_rx_notifies(void) {
+    run(100);
+    const char *banner = "+AT: LoRaWAN modem is ready\r\n";
+    sim_module_say(&sim, banner, 0);
+    const uint32_t before = fake_rtos_wakeups(modem_task);
+    run(strlen(banner) * SIM_BYTE_US / 1000 + 2);
+    CHECK(fake_rtos_wakeups(modem_task) - before >= strlen(banner) - 2);
+}
+
+// A single press notifies the modem task, which runs the probe over uart1
+// and goes back to the idle period once it is done
+static void test_button_probe(void) {
+    run(100);
+    const uint32_t commands = sim.commands;
+    click();
+    run(DOUBLE_PRESS_MS + 40);
+    CHECK(sim.commands > commands);
+    uint32_t ms = 0;
+    while (sim.commands < commands + PROBE_STEPS && ms < 2000) {
+        run(1);
+        ms++;
+    }
+    CHECK_EQ(sim.commands, commands + PROBE_STEPS);
+    CHECK(strcmp(sim.last_cmd, "AT+ID=DevEui") == 0);
+    run(100); // Answer to the last command
+    const uint32_t before = fake_rtos_wakeups(modem_task);
+    run(200);
+    CHECK(fake_rtos_wakeups(modem_task) - before <= 200 / IDLE_POLL_MS + 2);
+    CHECK(ms < 3 * PROBE_TIMEOUT_MS);
+}
+
+static void tests(void) {
+    modem_task = fake_rtos_task("modem");
+    background_task = fake_rtos_task("background");
+    RUN(test_tasks);
+    RUN(test_idle);
+    RUN(test_rx_notifies);
+    RUN(test_button_probe);
+}
+
+int main(int argc, char *argv[]) {
+    fake_sdk_reset();
+    CHECK(file_storage_open(&storage, argc > 1 ? argv[1] : "rtos_queue.bin", FLASH_STORAGE_SECTORS, true));
+    sim_module_init(&sim, DEV_EUI);
+    fake_rtos_start(rtos_main, tests);
+    file_storage_close(&storage);
+    return check_result();
+}
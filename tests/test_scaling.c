@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include "check.h"
+#include "fake_sdk.h"
+#include "modem.h"
+#include "sim_module.h"
+
+// N simulated modules probed from one loop, the way poll_modems() drives the
+// jig: each module has its own ring and probe engine, so the modules work in
+// parallel and devices per minute grow with N. One module that does not
+// answer must not hold up the others.
+
+#define MAX_MODULES 12 // Two hardware UARTs plus more PIO channels than the chip has
+#define ROUNDS 10 // Probes per module, back to back
+#define POLL_MS 1 // REACTOR_BUSY_SLEEP_MS
+
+static sim_module_t sims[MAX_MODULES];
+static modem_t modems[MAX_MODULES];
+static const char *const names[MAX_MODULES] = { "m0", "m1", "m2", "m3", "m4", "m5", "m6", "m7", "m8", "m9", "m10", "m11" };
+
+static void setup(const int n) {
+    fake_sdk_reset();
+    fake_advance_ms(1000);
+    for (int i = 0; i < n; i++) {
+        sim_module_init(&sims[i], 0x2CF7F12032300000ull + (uint64_t)i);
+        sim_module_attach(&sims[i], &modems[i], names[i]);
+    }
+}
+
+// Every module is probed ROUNDS times, a new probe starts as soon as the
+// previous one finished. Returns successful probes, *elapsed_ms the time taken.
+static uint32_t run(const int n, uint32_t *elapsed_ms, uint32_t done[]) {
+    const uint32_t start = fake_now_ms();
+    uint32_t rounds[MAX_MODULES] = { 0 };
+    uint32_t ok = 0;
+    for (int i = 0; i < n; i++) {
+        done[i] = 0;
+        modem_probe_start(&modems[i], start);
+    }
+    bool busy = true;
+    while (busy) {
+        fake_advance_ms(POLL_MS);
+        const uint32_t now = fake_now_ms();
+        busy = false;
+        for (int i = 0; i < n; i++) {
+            modem_t *m = &modems[i];
+            const probe_state_t state = modem_probe_poll(m, now);
+            if (state == PROBE_DONE || state == PROBE_FAILED) {
+                if (state == PROBE_DONE && m->info.dev_eui == sims[i].dev_eui) {
+                    ok++;
+                    done[i]++;
+                }
+                m->state = PROBE_IDLE;
+                if (++rounds[i] < ROUNDS)
+                    modem_probe_start(m, now);
+            }
+            busy |= modem_busy(m);
+        }
+    }
+    *elapsed_ms = fake_now_ms() - start;
+    return ok;
+}
+
+static void test_scaling(void) {
+    static const int counts[] = { 1, 2, 4, 8, MAX_MODULES };
+    uint32_t done[MAX_MODULES];
+    double single_rate = 0;
+    for (size_t c = 0; c < count_of(counts); c++) {
+        const int n = counts[c];
+        setup(n);
+        uint32_t elapsed;
+        const uint32_t ok = run(n, &elapsed, done);
+        CHECK_EQ(ok, (uint32_t)n * ROUNDS);
+        const double per_minute = ok * 60000.0 / elapsed;
+        if (n == 1)
+            single_rate = per_minute;
+        printf("  %2d modules: %3u probes in %5u ms, %6.1f devices/min, %.2fx one module\n", n, (unsigned)ok,
+            (unsigned)elapsed, per_minute, per_minute / single_rate);
+        // Parallel: N modules take about as long as one
+        CHECK(per_minute >= single_rate * n * 0.9);
+    }
+}
+
+// An empty slot runs out its AT retries while the other modules keep going
+static void test_absent_module(void) {
+    const int n = 4;
+    setup(n);
+    uint32_t elapsed_all;
+    uint32_t done[MAX_MODULES];
+    run(n, &elapsed_all, done);
+    setup(n);
+    sims[2].fault = SIM_ABSENT;
+    uint32_t elapsed;
+    const uint32_t ok = run(n, &elapsed, done);
+    CHECK_EQ(ok, (uint32_t)(n - 1) * ROUNDS);
+    CHECK_EQ(done[2], 0);
+    CHECK_EQ(done[0], ROUNDS);
+    CHECK_EQ(modems[2].timeouts, ROUNDS * PROBE_AT_ATTEMPTS);
+    // The healthy modules finished their rounds in the same time as before
+    CHECK_EQ(modems[0].finished_ms - 1000, elapsed_all);
+}
+
+int main(void) {
+    RUN(test_scaling);
+    RUN(test_absent_module);
+    return check_result();
+}
@@ -0,0 +1,198 @@
+#include <string.h>
+#include "check.h"
+#include "fake_sdk.h"
+#include "modem.h"
+
+// Flow control between the hardware UART and its module (modem_set_flow in
+// modem.c) on the fake SDK's uart1. The module keeps sending until it is told
+// to stop: with RTS/CTS the UART holds it off once the RX FIFO is full, with
+// XON/XOFF it stops a few bytes after an XOFF. The receive buffer must pause it
+// at MODEM_RX_HIGH_WATER, let it go on at MODEM_RX_LOW_WATER and lose nothing.
+
+#define TX_PIN 4
+#define RX_PIN 5
+#define CTS_PIN 6
+#define RTS_PIN 7
+#define DATA_LEN 1000
+#define IN_FLIGHT 8 // Bytes the module still sends after an XOFF
+
+static modem_t modem;
+static uint8_t data[DATA_LEN];
+static size_t sent; // Bytes of data the module got out
+static size_t received;
+
+static void setup(const modem_flow_t flow) {
+    fake_sdk_reset();
+    modem_init_uart(&modem, "uart1", uart1, TX_PIN, RX_PIN, 9600);
+    CHECK(modem_set_flow(&modem, flow, CTS_PIN, RTS_PIN));
+    // Printable, so none of it is XON or XOFF
+    for (int i = 0; i < DATA_LEN; i++)
+        data[i] = (uint8_t)('A' + i % 26);
+    sent = 0;
+    received = 0;
+}
+
+// Module with RTS/CTS: sends while the UART asserts RTS, i.e. the FIFO has room
+static void module_send_rts(void) {
+    while (sent < DATA_LEN && fake_uart_fifo_level(uart1) < FAKE_UART_FIFO)
+        fake_uart_receive(uart1, &data[sent++], 1);
+}
+
+// One byte through the driver, checked against what the module sent
+static bool take(void) {
+    char c;
+    if (!modem_getc(&modem, &c, 0))
+        return false;
+    CHECK_EQ((uint8_t)c, data[received]);
+    received++;
+    return true;
+}
+
+static size_t take_sent(char *out, const size_t max) {
+    return fake_uart_sent(uart1, out, max);
+}
+
+// The interrupt is masked at the high watermark and the FIFO fills up behind
+// it; at the low watermark it is unmasked and the FIFO is emptied at once
+static void test_rts_cts(void) {
+    setup(MODEM_FLOW_RTS_CTS);
+    module_send_rts();
+    CHECK(modem.throttled);
+    CHECK_EQ(modem.throttles, 1);
+    CHECK(!fake_uart_rx_irq_enabled(uart1));
+    CHECK_EQ(ring_count(&modem.rx), MODEM_RX_HIGH_WATER);
+    CHECK_EQ(fake_uart_fifo_level(uart1), FAKE_UART_FIFO);
+    CHECK_EQ(sent, MODEM_RX_HIGH_WATER + FAKE_UART_FIFO);
+
+    while (modem.throttled) {
+        CHECK(ring_count(&modem.rx) >= MODEM_RX_LOW_WATER);
+        CHECK(take());
+    }
+    CHECK(fake_uart_rx_irq_enabled(uart1));
+    CHECK_EQ(fake_uart_fifo_level(uart1), 0);
+    CHECK_EQ(ring_count(&modem.rx), MODEM_RX_LOW_WATER - 1 + FAKE_UART_FIFO);
+
+    // The rest of the stream, the module sending whenever it may
+    for (int guard = 0; received < DATA_LEN && guard < 10 * DATA_LEN; guard++) {
+        module_send_rts();
+        take();
+    }
+    CHECK_EQ(received, DATA_LEN);
+    CHECK(modem.throttles > 1);
+    CHECK_EQ(modem.rx.overruns, 0);
+    CHECK_EQ(modem.fifo_overruns, 0);
+}
+
+// XOFF goes out when the buffer reaches the high watermark, bytes already on
+// their way are still taken, and XON goes out at the low watermark
+static void test_xon_xoff(void) {
+    setup(MODEM_FLOW_XON_XOFF);
+    char out[16];
+    size_t after_xoff = 0;
+    bool stopped = false;
+    while (!stopped && sent < DATA_LEN) {
+        fake_uart_receive(uart1, &data[sent++], 1);
+        const size_t n = take_sent(out, sizeof(out));
+        if (n > 0) {
+            CHECK_EQ(n, 1);
+            CHECK_EQ(out[0], MODEM_XOFF);
+            CHECK_EQ(ring_count(&modem.rx), MODEM_RX_HIGH_WATER);
+            after_xoff = 1;
+        }
+        else if (after_xoff > 0 && ++after_xoff > IN_FLIGHT)
+            stopped = true;
+    }
+    CHECK(stopped);
+    CHECK(modem.throttled);
+    CHECK(fake_uart_rx_irq_enabled(uart1));
+    CHECK_EQ(ring_count(&modem.rx), MODEM_RX_HIGH_WATER + IN_FLIGHT);
+
+    while (true) {
+        const uint16_t level = ring_count(&modem.rx);
+        CHECK(take());
+        if (take_sent(out, sizeof(out)) > 0) {
+            CHECK_EQ(out[0], MODEM_XON);
+            CHECK_EQ(level, MODEM_RX_LOW_WATER);
+            break;
+        }
+        CHECK(level > MODEM_RX_LOW_WATER);
+    }
+    CHECK(!modem.throttled);
+    while (sent < DATA_LEN) {
+        fake_uart_receive(uart1, &data[sent++], 1);
+        take();
+    }
+    while (take()) {}
+    CHECK_EQ(received, DATA_LEN);
+    CHECK_EQ(modem.rx.overruns, 0);
+}
+
+static size_t sent_while_paused;
+
+static int64_t send_xon(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    char out[16];
+    sent_while_paused = take_sent(out, sizeof(out));
+    const uint8_t xon = MODEM_XON;
+    fake_uart_receive(uart1, &xon, 1);
+    return 0;
+}
+
+// XOFF from the module holds our writes until its XON, and the flow
+// characters are not handed on as received data
+static void test_xoff_pauses_writes(void) {
+    setup(MODEM_FLOW_XON_XOFF);
+    const uint8_t xoff = MODEM_XOFF;
+    fake_uart_receive(uart1, &xoff, 1);
+    CHECK(modem.tx_paused);
+    CHECK_EQ(modem.tx_pauses, 1);
+    sent_while_paused = 99;
+    add_alarm_in_ms(100, send_xon, NULL, true);
+    const uint32_t start = fake_now_ms();
+    modem_write_str(&modem, "AT\r\n");
+    CHECK_EQ(fake_now_ms() - start, 100);
+    CHECK_EQ(sent_while_paused, 0);
+    char out[16];
+    CHECK_EQ(take_sent(out, sizeof(out)), 4);
+    CHECK(memcmp(out, "AT\r\n", 4) == 0);
+    CHECK(!modem.tx_paused);
+    char c;
+    CHECK(!modem_getc(&modem, &c, 0));
+}
+
+// An XON that never comes: writing goes on after MODEM_XOFF_TIMEOUT_MS
+static void test_xoff_timeout(void) {
+    setup(MODEM_FLOW_XON_XOFF);
+    const uint8_t xoff = MODEM_XOFF;
+    fake_uart_receive(uart1, &xoff, 1);
+    const uint32_t start = fake_now_ms();
+    modem_write_str(&modem, "AT+VER\r\n");
+    const uint32_t waited = fake_now_ms() - start;
+    CHECK(waited >= MODEM_XOFF_TIMEOUT_MS && waited <= MODEM_XOFF_TIMEOUT_MS + 1);
+    char out[16];
+    CHECK_EQ(take_sent(out, sizeof(out)), 8);
+    CHECK(memcmp(out, "AT+VER\r\n", 8) == 0);
+    CHECK(!modem.tx_paused);
+}
+
+// Without flow control nothing is paused: bytes past the ring's size are dropped and counted
+static void test_no_flow(void) {
+    setup(MODEM_FLOW_NONE);
+    for (sent = 0; sent < RING_SIZE + 10; sent++)
+        fake_uart_receive(uart1, &data[sent], 1);
+    CHECK(!modem.throttled);
+    CHECK_EQ(modem.throttles, 0);
+    char out[16];
+    CHECK_EQ(take_sent(out, sizeof(out)), 0);
+    CHECK_EQ(modem.rx.overruns, 10 + 1); // The ring holds RING_SIZE - 1
+}
+
+int main(void) {
+    RUN(test_rts_cts);
+    RUN(test_xon_xoff);
+    RUN(test_xoff_pauses_writes);
+    RUN(test_xoff_timeout);
+    RUN(test_no_flow);
+    return check_result();
+}
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Compare benchmark results against a stored baseline.
+
+The benchmark firmware and its host build (tests/bench_host.c) print one
+JSON document per run (see bench.h). Pass the captured console output or a
+file holding just the JSON:
+
+    tools/bench_compare.py run.log                      # compare with tools/bench_baseline.json
+    tools/bench_compare.py run.log --threshold 5        # flag cases more than 5 % slower
+    tools/bench_compare.py run.log --update             # store this run as the new baseline
+    tools/bench_compare.py run.log --floors-only        # only the throughput floors, for noisy machines
+
+A baseline entry may also carry a hard throughput floor, "min_mb_per_s",
+for the parsers whose hardening must not cost speed. Floors are kept when
+the baseline is updated.
+
+tools/bench_baseline.json holds the figures of the host build, from the best
+of several runs ("cmake --build <dir> --target bench" in the tests project
+runs and compares). Firmware results are in CPU cycles of a different
+machine, so keep a baseline per board and pass it with --baseline.
+
+Exits with status 1 when any case regressed, so it can gate a CI job.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "bench_baseline.json")
+
+
+def load_results(path):
+    """Last benchmark JSON document found in the file."""
+    document = None
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith('{"clock_hz"'):
+                document = json.loads(line)
+    if document is None:
+        sys.exit(f"{path}: no benchmark results found")
+    return {r["name"]: r for r in document["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("results", help="console log or JSON file from the benchmark firmware")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE, help="baseline JSON (default: %(default)s)")
+    parser.add_argument("--threshold", type=float, default=10.0, help="allowed slowdown in percent (default: %(default)s)")
+    parser.add_argument("--update", action="store_true", help="write the results as the new baseline")
+    parser.add_argument("--floors-only", action="store_true", help="check the min_mb_per_s floors, not the slowdown")
+    args = parser.parse_args()
+
+    results = load_results(args.results)
+
+    if args.update:
+        old = {}
+        if os.path.exists(args.baseline):
+            with open(args.baseline, encoding="utf-8") as f:
+                old = json.load(f)
+        baseline = {}
+        for name, r in sorted(results.items()):
+            baseline[name] = {"ns_per_iter": r["ns_per_iter"]}
+            if "min_mb_per_s" in old.get(name, {}):
+                baseline[name]["min_mb_per_s"] = old[name]["min_mb_per_s"]
+        with open(args.baseline, "w", encoding="utf-8") as f:
+            json.dump(baseline, f, indent=2)
+            f.write("\n")
+        print(f"Baseline updated: {len(baseline)} cases")
+        return 0
+
+    if not os.path.exists(args.baseline):
+        sys.exit(f"{args.baseline} does not exist, create it with --update")
+    with open(args.baseline, encoding="utf-8") as f:
+        baseline = json.load(f)
+
+    regressions = 0
+    print(f"{'case':<20} {'baseline':>12} {'now':>12} {'change':>8}")
+    for name, r in results.items():
+        now = r["ns_per_iter"]
+        if name not in baseline:
+            print(f"{name:<20} {'-':>12} {now:>10.1f}ns {'new':>8}")
+            continue
+        old = baseline[name]["ns_per_iter"]
+        change = (now - old) / old * 100 if old else 0.0
+        flag = ""
+        if change > args.threshold and not args.floors_only:
+            flag = "  REGRESSION"
+            regressions += 1
+        floor = baseline[name].get("min_mb_per_s")
+        if floor is not None and r.get("mb_per_s", 0.0) < floor:
+            flag += f"  BELOW FLOOR {r.get('mb_per_s', 0.0):.1f} < {floor:.1f} MB/s"
+            regressions += 1
+        print(f"{name:<20} {old:>10.1f}ns {now:>10.1f}ns {change:>+7.1f}%{flag}")
+    for name in baseline:
+        if name not in results:
+            print(f"{name:<20} missing from results")
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""Decode and replay uart1 traffic captures (LORA_CAPTURE, see capture.h).
+
+Save the console output of "capture dump" and pass the log file:
+
+    tools/capture_replay.py show run.log                        # transcript with timestamps
+    tools/capture_replay.py c-header run.log -o field.h         # for LORA_BENCH_CAPTURE (replay_probe case)
+    tools/capture_replay.py play run.log --port /dev/ttyUSB0    # act as the module, original timing
+    tools/capture_replay.py play run.log --port /dev/ttyUSB0 --speed 10
+
+"play" drives a serial adapter wired to the board's uart1 pins (GP4/GP5) in
+place of the module. Received records are sent with their recorded gaps
+divided by --speed (0 sends without waiting). At each transmit record it
+waits until the firmware has sent at least as many bytes as it had at that
+point of the capture, as the replay in the benchmark does, so responses never
+run ahead of the commands they answer. Exits with status 1 when the firmware
+falls silent (--timeout).
+"""
+
+import argparse
+import os
+import select
+import sys
+import termios
+import time
+
+RX = 0 # Received from the module
+TX = 1 # Sent to the module
+
+
+def load_capture(path):
+    """Log bytes of the last dump found in the file."""
+    data = None
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("CAPTURE BEGIN"):
+                data = bytearray()
+                expected = int(line.split()[2])
+            elif line.startswith("CAP ") and data is not None:
+                data += bytes.fromhex(line[4:])
+            elif line == "CAPTURE END" and data is not None:
+                if len(data) != expected:
+                    sys.exit(f"{path}: dump has {len(data)} bytes, header says {expected}")
+                return bytes(data)
+    sys.exit(f"{path}: no complete capture dump found")
+
+
+def varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise ValueError("truncated record")
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def records(data):
+    """(direction, delta_us, payload) in capture order, stops at a truncated record like capture_next()."""
+    pos = 0
+    while pos < len(data):
+        try:
+            header, p = varint(data, pos)
+            length, p = varint(data, p)
+        except ValueError:
+            return
+        if p + length > len(data):
+            return
+        yield header & 1, header >> 1, data[p:p + length]
+        pos = p + length
+
+
+def printable(payload):
+    return payload.decode("ascii", errors="backslashreplace").replace("\r", "\\r").replace("\n", "\\n")
+
+
+def show(data):
+    t = 0
+    sent = received = count = 0
+    for direction, delta, payload in records(data):
+        t += delta
+        count += 1
+        if direction == TX:
+            sent += len(payload)
+        else:
+            received += len(payload)
+        arrow = ">>" if direction == TX else "<<"
+        print(f"{t / 1000:12.3f} ms {arrow} {printable(payload)}")
+    print(f"{count} records over {t / 1e6:.3f} s, {sent} bytes to the module, {received} from it")
+
+
+def c_header(data, out):
+    lines = ["// Generated by tools/capture_replay.py c-header, replayed by the replay_probe bench case",
+             "static const uint8_t bench_capture[] = {"]
+    for i in range(0, len(data), 16):
+        lines.append("    " + " ".join(f"0x{b:02X}," for b in data[i:i + 16]))
+    lines.append("};")
+    out.write("\n".join(lines) + "\n")
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = attrs[1] = attrs[3] = 0 # Raw: no input, output or local processing
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    speed = getattr(termios, f"B{baud}", None)
+    if speed is None:
+        sys.exit(f"unsupported baud rate {baud}")
+    attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def play(data, port, baud, speed, timeout):
+    fd = open_port(port, baud)
+    written = 0 # Bytes the firmware sent during the replay
+    expected = 0 # Bytes it had sent at the current point of the capture
+    start = time.monotonic()
+
+    def read_available(wait):
+        nonlocal written
+        ready, _, _ = select.select([fd], [], [], wait)
+        if ready:
+            chunk = os.read(fd, 4096)
+            written += len(chunk)
+            print(f"{(time.monotonic() - start) * 1000:12.3f} ms >> {printable(chunk)}")
+
+    for direction, delta, payload in records(data):
+        if direction == TX:
+            expected += len(payload)
+            deadline = time.monotonic() + timeout
+            while written < expected:
+                if time.monotonic() > deadline:
+                    print(f"firmware sent {written} of {expected} bytes, giving up")
+                    return 1
+                read_available(0.01)
+            continue
+        if speed > 0:
+            due = time.monotonic() + delta / 1e6 / speed
+            while time.monotonic() < due:
+                read_available(max(0.0, due - time.monotonic()))
+        os.write(fd, payload)
+        print(f"{(time.monotonic() - start) * 1000:12.3f} ms << {printable(payload)}")
+    # Whatever the firmware says after the last response
+    end = time.monotonic() + 0.5
+    while time.monotonic() < end:
+        read_available(0.05)
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("show", help="print the transcript")
+    p.add_argument("log")
+    p = sub.add_parser("c-header", help="write the capture as a C array for the benchmark")
+    p.add_argument("log")
+    p.add_argument("-o", "--output", help="header file (default: stdout)")
+    p = sub.add_parser("play", help="play the module side into a serial port")
+    p.add_argument("log")
+    p.add_argument("--port", required=True, help="serial device wired to uart1")
+    p.add_argument("--baud", type=int, default=9600, help="(default: %(default)s)")
+    p.add_argument("--speed", type=float, default=1.0, help="time scale, 0 for no delays (default: %(default)s)")
+    p.add_argument("--timeout", type=float, default=5.0, help="seconds to wait for a command (default: %(default)s)")
+    args = parser.parse_args()
+
+    data = load_capture(args.log)
+    if args.command == "show":
+        show(data)
+    elif args.command == "c-header":
+        if args.output:
+            with open(args.output, "w", encoding="utf-8") as f:
+                c_header(data, f)
+        else:
+            c_header(data, sys.stdout)
+    else:
+        return play(data, args.port, args.baud, args.speed, args.timeout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
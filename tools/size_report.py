@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""Flash and RAM footprint of the firmware ELF, per section and per symbol.
+
+Run by the build (see LORA_FLASH_BUDGET / LORA_RAM_BUDGET in CMakeLists.txt)
+or by hand on any build directory:
+
+    tools/size_report.py build/UART.elf                       # sections, totals, 20 largest symbols
+    tools/size_report.py build/UART.elf --top 50
+    tools/size_report.py build/UART.elf --ram-budget 48k      # exit 1 when static RAM exceeds 48 KiB
+
+Flash counts every loaded section stored in XIP flash, including the copies
+of .data and of the RAM-resident code that the boot code copies to SRAM. RAM
+counts statically allocated SRAM (.data, .bss, scratch banks, RAM code); the
+heap and the stacks are reserved by the linker script and shown separately,
+they do not count against the budget.
+
+Exits with status 1 when a budget is exceeded, so it can fail the build.
+"""
+
+import argparse
+import subprocess
+import sys
+
+FLASH = (0x10000000, 0x11000000) # XIP window
+SRAM = (0x20000000, 0x20042000) # Striped banks plus the two scratch banks
+RESERVED = (".heap", ".stack") # Section name prefixes not counted as static RAM
+
+
+def size_arg(text):
+    """Byte count, optionally with a k/K suffix for KiB."""
+    text = text.strip()
+    if text[-1:] in "kK":
+        return int(text[:-1], 0) * 1024
+    return int(text, 0)
+
+
+def in_range(address, region):
+    return region[0] <= address < region[1]
+
+
+def read_sections(objdump, elf):
+    """(name, size, vma, lma, flags) for every section header."""
+    out = subprocess.run([objdump, "-h", elf], check=True, capture_output=True, text=True).stdout
+    sections = []
+    lines = out.splitlines()
+    for i, line in enumerate(lines):
+        fields = line.split()
+        if len(fields) == 7 and fields[0].isdigit():
+            flags = lines[i + 1].replace(",", " ").split() if i + 1 < len(lines) else []
+            sections.append((fields[1], int(fields[2], 16), int(fields[3], 16), int(fields[4], 16), set(flags)))
+    return sections
+
+
+def read_symbols(nm, elf):
+    """(name, size, address, type) for every symbol with a size."""
+    out = subprocess.run([nm, "-S", "--size-sort", "-C", elf], check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4:
+            symbols.append((fields[3], int(fields[1], 16), int(fields[0], 16), fields[2]))
+    return symbols
+
+
+def print_symbols(title, symbols, top):
+    print(f"\n{title}")
+    print(f"{'size':>8}  {'address':>10}  t  symbol")
+    for name, size, address, kind in sorted(symbols, key=lambda s: -s[1])[:top]:
+        print(f"{size:>8}  {address:>#10x}  {kind}  {name}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="firmware ELF")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump", help="objdump of the toolchain")
+    parser.add_argument("--nm", default="arm-none-eabi-nm", help="nm of the toolchain")
+    parser.add_argument("--top", type=int, default=20, help="largest symbols listed per region (default: %(default)s)")
+    parser.add_argument("--flash-budget", type=size_arg, default=0, help="flash limit in bytes, 0 for none")
+    parser.add_argument("--ram-budget", type=size_arg, default=0, help="static RAM limit in bytes, 0 for none")
+    args = parser.parse_args()
+
+    flash = 0
+    ram = 0
+    reserved = 0
+    print(f"{'section':<24} {'size':>8} {'vma':>10} {'lma':>10}  region")
+    for name, size, vma, lma, flags in read_sections(args.objdump, args.elf):
+        if "ALLOC" not in flags or size == 0:
+            continue
+        regions = []
+        if "LOAD" in flags and in_range(lma, FLASH):
+            flash += size
+            regions.append("flash")
+        if in_range(vma, SRAM):
+            if name.startswith(RESERVED):
+                reserved += size
+                regions.append("reserved")
+            else:
+                ram += size
+                regions.append("ram")
+        print(f"{name:<24} {size:>8} {vma:>#10x} {lma:>#10x}  {'+'.join(regions)}")
+
+    print(f"\nflash {flash} bytes, static ram {ram} bytes, heap and stacks {reserved} bytes")
+
+    if args.top > 0:
+        symbols = read_symbols(args.nm, args.elf)
+        print_symbols("Largest in flash", [s for s in symbols if in_range(s[2], FLASH)], args.top)
+        print_symbols("Largest in RAM", [s for s in symbols if in_range(s[2], SRAM)], args.top)
+
+    over = 0
+    if args.flash_budget and flash > args.flash_budget:
+        print(f"\nFLASH BUDGET EXCEEDED: {flash} > {args.flash_budget} bytes")
+        over += 1
+    if args.ram_budget and ram > args.ram_budget:
+        print(f"\nRAM BUDGET EXCEEDED: {ram} > {args.ram_budget} bytes")
+        over += 1
+    return 1 if over else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())